@@ -0,0 +1,265 @@
+/*
+  ==============================================================================
+
+    DualFilterEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "DualFilterEngine.h"
+
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define DUAL_FILTER_ENGINE_FTZ 1
+#else
+ #define DUAL_FILTER_ENGINE_FTZ 0
+#endif
+
+namespace
+{
+    // Flushes denormals while processing, like juce::ScopedNoDenormals
+    struct ScopedNoDenormals
+    {
+       #if DUAL_FILTER_ENGINE_FTZ
+        ScopedNoDenormals() noexcept : previous(_mm_getcsr()) { _mm_setcsr(previous | 0x8040); }
+        ~ScopedNoDenormals() noexcept { _mm_setcsr(previous); }
+
+        unsigned int previous;
+       #endif
+    };
+}
+
+//==============================================================================
+DualFilterEngine::DualFilterEngine(double newSampleRate) : sampleRate(newSampleRate)
+{
+    for( int i = 0; i < numEngineParameters; ++i )
+        parameters[i].store(chainParameterTable[i].defaultValue);
+
+    control.prepare(sampleRate);
+
+    reset();
+}
+
+void DualFilterEngine::reset()
+{
+    auto chainSettings = loadSettings();
+
+    control.setCurrentSettings(chainSettings);
+
+    peakChain2.reset();
+    peakChain4.reset();
+    peakChain8.reset();
+
+    morphChain2.reset();
+    morphChain4.reset();
+    morphChain8.reset();
+
+    saturator.reset();
+
+    selectChain(chainSettings);
+    updateSaturator(chainSettings, 0);
+
+    control.triggerControlTick();
+}
+
+int DualFilterEngine::findParameter(const char* id) noexcept
+{
+    if( id == nullptr )
+        return -1;
+
+    for( int i = 0; i < numEngineParameters; ++i )
+        if( std::strcmp(chainParameterTable[i].id, id) == 0 )
+            return i;
+
+    return -1;
+}
+
+void DualFilterEngine::setParameter(int index, float value) noexcept
+{
+    if( index < 0 || index >= numEngineParameters || value != value )
+        return;
+
+    auto& info = chainParameterTable[index];
+    auto snapped = info.minimum + info.interval * std::round((value - info.minimum) / info.interval);
+
+    parameters[index].store(std::min(std::max(snapped, info.minimum), info.maximum));
+}
+
+float DualFilterEngine::getParameter(int index) const noexcept
+{
+    return index >= 0 && index < numEngineParameters ? parameters[index].load() : 0.f;
+}
+
+ChainSettings DualFilterEngine::loadSettings() const noexcept
+{
+    auto settings = makeChainSettings([this](int index)
+    {
+        return index < numEngineParameters ? parameters[index].load() : chainParameterTable[index].defaultValue;
+    });
+
+    // Without snapshots A/B MORPH changes nothing, so it mustn't keep the chain redesigning
+    settings.snapshotMorph = 0.f;
+
+    return settings;
+}
+
+void DualFilterEngine::updateTargets() noexcept
+{
+    auto chainSettings = loadSettings();
+
+    control.setTargetSettings(chainSettings);
+
+    if( chainSettings.numPeaks != numPeaks )
+        selectChain(control.getCurrentSettings());
+}
+
+void DualFilterEngine::selectChain(const ChainSettings& chainSettings) noexcept
+{
+    // A newly selected chain starts from silence instead of its stale state
+    morphActive = usesMorphCore(chainSettings);
+
+    withPeakChain(chainSettings.numPeaks, [&](auto& chain)
+    {
+        chain.reset();
+        chain.updateCoefficients(chainSettings, sampleRate);
+
+        // The make-up gain needs the new design
+        auto& coefficients = chain.getCoefficients();
+        chain.setGainLinear(control.getChainGainLinear(chainSettings, coefficients.data(), (int) coefficients.size()));
+    });
+
+    numPeaks = chainSettings.numPeaks;
+}
+
+void DualFilterEngine::rampChain(const ChainSettings& chainSettings, int numSamples) noexcept
+{
+    selectMorphCore(usesMorphCore(chainSettings));
+
+    withPeakChain(numPeaks, [&](auto& chain)
+    {
+        control.rampChain(chain, chain.makeCoefficients(chainSettings, sampleRate), chainSettings, numSamples);
+    });
+
+    updateSaturator(chainSettings, numSamples);
+}
+
+void DualFilterEngine::updateSaturator(const ChainSettings& chainSettings, int numSamples) noexcept
+{
+    control.updateSaturator(chainSettings, numSamples, [this](auto&& process) { process(saturator); });
+}
+
+void DualFilterEngine::selectMorphCore(bool shouldMorph) noexcept
+{
+    if( shouldMorph == morphActive )
+        return;
+
+    switch( numPeaks )
+    {
+        case 4:  handOverMorphCore(peakChain4, morphChain4, shouldMorph); break;
+        case 8:  handOverMorphCore(peakChain8, morphChain8, shouldMorph); break;
+        default: handOverMorphCore(peakChain2, morphChain2, shouldMorph); break;
+    }
+
+    morphActive = shouldMorph;
+}
+
+void DualFilterEngine::processPlanar(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    ScopedNoDenormals noDenormals;
+
+    numChannels = std::min(numChannels, maxChannels);
+
+    // Parameters are read once per call, like the plugin does per host block
+    updateTargets();
+
+    for( int start = 0; start < numSamples; )
+    {
+        if( control.isControlTickDue() )
+        {
+            if( control.needsDesign() )
+                rampChain(control.skip(controlInterval), controlInterval);
+
+            control.finishControlTick(controlInterval);
+        }
+
+        auto numChunkSamples = std::min(numSamples - start, control.getSamplesUntilControlTick());
+
+        float* chunk[maxChannels] {};
+
+        for( int ch = 0; ch < numChannels; ++ch )
+            chunk[ch] = channels[ch] + start;
+
+        withPeakChain(numPeaks, [&](auto& chain)
+        {
+            chain.process(chunk, numChannels, numChunkSamples);
+        });
+
+        if( control.isSaturatorActive() )
+            saturator.process(chunk, numChannels, numChunkSamples);
+
+        start += numChunkSamples;
+        control.advance(numChunkSamples);
+    }
+}
+
+void DualFilterEngine::processInterleaved(float* samples, int numChannels, int numFrames) noexcept
+{
+    // Deinterleaved through a fixed scratch buffer, a block at a time
+    numChannels = std::min(numChannels, maxChannels);
+
+    float* channels[maxChannels] { scratch[0], scratch[1] };
+
+    for( int start = 0; start < numFrames; start += interleaveBlockSize )
+    {
+        auto numChunkFrames = std::min(numFrames - start, interleaveBlockSize);
+        auto* frames = samples + start * numChannels;
+
+        for( int i = 0; i < numChunkFrames; ++i )
+            for( int ch = 0; ch < numChannels; ++ch )
+                scratch[ch][i] = frames[i * numChannels + ch];
+
+        processPlanar(channels, numChannels, numChunkFrames);
+
+        for( int i = 0; i < numChunkFrames; ++i )
+            for( int ch = 0; ch < numChannels; ++ch )
+                frames[i * numChannels + ch] = scratch[ch][i];
+    }
+}
+
+//==============================================================================
+void DualFilterEngine::getState(StateData& state) const noexcept
+{
+    state = StateData();
+    state.numParameters = (std::uint32_t) numEngineParameters;
+
+    for( int i = 0; i < numEngineParameters; ++i )
+        state.values[i] = parameters[i].load();
+}
+
+bool DualFilterEngine::setState(const void* data, size_t sizeInBytes) noexcept
+{
+    // Same acceptance rules as SimpleDualFilterAudioProcessor::setStateInformation,
+    // without the fallback to the old ValueTree format
+    constexpr auto version1Size = offsetof(StateData, linkGroup);
+
+    if( data == nullptr || sizeInBytes < version1Size )
+        return false;
+
+    StateData state;
+    std::memcpy(&state, data, std::min(sizeof(StateData), sizeInBytes));
+
+    auto requiredSize = state.version >= 2 ? sizeof(StateData) : version1Size;
+
+    if( state.magic != StateData::magicNumber || state.version > StateData::currentVersion || sizeInBytes < requiredSize )
+        return false;
+
+    // Parameters that did not exist when the values were stored go back to their defaults
+    auto numValues = (int) std::min(state.numParameters, (std::uint32_t) StateData::maxParameters);
+
+    for( int i = 0; i < numEngineParameters; ++i )
+        setParameter(i, i < numValues ? state.values[i] : chainParameterTable[i].defaultValue);
+
+    return true;
+}
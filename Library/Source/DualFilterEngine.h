@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    DualFilterEngine.h
+
+    The DSP of SimpleDualFilterAudioProcessor without JUCE: PeakChain and
+    MorphChain, Auto Gain and the Saturator after them, driven by the plugin's
+    own control logic in Source/ChainControl.h, for processing audio outside
+    a plugin host. Only the standard library is used.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "../../Source/ChainControl.h"
+#include "../../Source/StateData.h"
+
+// The engine implements the parameters of chainParameterTable up to Auto Gain. Key Track
+// and Pitch Track need MIDI and a sidechain, which it has no inputs for. A/B Morph is kept
+// with the state, without snapshots it has no effect.
+constexpr int numEngineParameters = 13;
+
+static_assert(numEngineParameters <= numChainParameters, "More engine parameters than the plugin has");
+static_assert(numEngineParameters <= StateData::maxParameters, "StateData holds too few values");
+
+//==============================================================================
+class DualFilterEngine
+{
+public:
+    static constexpr int maxChannels = PeakChain<2>::maxChannels;
+    static constexpr int controlInterval = 32;
+
+    explicit DualFilterEngine(double sampleRate);
+
+    // Clears the filter state and jumps to the current parameter values
+    void reset();
+
+    // Index into chainParameterTable, or -1 for a parameter the engine doesn't implement
+    static int findParameter(const char* id) noexcept;
+
+    // Values are clamped to the range and snapped to the interval like the plugin's
+    // parameters. May be called from another thread than the processing.
+    void setParameter(int index, float value) noexcept;
+    float getParameter(int index) const noexcept;
+
+    // In place, up to maxChannels channels, no allocation
+    void processPlanar(float* const* channels, int numChannels, int numSamples) noexcept;
+    void processInterleaved(float* samples, int numChannels, int numFrames) noexcept;
+
+    // StateData with the parameter values, the snapshots and link group stay empty
+    void getState(StateData& state) const noexcept;
+
+    // Accepts state saved by the plugin or by getState(), false if it isn't one
+    bool setState(const void* data, size_t sizeInBytes) noexcept;
+
+private:
+    double sampleRate;
+
+    std::atomic<float> parameters[numEngineParameters];
+
+    ChainControl control;
+    int numPeaks { 2 };
+    bool morphActive { false };
+
+    PeakChain<2> peakChain2;
+    PeakChain<4> peakChain4;
+    PeakChain<8> peakChain8;
+
+    MorphChain<2> morphChain2;
+    MorphChain<4> morphChain4;
+    MorphChain<8> morphChain8;
+
+    Saturator<float> saturator;
+
+    static constexpr int interleaveBlockSize = 256;
+    float scratch[maxChannels][interleaveBlockSize] {};
+
+    ChainSettings loadSettings() const noexcept;
+    void updateTargets() noexcept;
+    void selectChain(const ChainSettings& chainSettings) noexcept;
+    void rampChain(const ChainSettings& chainSettings, int numSamples) noexcept;
+    void selectMorphCore(bool shouldMorph) noexcept;
+    void updateSaturator(const ChainSettings& chainSettings, int numSamples) noexcept;
+
+    template <typename Callback>
+    void withPeakChain(int numPeaksToUse, Callback&& callback)
+    {
+        if( morphActive )
+        {
+            switch( numPeaksToUse )
+            {
+                case 4:  callback(morphChain4); break;
+                case 8:  callback(morphChain8); break;
+                default: callback(morphChain2); break;
+            }
+
+            return;
+        }
+
+        switch( numPeaksToUse )
+        {
+            case 4:  callback(peakChain4); break;
+            case 8:  callback(peakChain8); break;
+            default: callback(peakChain2); break;
+        }
+    }
+};
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    SimpleDualFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "SimpleDualFilter.h"
+#include "DualFilterEngine.h"
+
+#include <cstring>
+#include <new>
+
+struct sdf_filter
+{
+    explicit sdf_filter(double sampleRate) : engine(sampleRate) {}
+
+    DualFilterEngine engine;
+};
+
+sdf_filter* sdf_create(double sample_rate)
+{
+    if( ! (sample_rate > 0.0) )
+        return nullptr;
+
+    return new (std::nothrow) sdf_filter(sample_rate);
+}
+
+void sdf_destroy(sdf_filter* filter)
+{
+    delete filter;
+}
+
+void sdf_reset(sdf_filter* filter)
+{
+    if( filter != nullptr )
+        filter->engine.reset();
+}
+
+int sdf_get_num_parameters(void)
+{
+    return numEngineParameters;
+}
+
+const char* sdf_get_parameter_id(int index)
+{
+    return index >= 0 && index < numEngineParameters ? chainParameterTable[index].id : nullptr;
+}
+
+int sdf_get_parameter_range(int index, float* minimum, float* maximum, float* default_value)
+{
+    if( index < 0 || index >= numEngineParameters )
+        return SDF_ERROR_UNKNOWN_PARAMETER;
+
+    auto& info = chainParameterTable[index];
+
+    if( minimum != nullptr )        *minimum = info.minimum;
+    if( maximum != nullptr )        *maximum = info.maximum;
+    if( default_value != nullptr )  *default_value = info.defaultValue;
+
+    return SDF_OK;
+}
+
+int sdf_set_parameter(sdf_filter* filter, const char* id, float value)
+{
+    if( filter == nullptr )
+        return SDF_ERROR_INVALID_ARGUMENT;
+
+    auto index = DualFilterEngine::findParameter(id);
+
+    if( index < 0 )
+        return SDF_ERROR_UNKNOWN_PARAMETER;
+
+    filter->engine.setParameter(index, value);
+    return SDF_OK;
+}
+
+int sdf_get_parameter(const sdf_filter* filter, const char* id, float* value)
+{
+    if( filter == nullptr || value == nullptr )
+        return SDF_ERROR_INVALID_ARGUMENT;
+
+    auto index = DualFilterEngine::findParameter(id);
+
+    if( index < 0 )
+        return SDF_ERROR_UNKNOWN_PARAMETER;
+
+    *value = filter->engine.getParameter(index);
+    return SDF_OK;
+}
+
+int sdf_process_planar(sdf_filter* filter, float* const* channels, int num_channels, int num_samples)
+{
+    if( filter == nullptr || channels == nullptr || num_channels < 1 || num_channels > DualFilterEngine::maxChannels || num_samples < 0 )
+        return SDF_ERROR_INVALID_ARGUMENT;
+
+    for( int ch = 0; ch < num_channels; ++ch )
+        if( channels[ch] == nullptr )
+            return SDF_ERROR_INVALID_ARGUMENT;
+
+    filter->engine.processPlanar(channels, num_channels, num_samples);
+    return SDF_OK;
+}
+
+int sdf_process_interleaved(sdf_filter* filter, float* samples, int num_channels, int num_frames)
+{
+    if( filter == nullptr || samples == nullptr || num_channels < 1 || num_channels > DualFilterEngine::maxChannels || num_frames < 0 )
+        return SDF_ERROR_INVALID_ARGUMENT;
+
+    filter->engine.processInterleaved(samples, num_channels, num_frames);
+    return SDF_OK;
+}
+
+size_t sdf_get_state_size(void)
+{
+    return sizeof(StateData);
+}
+
+size_t sdf_get_state(const sdf_filter* filter, void* data, size_t size)
+{
+    if( filter == nullptr || data == nullptr || size < sizeof(StateData) )
+        return 0;
+
+    StateData state;
+    filter->engine.getState(state);
+    std::memcpy(data, &state, sizeof(state));
+    return sizeof(state);
+}
+
+int sdf_set_state(sdf_filter* filter, const void* data, size_t size)
+{
+    if( filter == nullptr || data == nullptr )
+        return SDF_ERROR_INVALID_ARGUMENT;
+
+    return filter->engine.setState(data, size) ? SDF_OK : SDF_ERROR_INVALID_STATE;
+}
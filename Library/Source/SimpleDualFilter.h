@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    SimpleDualFilter.h
+
+    C interface to the SimpleDualFilter DSP, for C programs and for scripting
+    languages with a C foreign function interface (e.g. Python's ctypes).
+
+    Parameters are addressed by the IDs of the plugin's parameters ("Peak1 Freq",
+    "Peak1 Gain", "Peak1 Quality", "Span", "Balance", "Output Gain", "Bands",
+    "Peak Design", "Morph", "Saturation", "Drive", "A/B Morph", "Auto Gain")
+    and set in their real units; choices are set by index. "A/B Morph" is
+    only kept with the state, the library has no snapshots to morph between.
+    Key Track and Pitch Track are not part of the library.
+    Processing is in place, on one or two channels, and never allocates.
+
+    An instance must not be processed from two threads at once. Parameters may
+    be set from another thread while it processes.
+
+  ==============================================================================
+*/
+
+#ifndef SIMPLE_DUAL_FILTER_H
+#define SIMPLE_DUAL_FILTER_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+ #if defined(SDF_BUILDING_DLL)
+  #define SDF_API __declspec(dllexport)
+ #elif defined(SDF_USING_DLL)
+  #define SDF_API __declspec(dllimport)
+ #else
+  #define SDF_API
+ #endif
+#else
+ #define SDF_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sdf_filter sdf_filter;
+
+/* Status codes */
+#define SDF_OK                      0
+#define SDF_ERROR_INVALID_ARGUMENT  (-1)
+#define SDF_ERROR_UNKNOWN_PARAMETER (-2)
+#define SDF_ERROR_INVALID_STATE     (-3)
+
+/* Returns NULL if the sample rate is not positive or the allocation fails */
+SDF_API sdf_filter* sdf_create(double sample_rate);
+SDF_API void sdf_destroy(sdf_filter* filter);
+
+/* Clears the filter state and jumps to the current parameter values without smoothing */
+SDF_API void sdf_reset(sdf_filter* filter);
+
+/* The parameters, in the order of the plugin's parameter layout */
+SDF_API int sdf_get_num_parameters(void);
+SDF_API const char* sdf_get_parameter_id(int index);
+SDF_API int sdf_get_parameter_range(int index, float* minimum, float* maximum, float* default_value);
+
+/* Changes are smoothed over 50 ms like in the plugin */
+SDF_API int sdf_set_parameter(sdf_filter* filter, const char* id, float value);
+SDF_API int sdf_get_parameter(const sdf_filter* filter, const char* id, float* value);
+
+/* channels[ch][i] for num_channels = 1 or 2 */
+SDF_API int sdf_process_planar(sdf_filter* filter, float* const* channels, int num_channels, int num_samples);
+
+/* samples[i * num_channels + ch] for num_channels = 1 or 2 */
+SDF_API int sdf_process_interleaved(sdf_filter* filter, float* samples, int num_channels, int num_frames);
+
+/* The state is the plugin's binary state block, so presets move between both.
+   sdf_get_state returns the number of bytes written, or 0 if size is too small. */
+SDF_API size_t sdf_get_state_size(void);
+SDF_API size_t sdf_get_state(const sdf_filter* filter, void* data, size_t size);
+SDF_API int sdf_set_state(sdf_filter* filter, const void* data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMPLE_DUAL_FILTER_H */
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    AutoGain.h
+
+    Make-up gain that keeps the loudness of broadband material roughly where
+    it was without the filter. It is computed from the coefficients rather
+    than measured on the audio: the power response of the cascade is averaged
+    over log-spaced points from 20 Hz to 20 kHz, which weights every octave
+    alike like a pink spectrum, with each point weighted by the A-weighting
+    curve. The make-up gain is the inverse of that average.
+
+    One evaluation costs a few multiplies per point and band, and the result
+    is cached for the settings it was computed for, so settled parameters and
+    OUT G moves on its own cost nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "PeakChain.h"
+
+class AutoGain
+{
+public:
+    static constexpr int numPoints = 48;
+    static constexpr double maxMakeUpInDecibels = 24.0;
+
+    // Sets up the frequency grid, call before the first getMakeUpGain
+    void prepare(double sampleRate) noexcept
+    {
+        constexpr double twoPi = 2.0 * 3.14159265358979323846;
+        constexpr double lowest = 20.0, highest = 20000.0;
+
+        // Points above Nyquist don't exist at low sample rates, so the grid stops short of it
+        auto top = std::min(highest, 0.45 * sampleRate);
+        double weightSum = 0.0;
+
+        for( int i = 0; i < numPoints; ++i )
+        {
+            auto frequency = lowest * std::pow(top / lowest, double(i) / double(numPoints - 1));
+            auto w = twoPi * frequency / sampleRate;
+
+            cos1[(size_t) i] = std::cos(w);
+            cos2[(size_t) i] = std::cos(2.0 * w);
+            weights[(size_t) i] = getWeighting(frequency);
+            weightSum += weights[(size_t) i];
+        }
+
+        for( auto& weight : weights )
+            weight /= weightSum;
+
+        cacheValid = false;
+    }
+
+    // Linear make-up gain for the cascade designed from chainSettings. Computed again
+    // only when the settings that shape the response differ from the last call.
+    template <typename SectionCoefficients>
+    double getMakeUpGain(const ChainSettings& chainSettings, const SectionCoefficients* sections, int numSections) noexcept
+    {
+        if( cacheValid && numSections == cachedNumSections && hasSameResponse(chainSettings, cachedSettings) )
+            return cachedGain;
+
+        std::array<BiquadCoefficients<double>, maxNumPeaks> converted;
+        numSections = std::min(numSections, maxNumPeaks);
+
+        for( int band = 0; band < numSections; ++band )
+            converted[(size_t) band] = BiquadCoefficients<double>(sections[band]);
+
+        cachedGain = computeMakeUpGain(converted.data(), numSections);
+        cachedSettings = chainSettings;
+        cachedNumSections = numSections;
+        cacheValid = true;
+
+        return cachedGain;
+    }
+
+    // Uncached, for any cascade
+    double computeMakeUpGain(const BiquadCoefficients<double>* sections, int numSections) const noexcept
+    {
+        std::array<double, numPoints> power;
+        power.fill(1.0);
+
+        // |B(e^jw)|^2 and |A(e^jw)|^2 only need cos w and cos 2w
+        for( int band = 0; band < numSections; ++band )
+        {
+            const auto& s = sections[band];
+
+            auto numDC = s.b0 * s.b0 + s.b1 * s.b1 + s.b2 * s.b2;
+            auto num1 = 2.0 * (s.b0 * s.b1 + s.b1 * s.b2);
+            auto num2 = 2.0 * s.b0 * s.b2;
+            auto denDC = 1.0 + s.a1 * s.a1 + s.a2 * s.a2;
+            auto den1 = 2.0 * (s.a1 + s.a1 * s.a2);
+            auto den2 = 2.0 * s.a2;
+
+            for( size_t i = 0; i < (size_t) numPoints; ++i )
+            {
+                auto num = numDC + num1 * cos1[i] + num2 * cos2[i];
+                auto den = denDC + den1 * cos1[i] + den2 * cos2[i];
+                power[i] *= std::max(num, 0.0) / den;
+            }
+        }
+
+        double weightedPower = 0.0;
+
+        for( size_t i = 0; i < (size_t) numPoints; ++i )
+            weightedPower += weights[i] * power[i];
+
+        // Same as juce::Decibels over the clamped range, without pulling JUCE in here
+        constexpr double minPower = 1.0e-24;
+        auto makeUpInDecibels = -10.0 * std::log10(std::max(weightedPower, minPower));
+
+        return std::pow(10.0, std::clamp(makeUpInDecibels, -maxMakeUpInDecibels, maxMakeUpInDecibels) / 20.0);
+    }
+
+    // A-weighting (IEC 61672) as a power ratio, 1 at 1 kHz
+    static double getWeighting(double frequency) noexcept
+    {
+        auto f2 = frequency * frequency;
+        auto ra = (12194.0 * 12194.0 * f2 * f2)
+                / ((f2 + 20.6 * 20.6) * std::sqrt((f2 + 107.7 * 107.7) * (f2 + 737.9 * 737.9)) * (f2 + 12194.0 * 12194.0));
+
+        // R_A(1 kHz) = 0.7943, the +2.0 dB in the standard's definition
+        constexpr double atOneKilohertz = 0.79434;
+        auto relative = ra / atOneKilohertz;
+
+        return relative * relative;
+    }
+
+private:
+    static bool hasSameResponse(const ChainSettings& a, const ChainSettings& b) noexcept
+    {
+        return a.peak1Freq == b.peak1Freq && a.peak1GainInDecibels == b.peak1GainInDecibels
+            && a.peak1Quality == b.peak1Quality && a.span == b.span && a.balance == b.balance
+            && a.numPeaks == b.numPeaks && a.design == b.design && a.morph == b.morph
+            && a.snapshotMorph == b.snapshotMorph;
+    }
+
+    std::array<double, numPoints> cos1 {}, cos2 {}, weights {};
+
+    ChainSettings cachedSettings;
+    int cachedNumSections { 0 };
+    double cachedGain { 1 };
+    bool cacheValid { false };
+};
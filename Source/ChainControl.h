@@ -0,0 +1,416 @@
+/*
+  ==============================================================================
+
+    ChainControl.h
+
+    The control-rate half of the filter, shared by SimpleDualFilterAudioProcessor
+    and the library's DualFilterEngine: the parameter table and its mapping to
+    ChainSettings, the smoothing, when to design new coefficients, the chain and
+    saturator gains and the hand-over between the peak and morph cores. The
+    owners keep the chains and decide what to design at a control tick. Only the
+    standard library is used.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+
+#include "AutoGain.h"
+#include "MorphChain.h"
+#include "Saturator.h"
+
+// One parameter of createParameterLayout, in its real units
+struct ChainParameterInfo
+{
+    const char* id;
+    float minimum, maximum, interval, defaultValue;
+};
+
+// Every parameter in the order of createParameterLayout, which is also the order
+// of their values in StateData. Choices are indices into their lists.
+constexpr ChainParameterInfo chainParameterTable[]
+{
+    { "Peak1 Freq",      20.f, 10000.f, 1.f,   20.f },
+    { "Peak1 Gain",     -24.f,    24.f, 0.1f,   0.f },
+    { "Peak1 Quality",    0.1f,   10.f, 0.1f,   1.f },
+    { "Span",             0.f,    10.f, 0.01f,  0.f },
+    { "Balance",        -12.f,    12.f, 0.1f,   0.f },
+    { "Output Gain",    -60.f,     0.f, 0.1f,   0.f },
+    { "Bands",            0.f,     2.f, 1.f,    0.f },      // Index into peakChainSizes
+    { "Peak Design",      0.f,     1.f, 1.f,    0.f },      // Bilinear, Matched
+    { "Morph",            0.f,     4.f, 0.01f,  0.f },      // Peak, low shelf, high shelf, band-pass, notch
+    { "Saturation",       0.f,     1.f, 1.f,    0.f },      // Off, On
+    { "Drive",            0.f,    24.f, 0.1f,   0.f },
+    { "A/B Morph",        0.f,     1.f, 0.001f, 0.f },
+    { "Auto Gain",        0.f,     1.f, 1.f,    0.f },      // Off, On
+    { "Key Track",        0.f,     1.f, 1.f,    0.f },      // Off, On
+    { "Pitch Track",      0.f,     2.f, 1.f,    0.f }       // Off, Input, Sidechain
+};
+
+constexpr int numChainParameters = int(sizeof(chainParameterTable) / sizeof(chainParameterTable[0]));
+
+// The settings for the parameter values, getValue(index) returning the value of
+// chainParameterTable[index] in its real units
+template <typename GetValue>
+ChainSettings makeChainSettings(GetValue&& getValue)
+{
+    ChainSettings settings;
+
+    settings.peak1Freq = getValue(0);
+    settings.peak1GainInDecibels = getValue(1);
+    settings.peak1Quality = getValue(2);
+    settings.span = getValue(3);
+    settings.balance = getValue(4);
+    settings.outputGain = getValue(5);
+
+    auto bandsIndex = std::min(std::max(int(std::lround(getValue(6))), 0), 2);
+    settings.numPeaks = peakChainSizes[bandsIndex];
+
+    settings.design = getValue(7) >= 0.5f ? PeakDesign::matched : PeakDesign::bilinear;
+    settings.morph = getValue(8);
+    settings.saturate = getValue(9) >= 0.5f;
+    settings.drive = getValue(10);
+    settings.snapshotMorph = getValue(11);
+    settings.autoGain = getValue(12) >= 0.5f;
+    settings.keyTrack = getValue(13) >= 0.5f;
+    settings.pitchTrack = (PitchTrackSource) std::min(std::max(int(std::lround(getValue(14))), 0), 2);
+
+    return settings;
+}
+
+// Same floor as juce::Decibels, the bottom of the OUT G range is silence
+inline float decibelsToGain(float decibels) noexcept
+{
+    return decibels > -100.f ? std::pow(10.f, decibels * 0.05f) : 0.f;
+}
+
+// Hands the running filter over between a peak chain and the morph chain of the same
+// band count. At MORPH 0 both cores have the same transfer function, so it is exact there.
+template <typename PeakChainType, typename MorphChainType>
+void handOverMorphCore(PeakChainType& chain, MorphChainType& morphChain, bool toMorph) noexcept
+{
+    if( toMorph )
+        transferChainState(morphChain, chain);
+    else
+        transferChainState(chain, morphChain);
+}
+
+//==============================================================================
+// Like juce::SmoothedValue, linear or multiplicative
+template <bool Multiplicative>
+class SmoothedControlValue
+{
+public:
+    void reset(int rampLength) noexcept
+    {
+        stepsToTarget = rampLength;
+        setCurrentAndTargetValue(target);
+    }
+
+    void setCurrentAndTargetValue(float value) noexcept
+    {
+        current = target = value;
+        countdown = 0;
+    }
+
+    void setTargetValue(float value) noexcept
+    {
+        if( value == target )
+            return;
+
+        if( stepsToTarget <= 0 )
+        {
+            setCurrentAndTargetValue(value);
+            return;
+        }
+
+        target = value;
+        countdown = stepsToTarget;
+
+        if constexpr( Multiplicative )
+            step = std::exp((std::log(std::abs(target)) - std::log(std::abs(current))) / float(countdown));
+        else
+            step = (target - current) / float(countdown);
+    }
+
+    float skip(int numSamples) noexcept
+    {
+        if( numSamples >= countdown )
+        {
+            setCurrentAndTargetValue(target);
+            return target;
+        }
+
+        if constexpr( Multiplicative )
+            current *= std::pow(step, float(numSamples));
+        else
+            current += step * float(numSamples);
+
+        countdown -= numSamples;
+        return current;
+    }
+
+    bool isSmoothing() const noexcept { return countdown > 0; }
+    float getCurrentValue() const noexcept { return current; }
+
+private:
+    float current { 0 }, target { 0 }, step { 0 };
+    int countdown { 0 }, stepsToTarget { 0 };
+};
+
+// Smooths the continuous ChainSettings values towards the latest parameter values
+class SmoothedChainSettings
+{
+public:
+    void reset(double sampleRate, double rampLengthInSeconds) noexcept
+    {
+        auto rampLength = int(std::floor(rampLengthInSeconds * sampleRate));
+
+        for( auto* smoother : { &freq, &quality } )
+            smoother->reset(rampLength);
+
+        for( auto* smoother : { &gain, &span, &balance, &outputGain, &morph, &drive, &snapshotMorph } )
+            smoother->reset(rampLength);
+    }
+
+    void setCurrentAndTargetValue(const ChainSettings& chainSettings) noexcept
+    {
+        freq.setCurrentAndTargetValue(chainSettings.peak1Freq);
+        quality.setCurrentAndTargetValue(chainSettings.peak1Quality);
+        gain.setCurrentAndTargetValue(chainSettings.peak1GainInDecibels);
+        span.setCurrentAndTargetValue(chainSettings.span);
+        balance.setCurrentAndTargetValue(chainSettings.balance);
+        outputGain.setCurrentAndTargetValue(chainSettings.outputGain);
+        morph.setCurrentAndTargetValue(chainSettings.morph);
+        drive.setCurrentAndTargetValue(chainSettings.drive);
+        snapshotMorph.setCurrentAndTargetValue(chainSettings.snapshotMorph);
+        setSwitches(chainSettings);
+    }
+
+    void setTargetValue(const ChainSettings& chainSettings) noexcept
+    {
+        freq.setTargetValue(chainSettings.peak1Freq);
+        quality.setTargetValue(chainSettings.peak1Quality);
+        gain.setTargetValue(chainSettings.peak1GainInDecibels);
+        span.setTargetValue(chainSettings.span);
+        balance.setTargetValue(chainSettings.balance);
+        outputGain.setTargetValue(chainSettings.outputGain);
+        morph.setTargetValue(chainSettings.morph);
+        drive.setTargetValue(chainSettings.drive);
+        snapshotMorph.setTargetValue(chainSettings.snapshotMorph);
+        setSwitches(chainSettings);
+    }
+
+    // Pitch Track moves FREQ between parameter updates
+    void setTargetFrequency(float frequency) noexcept
+    {
+        freq.setTargetValue(frequency);
+    }
+
+    bool isSmoothing() const noexcept
+    {
+        return freq.isSmoothing() || quality.isSmoothing() || gain.isSmoothing()
+            || span.isSmoothing() || balance.isSmoothing() || outputGain.isSmoothing()
+            || morph.isSmoothing() || drive.isSmoothing() || snapshotMorph.isSmoothing();
+    }
+
+    ChainSettings getCurrentValue() const noexcept
+    {
+        ChainSettings settings;
+
+        settings.peak1Freq = freq.getCurrentValue();
+        settings.peak1Quality = quality.getCurrentValue();
+        settings.peak1GainInDecibels = gain.getCurrentValue();
+        settings.span = span.getCurrentValue();
+        settings.balance = balance.getCurrentValue();
+        settings.outputGain = outputGain.getCurrentValue();
+        settings.morph = morph.getCurrentValue();
+        settings.drive = drive.getCurrentValue();
+        settings.snapshotMorph = snapshotMorph.getCurrentValue();
+        settings.numPeaks = numPeaks;
+        settings.design = design;
+        settings.saturate = saturate;
+        settings.autoGain = autoGain;
+        settings.keyTrack = keyTrack;
+        settings.pitchTrack = pitchTrack;
+
+        return settings;
+    }
+
+    ChainSettings skip(int numSamples) noexcept
+    {
+        for( auto* smoother : { &freq, &quality } )
+            smoother->skip(numSamples);
+
+        for( auto* smoother : { &gain, &span, &balance, &outputGain, &morph, &drive, &snapshotMorph } )
+            smoother->skip(numSamples);
+
+        return getCurrentValue();
+    }
+
+private:
+    SmoothedControlValue<true> freq, quality;
+    SmoothedControlValue<false> gain, span, balance, outputGain, morph, drive, snapshotMorph;
+
+    int numPeaks { 2 };
+    PeakDesign design { PeakDesign::bilinear };
+    bool saturate { false };
+    bool autoGain { false };
+    bool keyTrack { false };
+    PitchTrackSource pitchTrack { PitchTrackSource::off };
+
+    void setSwitches(const ChainSettings& chainSettings) noexcept
+    {
+        numPeaks = chainSettings.numPeaks;
+        design = chainSettings.design;
+        saturate = chainSettings.saturate;
+        autoGain = chainSettings.autoGain;
+        keyTrack = chainSettings.keyTrack;
+        pitchTrack = chainSettings.pitchTrack;
+    }
+};
+
+//==============================================================================
+// While parameters move, the owner designs new coefficients at every control tick and
+// lets the chain ramp towards them. Once settled, the chain runs without redesigns.
+class ChainControl
+{
+public:
+    static constexpr double smoothingTimeInSeconds = 0.05;
+
+    void prepare(double sampleRate) noexcept
+    {
+        smoothedSettings.reset(sampleRate, smoothingTimeInSeconds);
+        autoGain.prepare(sampleRate);
+
+        redesignPending = false;
+        samplesUntilControlTick = 0;
+    }
+
+    // Jumps to the settings, nothing is left to design
+    void setCurrentSettings(const ChainSettings& chainSettings) noexcept
+    {
+        smoothedSettings.setCurrentAndTargetValue(chainSettings);
+        redesignPending = false;
+    }
+
+    void setTargetSettings(const ChainSettings& chainSettings) noexcept
+    {
+        auto wasSmoothing = smoothedSettings.isSmoothing();
+        auto current = smoothedSettings.getCurrentValue();
+
+        // A design, saturation or Auto Gain switch is ramped like a parameter change, over one control interval
+        if( chainSettings.design != current.design || chainSettings.saturate != current.saturate
+            || chainSettings.autoGain != current.autoGain )
+            redesignPending = true;
+
+        smoothedSettings.setTargetValue(chainSettings);
+
+        // Start designing right away rather than on the next idle tick
+        if( ! wasSmoothing && needsDesign() )
+            samplesUntilControlTick = 0;
+    }
+
+    void setTargetFrequency(float frequency) noexcept
+    {
+        smoothedSettings.setTargetFrequency(frequency);
+    }
+
+    // For a change the smoothers don't see, designed at the next control tick
+    void requestRedesign() noexcept
+    {
+        if( ! smoothedSettings.isSmoothing() )
+            samplesUntilControlTick = 0;
+
+        redesignPending = true;
+    }
+
+    bool isSmoothing() const noexcept { return smoothedSettings.isSmoothing(); }
+    bool needsDesign() const noexcept { return redesignPending || smoothedSettings.isSmoothing(); }
+
+    ChainSettings getCurrentSettings() const noexcept { return smoothedSettings.getCurrentValue(); }
+
+    //==============================================================================
+    bool isControlTickDue() const noexcept { return samplesUntilControlTick <= 0; }
+    int getSamplesUntilControlTick() const noexcept { return samplesUntilControlTick; }
+
+    // Moves the smoothers on by one control interval, for the design at a tick
+    ChainSettings skip(int numSamples) noexcept { return smoothedSettings.skip(numSamples); }
+
+    // Call at the end of a control tick, whether or not it designed
+    void finishControlTick(int samplesUntilNextTick) noexcept
+    {
+        redesignPending = false;
+        samplesUntilControlTick = samplesUntilNextTick;
+    }
+
+    void advance(int numSamples) noexcept { samplesUntilControlTick -= numSamples; }
+
+    // For changes the owner designs for itself, like new notes
+    void triggerControlTick() noexcept { samplesUntilControlTick = 0; }
+
+    //==============================================================================
+    // The gain after the last band, OUT G or DRIVE, with Auto Gain on times the make-up gain for the sections
+    template <typename SectionCoefficients>
+    float getChainGainLinear(const ChainSettings& chainSettings, const SectionCoefficients* sections, int numSections) noexcept
+    {
+        auto gainCoefficient = decibelsToGain(getChainGainInDecibels(chainSettings));
+
+        if( ! chainSettings.autoGain )
+            return gainCoefficient;
+
+        return gainCoefficient * float(autoGain.getMakeUpGain(chainSettings, sections, numSections));
+    }
+
+    // Designs the chain's coefficients and ramps it there over numSamples, returns the gain it ramps to
+    template <typename Chain>
+    float rampChain(Chain& chain, const typename Chain::CoefficientArray& coefficients,
+                    const ChainSettings& chainSettings, int numSamples) noexcept
+    {
+        auto gainCoefficient = getChainGainLinear(chainSettings, coefficients.data(), (int) coefficients.size());
+        chain.setTarget(coefficients, gainCoefficient, numSamples);
+
+        return gainCoefficient;
+    }
+
+    // Switches the saturation on or off and jumps the gain, or ramps it over numSamples while
+    // the saturation stays on. The curve itself comes and goes at once, switched on it starts
+    // from silence rather than from a stale sample. withSaturators(process) calls process on
+    // each of the owner's saturators.
+    template <typename WithSaturators>
+    void updateSaturator(const ChainSettings& chainSettings, int numSamples, WithSaturators&& withSaturators) noexcept
+    {
+        auto switchedOn = chainSettings.saturate && ! saturatorActive;
+        auto jump = numSamples <= 0 || chainSettings.saturate != saturatorActive;
+        auto gainCoefficient = decibelsToGain(getSaturatorGainInDecibels(chainSettings));
+
+        withSaturators([switchedOn, jump, gainCoefficient, numSamples](auto& saturator)
+        {
+            if( switchedOn )
+                saturator.reset();
+
+            if( jump )
+                saturator.setGainLinear(gainCoefficient);
+            else
+                saturator.setTarget(gainCoefficient, numSamples);
+        });
+
+        saturatorActive = chainSettings.saturate;
+    }
+
+    bool isSaturatorActive() const noexcept { return saturatorActive; }
+
+private:
+    SmoothedChainSettings smoothedSettings;
+
+    // Make-up gain of the active chain for Auto Gain, cached across control ticks
+    AutoGain autoGain;
+
+    // Set when the peak design changed, which the smoothers don't see
+    bool redesignPending { false };
+    bool saturatorActive { false };
+
+    int samplesUntilControlTick { 0 };
+};
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    FilterResponse.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterResponse.h"
+#include "AutoGain.h"
+
+void computeCascadeResponse(const BiquadCoefficients<double>* sections,
+                            int numSections,
+                            double gain,
+                            double sampleRate,
+                            const double* frequencies,
+                            int numPoints,
+                            double* magnitudes,
+                            double* phases,
+                            double* groupDelays) noexcept
+{
+    constexpr int chunkSize = 64;
+    constexpr double twoPi = 2.0 * 3.14159265358979323846;
+
+    std::array<double, chunkSize> c1, s1, c2, s2, re, im, delay;
+
+    for( int start = 0; start < numPoints; start += chunkSize )
+    {
+        auto n = std::min(chunkSize, numPoints - start);
+        const auto* f = frequencies + start;
+
+        for( int i = 0; i < n; ++i )
+        {
+            auto w = twoPi * f[i] / sampleRate;
+            c1[i] = std::cos(w);
+            s1[i] = std::sin(w);
+            c2[i] = 2.0 * c1[i] * c1[i] - 1.0;
+            s2[i] = 2.0 * s1[i] * c1[i];
+
+            re[i] = gain;
+            im[i] = 0.0;
+            delay[i] = 0.0;
+        }
+
+        for( int section = 0; section < numSections; ++section )
+        {
+            const auto b0 = sections[section].b0, b1 = sections[section].b1, b2 = sections[section].b2;
+            const auto a1 = sections[section].a1, a2 = sections[section].a2;
+
+            for( int i = 0; i < n; ++i )
+            {
+                // Numerator and denominator at e^jw
+                auto numRe = b0 + b1 * c1[i] + b2 * c2[i];
+                auto numIm = -(b1 * s1[i] + b2 * s2[i]);
+                auto denRe = 1.0 + a1 * c1[i] + a2 * c2[i];
+                auto denIm = -(a1 * s1[i] + a2 * s2[i]);
+
+                auto numNorm = numRe * numRe + numIm * numIm;
+                auto denNorm = denRe * denRe + denIm * denIm;
+
+                auto hRe = (numRe * denRe + numIm * denIm) / denNorm;
+                auto hIm = (numIm * denRe - numRe * denIm) / denNorm;
+
+                auto productRe = re[i] * hRe - im[i] * hIm;
+                im[i] = re[i] * hIm + im[i] * hRe;
+                re[i] = productRe;
+
+                // The group delay of a polynomial sum(c_k z^-k) is Re(sum(k c_k z^-k) / sum(c_k z^-k))
+                auto numRampRe = b1 * c1[i] + 2.0 * b2 * c2[i];
+                auto numRampIm = -(b1 * s1[i] + 2.0 * b2 * s2[i]);
+                auto denRampRe = a1 * c1[i] + 2.0 * a2 * c2[i];
+                auto denRampIm = -(a1 * s1[i] + 2.0 * a2 * s2[i]);
+
+                auto numDelay = numNorm > 0.0 ? (numRampRe * numRe + numRampIm * numIm) / numNorm : 0.0;
+                auto denDelay = (denRampRe * denRe + denRampIm * denIm) / denNorm;
+
+                delay[i] += numDelay - denDelay;
+            }
+        }
+
+        if( magnitudes != nullptr )
+            for( int i = 0; i < n; ++i )
+                magnitudes[start + i] = std::sqrt(re[i] * re[i] + im[i] * im[i]);
+
+        if( phases != nullptr )
+            for( int i = 0; i < n; ++i )
+                phases[start + i] = std::atan2(im[i], re[i]);
+
+        if( groupDelays != nullptr )
+            for( int i = 0; i < n; ++i )
+                groupDelays[start + i] = delay[i] / sampleRate;
+    }
+}
+
+void computeChainResponse(const ChainSettings& chainSettings,
+                          double sampleRate,
+                          const double* frequencies,
+                          int numPoints,
+                          double* magnitudes,
+                          double* phases,
+                          double* groupDelays) noexcept
+{
+    std::array<BiquadCoefficients<double>, maxNumPeaks> sections;
+    auto numPeaks = std::clamp(chainSettings.numPeaks, 1, maxNumPeaks);
+
+    for( int band = 0; band < numPeaks; ++band )
+        sections[band] = makeBandCoefficients<double>(chainSettings, band, numPeaks, sampleRate);
+
+    // Same as juce::Decibels::decibelsToGain over the output gain range
+    auto gain = std::pow(10.0, double(chainSettings.outputGain) / 20.0);
+
+    if( chainSettings.autoGain )
+    {
+        AutoGain autoGain;
+        autoGain.prepare(sampleRate);
+        gain *= autoGain.computeMakeUpGain(sections.data(), numPeaks);
+    }
+
+    computeCascadeResponse(sections.data(), numPeaks, gain, sampleRate, frequencies, numPoints, magnitudes, phases, groupDelays);
+}
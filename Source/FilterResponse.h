@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    FilterResponse.h
+
+    Frequency response of a cascade of biquads evaluated for a whole array of
+    frequencies at once. Points are handled in chunks: the sines and cosines
+    are computed once per point, then each section runs a branch-free loop
+    over the chunk, so the section loops vectorise.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MorphChain.h"
+
+// Magnitudes are linear, phases in radians wrapped to (-pi, pi] and group
+// delays in seconds. Any of the output arrays may be null to skip it.
+void computeCascadeResponse(const BiquadCoefficients<double>* sections,
+                            int numSections,
+                            double gain,
+                            double sampleRate,
+                            const double* frequencies,
+                            int numPoints,
+                            double* magnitudes,
+                            double* phases,
+                            double* groupDelays) noexcept;
+
+// All peaks of the settings followed by the output gain, and the make-up gain with Auto Gain on
+void computeChainResponse(const ChainSettings& chainSettings,
+                          double sampleRate,
+                          const double* frequencies,
+                          int numPoints,
+                          double* magnitudes,
+                          double* phases,
+                          double* groupDelays) noexcept;
@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+
+    Peak, RMS and L/R correlation of a stereo signal, measured in one pass
+    over the block. The pass keeps one accumulator per lane in small arrays,
+    which the compiler turns into vector registers without needing
+    fast-math. The audio thread publishes the ballistics through relaxed
+    atomics, so the editor reads them without taking a lock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+struct BlockLevels
+{
+    std::array<float, 2> peak { 0.f, 0.f };
+    std::array<float, 2> sumOfSquares { 0.f, 0.f };
+    float sumOfProducts { 0.f };
+};
+
+// Mono blocks are measured as if both channels carried the same signal
+inline BlockLevels measureBlockLevels(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    constexpr int lanes = 8;
+
+    BlockLevels levels;
+
+    if( numChannels <= 0 || numSamples <= 0 )
+        return levels;
+
+    const auto* left = channels[0];
+    const auto* right = numChannels > 1 ? channels[1] : channels[0];
+
+    std::array<float, lanes> peakL {}, peakR {}, squaresL {}, squaresR {}, products {};
+
+    int i = 0;
+
+    for( ; i + lanes <= numSamples; i += lanes )
+    {
+        for( int k = 0; k < lanes; ++k )
+        {
+            auto l = left[i + k];
+            auto r = right[i + k];
+
+            peakL[k] = std::max(peakL[k], std::abs(l));
+            peakR[k] = std::max(peakR[k], std::abs(r));
+            squaresL[k] += l * l;
+            squaresR[k] += r * r;
+            products[k] += l * r;
+        }
+    }
+
+    for( ; i < numSamples; ++i )
+    {
+        auto l = left[i];
+        auto r = right[i];
+
+        peakL[0] = std::max(peakL[0], std::abs(l));
+        peakR[0] = std::max(peakR[0], std::abs(r));
+        squaresL[0] += l * l;
+        squaresR[0] += r * r;
+        products[0] += l * r;
+    }
+
+    for( int k = 0; k < lanes; ++k )
+    {
+        levels.peak[0] = std::max(levels.peak[0], peakL[k]);
+        levels.peak[1] = std::max(levels.peak[1], peakR[k]);
+        levels.sumOfSquares[0] += squaresL[k];
+        levels.sumOfSquares[1] += squaresR[k];
+        levels.sumOfProducts += products[k];
+    }
+
+    return levels;
+}
+
+class LevelMeter
+{
+public:
+    static constexpr int numChannels = 2;
+
+    // Call before processing starts
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        heldPeak.fill(0.f);
+        meanSquares.fill(0.f);
+        meanProduct = 0.f;
+
+        for( int ch = 0; ch < numChannels; ++ch )
+        {
+            peak[ch].store(0.f, std::memory_order_relaxed);
+            rms[ch].store(0.f, std::memory_order_relaxed);
+        }
+
+        correlation.store(1.f, std::memory_order_relaxed);
+    }
+
+    // Audio thread
+    void process(const float* const* channels, int numChannelsToMeasure, int numSamples) noexcept
+    {
+        if( numSamples <= 0 )
+            return;
+
+        auto levels = measureBlockLevels(channels, numChannelsToMeasure, numSamples);
+
+        auto blockSeconds = double(numSamples) / sampleRate;
+        auto peakDecay = float(std::exp(-blockSeconds / peakReleaseSeconds));
+        auto rmsAlpha = float(1.0 - std::exp(-blockSeconds / rmsSeconds));
+
+        for( int ch = 0; ch < numChannels; ++ch )
+        {
+            heldPeak[ch] = std::max(levels.peak[ch], heldPeak[ch] * peakDecay);
+            meanSquares[ch] += rmsAlpha * (levels.sumOfSquares[ch] / float(numSamples) - meanSquares[ch]);
+
+            peak[ch].store(heldPeak[ch], std::memory_order_relaxed);
+            rms[ch].store(std::sqrt(meanSquares[ch]), std::memory_order_relaxed);
+        }
+
+        meanProduct += rmsAlpha * (levels.sumOfProducts / float(numSamples) - meanProduct);
+
+        // Silence counts as fully correlated rather than undefined
+        auto energy = std::sqrt(meanSquares[0] * meanSquares[1]);
+        auto newCorrelation = energy > 1.0e-9f ? std::clamp(meanProduct / energy, -1.f, 1.f) : 1.f;
+
+        correlation.store(newCorrelation, std::memory_order_relaxed);
+    }
+
+    // Any thread, linear gain values
+    float getPeak(int channel) const noexcept { return peak[(size_t) channel].load(std::memory_order_relaxed); }
+    float getRms(int channel) const noexcept { return rms[(size_t) channel].load(std::memory_order_relaxed); }
+
+    // -1 (out of phase) to +1 (mono)
+    float getCorrelation() const noexcept { return correlation.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr double peakReleaseSeconds = 0.5;
+    static constexpr double rmsSeconds = 0.3;
+
+    double sampleRate { 44100.0 };
+
+    // Audio thread state
+    std::array<float, numChannels> heldPeak {}, meanSquares {};
+    float meanProduct { 0.f };
+
+    // Published values
+    std::array<std::atomic<float>, numChannels> peak {}, rms {};
+    std::atomic<float> correlation { 1.f };
+};
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    LinkGroup.cpp
+
+  ==============================================================================
+*/
+
+#include "LinkGroup.h"
+
+static juce::CriticalSection& getGroupsLock()
+{
+    static juce::CriticalSection lock;
+    return lock;
+}
+
+static juce::OwnedArray<LinkGroup>& getGroups()
+{
+    static juce::OwnedArray<LinkGroup> groups;
+    return groups;
+}
+
+LinkGroup& LinkGroup::join(const juce::String& groupName, const void* member)
+{
+    const juce::ScopedLock sl(getGroupsLock());
+
+    auto& groups = getGroups();
+    LinkGroup* group = nullptr;
+
+    for( auto* g : groups )
+        if( g->name == groupName )
+            group = g;
+
+    if( group == nullptr )
+        group = groups.add(new LinkGroup(groupName));
+
+    const juce::ScopedLock ml(group->membersLock);
+
+    group->members.addIfNotAlreadyThere(member);
+
+    if( group->leader.load() == nullptr )
+    {
+        group->leader = member;
+        group->publishRequested = true;
+    }
+
+    return *group;
+}
+
+void LinkGroup::leave(const void* member)
+{
+    const juce::ScopedLock ml(membersLock);
+
+    members.removeFirstMatchingValue(member);
+
+    if( leader.load() == member )
+    {
+        leader = members.isEmpty() ? nullptr : members.getFirst();
+        publishRequested = true;
+    }
+}
+
+void LinkGroup::publish(const LinkedState& state) noexcept
+{
+    auto s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int i = 0;
+    auto write = [this, &i](float value) { values[(size_t) i++].store(value, std::memory_order_relaxed); };
+
+    write(state.settings.peak1Freq);
+    write(state.settings.peak1GainInDecibels);
+    write(state.settings.peak1Quality);
+    write(state.settings.span);
+    write(state.settings.balance);
+    write(state.settings.outputGain);
+    write(float(state.settings.numPeaks));
+    write(float(state.settings.design));
+    write(state.settings.morph);
+    write(state.settings.saturate ? 1.f : 0.f);
+    write(state.settings.drive);
+
+    for( auto& c : state.coefficients )
+    {
+        write(c.b0); write(c.b1); write(c.b2); write(c.a1); write(c.a2);
+    }
+
+    write(state.gain);
+    write(state.sampleRate);
+
+    jassert(i == numValues);
+
+    sequence.store(s + 2, std::memory_order_release);
+    publishRequested = false;
+}
+
+bool LinkGroup::read(LinkedState& state, juce::uint32& lastSequence) const noexcept
+{
+    auto before = sequence.load(std::memory_order_acquire);
+
+    if( (before & 1) != 0 || before == lastSequence )
+        return false;
+
+    LinkedState result;
+    int i = 0;
+    auto next = [this, &i] { return values[(size_t) i++].load(std::memory_order_relaxed); };
+
+    result.settings.peak1Freq = next();
+    result.settings.peak1GainInDecibels = next();
+    result.settings.peak1Quality = next();
+    result.settings.span = next();
+    result.settings.balance = next();
+    result.settings.outputGain = next();
+    result.settings.numPeaks = int(next());
+    result.settings.design = PeakDesign(int(next()));
+    result.settings.morph = next();
+    result.settings.saturate = next() >= 0.5f;
+    result.settings.drive = next();
+
+    for( auto& c : result.coefficients )
+    {
+        c.b0 = next(); c.b1 = next(); c.b2 = next(); c.a1 = next(); c.a2 = next();
+    }
+
+    result.gain = next();
+    result.sampleRate = next();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if( sequence.load(std::memory_order_relaxed) != before )
+        return false;
+
+    state = result;
+    lastSequence = before;
+    return true;
+}
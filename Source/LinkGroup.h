@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    LinkGroup.h
+
+    Named in-process groups of linked instances. The first member of a group
+    is its leader: it designs the coefficients from its own parameters and
+    publishes them, and the other members only run their kernels on the
+    published coefficients. Publishing and reading are lock-free, joining and
+    leaving happen on the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "PeakChain.h"
+
+// Everything a follower needs to run its chain like the leader
+struct LinkedState
+{
+    ChainSettings settings;
+    std::array<BiquadCoefficients<float>, maxNumPeaks> coefficients;
+    float gain { 1.f };
+    float sampleRate { 0.f };
+};
+
+class LinkGroup
+{
+public:
+    // Groups live as long as the process, so the audio thread can keep a plain pointer
+    static LinkGroup& join(const juce::String& name, const void* member);
+    void leave(const void* member);
+
+    const juce::String& getName() const { return name; }
+
+    bool isLeader(const void* member) const noexcept { return leader.load() == member; }
+
+    // Leader only
+    void publish(const LinkedState& state) noexcept;
+
+    // Returns true and fills state when the leader published something newer
+    // than lastSequence. Returns false while the leader is writing, in that case
+    // the reader simply keeps what it had.
+    bool read(LinkedState& state, juce::uint32& lastSequence) const noexcept;
+
+    // Set when the leader changes, so the new leader publishes straight away
+    bool needsPublish() const noexcept { return publishRequested.load(); }
+
+private:
+    explicit LinkGroup(const juce::String& groupName) : name(groupName) {}
+
+    static constexpr int numSettingsValues = 11;
+    static constexpr int numValues = numSettingsValues + maxNumPeaks * 5 + 2;
+
+    const juce::String name;
+
+    juce::CriticalSection membersLock;
+    juce::Array<const void*> members;
+    std::atomic<const void*> leader { nullptr };
+    std::atomic<bool> publishRequested { false };
+
+    // Seqlock: odd while the leader writes, the values themselves are relaxed atomics
+    std::atomic<juce::uint32> sequence { 0 };
+    std::array<std::atomic<float>, numValues> values {};
+
+    JUCE_DECLARE_NON_COPYABLE (LinkGroup)
+};
@@ -0,0 +1,607 @@
+/*
+  ==============================================================================
+
+    MorphChain.h
+
+    N-band chain of state-variable filters whose response morphs continuously
+    from peak over low shelf, high shelf and band-pass to notch (MORPH 0 to 4).
+    Every mode is the same trapezoidal SVF core with a different mix of its
+    input, band-pass and low-pass outputs, so a morph position between two
+    modes costs one filter per band, not one per mode: the design interpolates
+    the core's tuning and the output mix, and the kernel runs a single SVF.
+
+    The core stays stable under the linear coefficient ramps PeakChain uses.
+    Its state update is a contraction for every design, and a ramp only ever
+    forms convex combinations of two designs' coefficients, which are
+    contractions as well.
+
+    The processor runs the PeakChain at MORPH 0 and this chain otherwise.
+    Both realise the same transfer functions for the same biquad, so handing
+    the filter over between them keeps the signal running without a click.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ParallelPeakChain.h"
+
+// Modes at the integer MORPH positions
+enum class MorphMode
+{
+    peak,
+    lowShelf,
+    highShelf,
+    bandPass,
+    notch
+};
+
+constexpr int numMorphModes = 5;
+
+// Whether the settings select the morphing core over the peak cascade
+inline bool usesMorphCore(const ChainSettings& chainSettings) noexcept
+{
+    return chainSettings.morph > 0.f;
+}
+
+// A. Simper, "Linear Trapezoidal Integrated SVF" (Cytomic, 2013), with the
+// tuning g = tan(pi f / fs) and damping k folded into a1, a2 and a3:
+//     v3 = x - ic2;  v1 = a1 ic1 + a2 v3;  v2 = ic2 + a2 ic1 + a3 v3
+//     ic1 = 2 v1 - ic1;  ic2 = 2 v2 - ic2;  y = m0 x + m1 v1 + m2 v2
+// For g and k, a1 = 1 / (1 + g (g + k)), a2 = g a1 and a3 = g a2. The outputs
+// v1 and v2 are the band-pass s / (s^2 + k s + 1) and the low-pass 1 / (s^2 + k s + 1).
+template <typename SampleType>
+struct SvfCoefficients
+{
+    SampleType a1 { 1 }, a2 { 0 }, a3 { 0 }, m0 { 1 }, m1 { 0 }, m2 { 0 };
+
+    SvfCoefficients() = default;
+
+    SvfCoefficients(SampleType newA1, SampleType newA2, SampleType newA3,
+                    SampleType newM0, SampleType newM1, SampleType newM2) noexcept
+        : a1(newA1), a2(newA2), a3(newA3), m0(newM0), m1(newM1), m2(newM2)
+    {
+    }
+
+    // The core realising a stable biquad's transfer function. A pole at Nyquist,
+    // where the tuning would be infinite, is pulled inside by a hair.
+    template <typename OtherType>
+    explicit SvfCoefficients(const BiquadCoefficients<OtherType>& biquad) noexcept
+    {
+        constexpr double minimum = 1.0e-9;
+
+        auto b0 = double(biquad.b0), b1 = double(biquad.b1), b2 = double(biquad.b2);
+        auto ba1 = double(biquad.a1), ba2 = double(biquad.a2);
+
+        auto c1 = std::max(minimum, 0.25 * (1.0 - ba1 + ba2));
+        auto c3 = std::max(minimum, 0.25 * (1.0 + ba1 + ba2));
+        auto c2 = std::sqrt(c1 * c3);
+
+        // The biquad's numerator is linear in the mix, b0 + b1 + b2 = 4 a3 (m0 + m2),
+        // b0 - b1 + b2 = 4 a1 m0 and b0 - b2 = 2 m0 (1 - a1 - a3) + 2 a2 m1
+        auto n0 = (b0 - b1 + b2) / (4.0 * c1);
+        auto n2 = (b0 + b1 + b2) / (4.0 * c3) - n0;
+        auto n1 = (b0 - b2 - 2.0 * n0 * (1.0 - c1 - c3)) / (2.0 * c2);
+
+        a1 = SampleType(c1); a2 = SampleType(c2); a3 = SampleType(c3);
+        m0 = SampleType(n0); m1 = SampleType(n1); m2 = SampleType(n2);
+    }
+
+    // Element-wise arithmetic, used to ramp linearly between two designs
+    SvfCoefficients& operator+= (const SvfCoefficients& other) noexcept
+    {
+        a1 += other.a1; a2 += other.a2; a3 += other.a3; m0 += other.m0; m1 += other.m1; m2 += other.m2;
+        return *this;
+    }
+
+    SvfCoefficients operator+ (const SvfCoefficients& other) const noexcept
+    {
+        return { a1 + other.a1, a2 + other.a2, a3 + other.a3, m0 + other.m0, m1 + other.m1, m2 + other.m2 };
+    }
+
+    SvfCoefficients operator- (const SvfCoefficients& other) const noexcept
+    {
+        return { a1 - other.a1, a2 - other.a2, a3 - other.a3, m0 - other.m0, m1 - other.m1, m2 - other.m2 };
+    }
+
+    SvfCoefficients operator* (SampleType factor) const noexcept
+    {
+        return { a1 * factor, a2 * factor, a3 * factor, m0 * factor, m1 * factor, m2 * factor };
+    }
+
+    // Conversion to another precision
+    template <typename OtherType>
+    explicit operator SvfCoefficients<OtherType>() const noexcept
+    {
+        return { OtherType(a1), OtherType(a2), OtherType(a3), OtherType(m0), OtherType(m1), OtherType(m2) };
+    }
+
+    // The biquad with the same transfer function, for response curves and link groups
+    template <typename OtherType>
+    explicit operator BiquadCoefficients<OtherType>() const noexcept
+    {
+        auto c1 = double(a1), c2 = double(a2), c3 = double(a3);
+        auto n0 = double(m0), n1 = double(m1), n2 = double(m2);
+
+        BiquadCoefficients<OtherType> biquad;
+        biquad.b0 = OtherType(n0 + n1 * c2 + n2 * c3);
+        biquad.b1 = OtherType(2.0 * (n0 + n2) * c3 - 2.0 * n0 * c1);
+        biquad.b2 = OtherType(n0 * (2.0 * c1 + 2.0 * c3 - 1.0) - n1 * c2 + n2 * c3);
+        biquad.a1 = OtherType(2.0 * (c3 - c1));
+        biquad.a2 = OtherType(2.0 * (c1 + c3) - 1.0);
+        return biquad;
+    }
+};
+
+namespace MorphDesign
+{
+    // Tuning, damping and output mix of one mode, before they are folded into a1 to a3
+    struct Mode
+    {
+        double g, k, m0, m1, m2;
+    };
+
+    // Mode designs after the Cytomic paper. The shelves move the tuning by the
+    // square root of the gain, so their midpoint sits at the band frequency.
+    // The band-pass passes the centre at the band's gain, the notch ignores it.
+    inline Mode makeMode(MorphMode mode, double g, double quality, double gainFactor) noexcept
+    {
+        auto A = std::sqrt(std::max(1.0e-6, gainFactor));
+        auto k = 1.0 / quality;
+
+        switch( mode )
+        {
+            case MorphMode::lowShelf:  return { g / std::sqrt(A), k, 1.0, k * (A - 1.0), A * A - 1.0 };
+            case MorphMode::highShelf: return { g * std::sqrt(A), k, A * A, k * (1.0 - A) * A, 1.0 - A * A };
+            case MorphMode::bandPass:  return { g, k, 0.0, k * A * A, 0.0 };
+            case MorphMode::notch:     return { g, k, 1.0, -k, 0.0 };
+            case MorphMode::peak:
+            default:                   return { g, k / A, 1.0, (k / A) * (A * A - 1.0), 0.0 };
+        }
+    }
+}
+
+// One band between the two modes around the morph position. Tuning and damping
+// are interpolated geometrically and the output mix linearly, so one core
+// covers the whole way from one mode to the next.
+template <typename SampleType>
+SvfCoefficients<SampleType> makeMorphCoefficients(double sampleRate, double frequency, double quality,
+                                                  double gainFactor, double morph)
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    // Like the matched peak, stay a little below Nyquist where the tuning goes to infinity
+    auto g = std::tan(std::min(pi * frequency / sampleRate, 0.4975 * pi));
+
+    auto position = std::min(std::max(morph, 0.0), double(numMorphModes - 1));
+    auto lower = std::min(int(position), numMorphModes - 2);
+    auto t = position - lower;
+
+    auto from = MorphDesign::makeMode(MorphMode(lower), g, quality, gainFactor);
+    auto to = MorphDesign::makeMode(MorphMode(lower + 1), g, quality, gainFactor);
+
+    auto interpolate = [t](double a, double b) { return a + (b - a) * t; };
+    auto interpolateLog = [t](double a, double b) { return a * std::pow(b / a, t); };
+
+    auto gt = interpolateLog(from.g, to.g);
+    auto kt = interpolateLog(from.k, to.k);
+    auto a1 = 1.0 / (1.0 + gt * (gt + kt));
+
+    return { SampleType(a1), SampleType(gt * a1), SampleType(gt * gt * a1),
+             SampleType(interpolate(from.m0, to.m0)),
+             SampleType(interpolate(from.m1, to.m1)),
+             SampleType(interpolate(from.m2, to.m2)) };
+}
+
+template <typename SampleType>
+SvfCoefficients<SampleType> makeMorphBandCoefficients(const ChainSettings& chainSettings, int band, int numPeaks, double sampleRate)
+{
+    auto frequency = getPeakBandFrequency(chainSettings, band, numPeaks, sampleRate);
+    auto gainFactor = std::pow(10.0, getPeakBandGainInDecibels(chainSettings, band, numPeaks) * 0.05);
+
+    return makeMorphCoefficients<SampleType>(sampleRate, frequency, chainSettings.peak1Quality, gainFactor, chainSettings.morph);
+}
+
+// A band as a biquad, from whichever core the settings select
+template <typename SampleType>
+BiquadCoefficients<SampleType> makeBandCoefficients(const ChainSettings& chainSettings, int band, int numPeaks, double sampleRate)
+{
+    if( usesMorphCore(chainSettings) )
+        return BiquadCoefficients<SampleType>(makeMorphBandCoefficients<SampleType>(chainSettings, band, numPeaks, sampleRate));
+
+    return makePeakBandCoefficients<SampleType>(chainSettings, band, numPeaks, sampleRate);
+}
+
+//==============================================================================
+template <int NumPeaks, typename SampleType = float>
+class MorphChain
+{
+public:
+    static_assert(NumPeaks == 2 || NumPeaks == 4 || NumPeaks == 8, "Unsupported number of peaks");
+
+    static constexpr int numPeaks = NumPeaks;
+    static constexpr int maxChannels = 2;
+
+    using Coefficients = SvfCoefficients<SampleType>;
+    using CoefficientArray = std::array<Coefficients, NumPeaks>;
+
+    void reset()
+    {
+        state = {};
+    }
+
+    static CoefficientArray makeCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        CoefficientArray newCoefficients;
+
+        for( int band = 0; band < NumPeaks; ++band )
+            newCoefficients[band] = makeMorphBandCoefficients<SampleType>(chainSettings, band, NumPeaks, sampleRate);
+
+        return newCoefficients;
+    }
+
+    // Jumps straight to the new design, cancelling any ramp in progress
+    void updateCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        coefficients = target = makeCoefficients(chainSettings, sampleRate);
+        rampSamplesRemaining = 0;
+    }
+
+    void setGainLinear(SampleType newGain)
+    {
+        gain = targetGain = newGain;
+        rampSamplesRemaining = 0;
+    }
+
+    SampleType getGainLinear() const noexcept { return gain; }
+
+    // Ramps like PeakChain::setTarget
+    void setTarget(const CoefficientArray& newTarget, SampleType newTargetGain, int rampLength) noexcept
+    {
+        target = newTarget;
+        targetGain = newTargetGain;
+
+        if( rampLength <= 0 )
+        {
+            coefficients = target;
+            gain = targetGain;
+            rampSamplesRemaining = 0;
+            return;
+        }
+
+        auto scale = SampleType(1) / SampleType(rampLength);
+
+        for( int band = 0; band < NumPeaks; ++band )
+            increments[band] = (target[band] - coefficients[band]) * scale;
+
+        gainIncrement = (targetGain - gain) * scale;
+        rampSamplesRemaining = rampLength;
+    }
+
+    bool isRamping() const noexcept { return rampSamplesRemaining > 0; }
+
+    const CoefficientArray& getCoefficients() const { return coefficients; }
+
+    // Continues from a morph chain with another precision
+    template <typename OtherSampleType>
+    void copyStateFrom(const MorphChain<NumPeaks, OtherSampleType>& other) noexcept
+    {
+        for( int band = 0; band < NumPeaks; ++band )
+        {
+            coefficients[band] = Coefficients(other.coefficients[band]);
+            target[band] = Coefficients(other.target[band]);
+            increments[band] = Coefficients(other.increments[band]);
+
+            for( int ch = 0; ch < maxChannels; ++ch )
+            {
+                state[band].ic1[ch] = SampleType(other.state[band].ic1[ch]);
+                state[band].ic2[ch] = SampleType(other.state[band].ic2[ch]);
+            }
+        }
+
+        copyGainFrom(other);
+    }
+
+    // Continues from a peak cascade of any precision. Each band gets the core with
+    // the biquad's transfer function and the state that continues the biquad's
+    // output, a ramp in progress goes on towards the converted target.
+    template <typename OtherSampleType>
+    void copyStateFrom(const PeakChain<NumPeaks, OtherSampleType>& other) noexcept
+    {
+        for( int band = 0; band < NumPeaks; ++band )
+        {
+            coefficients[band] = Coefficients(other.coefficients[band]);
+            target[band] = Coefficients(other.target[band]);
+
+            double biquadState[2], coreState[2];
+
+            for( int ch = 0; ch < maxChannels; ++ch )
+            {
+                biquadState[0] = double(other.state[band].s1[ch]);
+                biquadState[1] = double(other.state[band].s2[ch]);
+
+                // The transposed direct form's next two outputs without input are
+                // s1 and s2 - a1 s1, they fix every later one
+                double response[2] { biquadState[0], biquadState[1] - double(other.coefficients[band].a1) * biquadState[0] };
+                getCoreState(coefficients[band], response, coreState);
+
+                state[band].ic1[ch] = SampleType(coreState[0]);
+                state[band].ic2[ch] = SampleType(coreState[1]);
+            }
+        }
+
+        copyGainFrom(other);
+        updateIncrements();
+    }
+
+    // Hands the running filter over to a peak cascade of any precision
+    template <typename OtherSampleType>
+    void copyStateTo(PeakChain<NumPeaks, OtherSampleType>& other) const noexcept
+    {
+        using OtherCoefficients = BiquadCoefficients<OtherSampleType>;
+
+        for( int band = 0; band < NumPeaks; ++band )
+        {
+            other.coefficients[band] = OtherCoefficients(coefficients[band]);
+            other.target[band] = OtherCoefficients(target[band]);
+
+            for( int ch = 0; ch < maxChannels; ++ch )
+            {
+                double response[2];
+                getZeroInputResponse(coefficients[band], double(state[band].ic1[ch]), double(state[band].ic2[ch]), response);
+
+                auto s1 = response[0];
+                other.state[band].s1[ch] = OtherSampleType(s1);
+                other.state[band].s2[ch] = OtherSampleType(response[1] + double(other.coefficients[band].a1) * s1);
+            }
+        }
+
+        other.gain = OtherSampleType(gain);
+        other.targetGain = OtherSampleType(targetGain);
+        other.gainIncrement = OtherSampleType(gainIncrement);
+        other.rampSamplesRemaining = rampSamplesRemaining;
+
+        if( rampSamplesRemaining > 0 )
+        {
+            auto scale = OtherSampleType(1) / OtherSampleType(rampSamplesRemaining);
+
+            for( int band = 0; band < NumPeaks; ++band )
+                other.increments[band] = (other.target[band] - other.coefficients[band]) * scale;
+        }
+    }
+
+    // Kernel variant used by process(), see PeakKernels.cpp
+    using ProcessFunction = void (*)(MorphChain&, SampleType* const*, int, int) noexcept;
+
+    void setProcessFunction(ProcessFunction newFunction) noexcept { processFunction = newFunction; }
+
+    static void processGeneric(MorphChain& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        chain.processInline(channels, numChannels, numSamples);
+    }
+
+    // Processes up to two channels in place, output gain included
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        processFunction(*this, channels, numChannels, numSamples);
+    }
+
+    // The kernel body, inlined into each instruction set variant
+    PEAK_CHAIN_FORCEINLINE void processInline(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if( numChannels >= 2 )
+            processChannels<2>(channels, numSamples);
+        else if( numChannels == 1 )
+            processChannels<1>(channels, numSamples);
+        else
+            processChannels<0>(channels, numSamples);
+    }
+
+private:
+    template <int, typename> friend class MorphChain;
+
+    // Integrator states of one band, with the channels side by side
+    struct BandState
+    {
+        std::array<SampleType, maxChannels> ic1 {}, ic2 {};
+    };
+
+    using BandStates = std::array<BandState, NumPeaks>;
+
+    template <typename Other>
+    void copyGainFrom(const Other& other) noexcept
+    {
+        gain = SampleType(other.gain);
+        targetGain = SampleType(other.targetGain);
+        gainIncrement = SampleType(other.gainIncrement);
+        rampSamplesRemaining = other.rampSamplesRemaining;
+    }
+
+    void updateIncrements() noexcept
+    {
+        if( rampSamplesRemaining <= 0 )
+            return;
+
+        auto scale = SampleType(1) / SampleType(rampSamplesRemaining);
+
+        for( int band = 0; band < NumPeaks; ++band )
+            increments[band] = (target[band] - coefficients[band]) * scale;
+    }
+
+    // The core's next two outputs without input, from its integrator states
+    static void getZeroInputResponse(const Coefficients& c, double ic1, double ic2, double* response) noexcept
+    {
+        auto a1 = double(c.a1), a2 = double(c.a2), a3 = double(c.a3);
+        auto m1 = double(c.m1), m2 = double(c.m2);
+
+        for( int n = 0; n < 2; ++n )
+        {
+            auto v1 = a1 * ic1 - a2 * ic2;
+            auto v2 = a2 * ic1 + (1.0 - a3) * ic2;
+
+            response[n] = m1 * v1 + m2 * v2;
+
+            ic1 = 2.0 * v1 - ic1;
+            ic2 = 2.0 * v2 - ic2;
+        }
+    }
+
+    // The integrator states whose output without input starts with the given two
+    // samples. A mix that hides part of the state, like a flat response, can't
+    // reproduce every decay: the least squares fit then drops what it can't show.
+    static void getCoreState(const Coefficients& c, const double* response, double* coreState) noexcept
+    {
+        double map[2][2], column[2];
+
+        for( int i = 0; i < 2; ++i )
+        {
+            getZeroInputResponse(c, i == 0 ? 1.0 : 0.0, i == 1 ? 1.0 : 0.0, column);
+            map[0][i] = column[0];
+            map[1][i] = column[1];
+        }
+
+        // Normal equations with a small ridge, well-posed whenever the map is
+        auto n00 = map[0][0] * map[0][0] + map[1][0] * map[1][0];
+        auto n01 = map[0][0] * map[0][1] + map[1][0] * map[1][1];
+        auto n11 = map[0][1] * map[0][1] + map[1][1] * map[1][1];
+        auto ridge = 1.0e-12 * (n00 + n11) + 1.0e-300;
+
+        n00 += ridge;
+        n11 += ridge;
+
+        auto r0 = map[0][0] * response[0] + map[1][0] * response[1];
+        auto r1 = map[0][1] * response[0] + map[1][1] * response[1];
+        auto determinant = n00 * n11 - n01 * n01;
+
+        coreState[0] = (n11 * r0 - n01 * r1) / determinant;
+        coreState[1] = (n00 * r1 - n01 * r0) / determinant;
+    }
+
+    template <int NumChannels>
+    PEAK_CHAIN_FORCEINLINE void processChannels(SampleType* const* channels, int numSamples) noexcept
+    {
+        // Work on local copies, the compiler cannot keep members in registers
+        // because the sample pointers might alias them
+        auto c = coefficients;
+        auto g = gain;
+        auto st = state;
+
+        auto numRampSamples = std::min(numSamples, rampSamplesRemaining);
+        int i = 0;
+
+        for( ; i < numRampSamples; ++i )
+        {
+            for( int band = 0; band < NumPeaks; ++band )
+                c[band] += increments[band];
+
+            g += gainIncrement;
+
+            processFrame<NumChannels>(channels, i, c, g, st);
+        }
+
+        if( numRampSamples > 0 )
+        {
+            rampSamplesRemaining -= numRampSamples;
+
+            // Land exactly on the target rather than on the accumulated increments
+            if( rampSamplesRemaining == 0 )
+            {
+                c = target;
+                g = targetGain;
+            }
+        }
+
+        for( ; i < numSamples; ++i )
+            processFrame<NumChannels>(channels, i, c, g, st);
+
+        coefficients = c;
+        gain = g;
+        state = st;
+    }
+
+    template <int NumChannels>
+    static PEAK_CHAIN_FORCEINLINE void processFrame(SampleType* const* channels, int index,
+                                                    const CoefficientArray& c, SampleType g, BandStates& st) noexcept
+    {
+        std::array<SampleType, NumChannels> x;
+
+        for( int ch = 0; ch < NumChannels; ++ch )
+            x[ch] = channels[ch][index];
+
+        processBands(x, c, st, std::make_index_sequence<NumPeaks>());
+
+        for( int ch = 0; ch < NumChannels; ++ch )
+            channels[ch][index] = g * x[ch];
+    }
+
+    template <size_t NumChannels, size_t... Bands>
+    static PEAK_CHAIN_FORCEINLINE void processBands(std::array<SampleType, NumChannels>& x, const CoefficientArray& c,
+                                                    BandStates& st, std::index_sequence<Bands...>) noexcept
+    {
+        (processBand(x, c[Bands], st[Bands]), ...);
+    }
+
+    template <size_t NumChannels>
+    static PEAK_CHAIN_FORCEINLINE void processBand(std::array<SampleType, NumChannels>& x, const Coefficients& c, BandState& s) noexcept
+    {
+        for( size_t ch = 0; ch < NumChannels; ++ch )
+        {
+            auto v3 = x[ch] - s.ic2[ch];
+            auto v1 = c.a1 * s.ic1[ch] + c.a2 * v3;
+            auto v2 = s.ic2[ch] + c.a2 * s.ic1[ch] + c.a3 * v3;
+
+            s.ic1[ch] = SampleType(2) * v1 - s.ic1[ch];
+            s.ic2[ch] = SampleType(2) * v2 - s.ic2[ch];
+
+            x[ch] = c.m0 * x[ch] + c.m1 * v1 + c.m2 * v2;
+        }
+    }
+
+    CoefficientArray coefficients, target, increments;
+    BandStates state;
+    SampleType gain { 1 }, targetGain { 1 }, gainIncrement { 0 };
+    int rampSamplesRemaining { 0 };
+
+    ProcessFunction processFunction { &MorphChain::processGeneric };
+};
+
+// Hand-overs between the cores, in any precision
+template <int NumPeaks, typename To, typename From>
+void transferChainState(MorphChain<NumPeaks, To>& to, const MorphChain<NumPeaks, From>& from) noexcept
+{
+    to.copyStateFrom(from);
+}
+
+template <int NumPeaks, typename To, typename From>
+void transferChainState(MorphChain<NumPeaks, To>& to, const PeakChain<NumPeaks, From>& from) noexcept
+{
+    to.copyStateFrom(from);
+}
+
+template <int NumPeaks, typename To, typename From>
+void transferChainState(PeakChain<NumPeaks, To>& to, const MorphChain<NumPeaks, From>& from) noexcept
+{
+    from.copyStateTo(to);
+}
+
+// The parallel form goes through its serial equivalent
+template <int NumPeaks, typename To, typename From>
+void transferChainState(MorphChain<NumPeaks, To>& to, const ParallelPeakChain<NumPeaks, From>& from) noexcept
+{
+    PeakChain<NumPeaks, double> serial;
+    from.copyStateTo(serial);
+    to.copyStateFrom(serial);
+}
+
+template <int NumPeaks, typename To, typename From>
+void transferChainState(ParallelPeakChain<NumPeaks, To>& to, const MorphChain<NumPeaks, From>& from) noexcept
+{
+    PeakChain<NumPeaks, double> serial;
+    from.copyStateTo(serial);
+    to.copyStateFrom(serial);
+}
+
+//==============================================================================
+// Instruction set variants of the morph kernel, defined in PeakKernels.cpp
+template <int NumPeaks, typename SampleType>
+typename MorphChain<NumPeaks, SampleType>::ProcessFunction getMorphKernelFunction(PeakKernel kernel);
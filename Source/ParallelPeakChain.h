@@ -0,0 +1,639 @@
+/*
+  ==============================================================================
+
+    ParallelPeakChain.h
+
+    The peak cascade rewritten as a sum of second-order sections plus a direct
+    term, the partial fraction expansion of the cascade's transfer function.
+    The sections don't depend on each other, so per sample they run side by
+    side in SIMD lanes instead of as a chain of dependent biquads.
+
+    The parallel form runs while the design holds still, which is most of the
+    time. Ramps run in the embedded serial PeakChain: interpolating residues
+    doesn't sweep the response the way interpolating the serial sections does.
+    Designs whose expansion would cost precision, where peaks share or nearly
+    share their poles (e.g. at SPAN 0), stay serial too, and so do designs whose
+    state couldn't be carried back into the serial form accurately. Switching
+    between the forms carries the filter state over, so the signal runs on
+    without a click.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <complex>
+#include <limits>
+
+#include "PeakChain.h"
+
+// H(z) = direct + sum over k of (b0[k] + b1[k] z^-1) / (1 + a1[k] z^-1 + a2[k] z^-2)
+template <typename SampleType, int NumSections>
+struct ParallelCoefficients
+{
+    using Array = std::array<SampleType, NumSections>;
+
+    SampleType direct { 1 };
+    Array b0 {}, b1 {}, a1 {}, a2 {};
+
+    template <typename OtherType>
+    explicit operator ParallelCoefficients<OtherType, NumSections>() const noexcept
+    {
+        ParallelCoefficients<OtherType, NumSections> result;
+        result.direct = OtherType(direct);
+
+        for( int k = 0; k < NumSections; ++k )
+        {
+            result.b0[k] = OtherType(b0[k]);
+            result.b1[k] = OtherType(b1[k]);
+            result.a1[k] = OtherType(a1[k]);
+            result.a2[k] = OtherType(a2[k]);
+        }
+
+        return result;
+    }
+};
+
+namespace ParallelForm
+{
+    // How much larger the sections' own peaks may be than the response they sum
+    // to. Close poles give sections with large, opposite responses that cancel,
+    // and every factor of 2 costs the single precision sum a bit.
+    constexpr double maxCancellation = 16.0;
+    constexpr double responseTolerance = 1.0e-6;
+
+    // Roots of 1 + a1 x + a2 x^2 in x = z^-1, the reciprocals of a section's poles.
+    // False if they coincide or the section has no second pole.
+    inline bool getRoots(double a1, double a2, std::complex<double>& x1, std::complex<double>& x2) noexcept
+    {
+        if( a2 == 0.0 )
+            return false;
+
+        auto root = std::sqrt(std::complex<double>(a1 * a1 - 4.0 * a2));
+        x1 = (-a1 + root) / (2.0 * a2);
+        x2 = (-a1 - root) / (2.0 * a2);
+
+        return std::abs(x1 - x2) >= 1.0e-9 * std::abs(x1);
+    }
+
+    // Partial fraction expansion of a cascade of biquads. The sections keep their
+    // poles and get first-order numerators b0 + b1 z^-1, found from the residues at
+    // the two poles of each section: there every other term of the sum vanishes, so
+    //     b0 + b1 x = prod B_j(x) / prod_{j != k} A_j(x)    for x = 1 / pole of A_k
+    // The direct term is the cascade's limit for z^-1 towards infinity.
+    // False if poles are too close for a usable expansion.
+    template <int NumSections>
+    bool decompose(const std::array<BiquadCoefficients<double>, NumSections>& sections,
+                   ParallelCoefficients<double, NumSections>& result) noexcept
+    {
+        using Complex = std::complex<double>;
+
+        // A band whose zeros cancel its poles, a peak at 0 dB or pushed up to Nyquist,
+        // is a factor of 1. Its section keeps the poles but not a numerator, so it can
+        // still carry a tail of the band's ringing over from the serial form.
+        std::array<bool, NumSections> isUnity;
+
+        for( int k = 0; k < NumSections; ++k )
+        {
+            auto& c = sections[k];
+            isUnity[k] = std::abs(c.b0 - 1.0) + std::abs(c.b1 - c.a1) + std::abs(c.b2 - c.a2) < 1.0e-12;
+        }
+
+        auto evaluate = [&sections, &isUnity](Complex x, int excludedSection)
+        {
+            Complex value(1.0);
+
+            for( int j = 0; j < NumSections; ++j )
+            {
+                if( isUnity[j] )
+                    continue;
+
+                auto& c = sections[j];
+                value *= c.b0 + x * (c.b1 + x * c.b2);
+
+                if( j != excludedSection )
+                    value /= 1.0 + x * (c.a1 + x * c.a2);
+            }
+
+            return value;
+        };
+
+        result.direct = 1.0;
+
+        for( int k = 0; k < NumSections; ++k )
+        {
+            auto& c = sections[k];
+
+            Complex x1, x2;
+            auto hasDistinctPoles = getRoots(c.a1, c.a2, x1, x2);
+
+            if( isUnity[k] )
+            {
+                result.b0[k] = result.b1[k] = 0.0;
+                result.a1[k] = hasDistinctPoles ? c.a1 : 0.0;
+                result.a2[k] = hasDistinctPoles ? c.a2 : 0.0;
+                continue;
+            }
+
+            if( ! hasDistinctPoles )
+                return false;
+
+            result.direct *= c.b2 / c.a2;
+
+            auto v1 = evaluate(x1, k), v2 = evaluate(x2, k);
+            auto slope = (v1 - v2) / (x1 - x2);
+
+            result.b0[k] = (v1 - slope * x1).real();
+            result.b1[k] = slope.real();
+            result.a1[k] = c.a1;
+            result.a2[k] = c.a2;
+        }
+
+        // Check the expansion against the cascade at DC, Nyquist and the pole angles,
+        // where the peaks are
+        double peak = 0.0, sectionPeakSum = std::abs(result.direct), maxError = 0.0;
+
+        for( int i = -2; i < NumSections; ++i )
+        {
+            auto w = i == -2 ? 0.0 : 3.14159265358979323846;
+
+            if( i >= 0 && ! isUnity[i] && sections[i].a2 > 0.0 )
+                w = std::acos(std::clamp(-sections[i].a1 / (2.0 * std::sqrt(sections[i].a2)), -1.0, 1.0));
+
+            auto z1 = std::polar(1.0, -w), z2 = z1 * z1;
+
+            std::complex<double> cascade(1.0), parallel(result.direct);
+
+            for( int k = 0; k < NumSections; ++k )
+            {
+                auto a = 1.0 + sections[k].a1 * z1 + sections[k].a2 * z2;
+                cascade *= (sections[k].b0 + sections[k].b1 * z1 + sections[k].b2 * z2) / a;
+                auto section = (result.b0[k] + result.b1[k] * z1) / a;
+                parallel += section;
+
+                // A section's peak is at its pole angle
+                if( k == i )
+                    sectionPeakSum += std::abs(section);
+            }
+
+            peak = std::max(peak, std::abs(cascade));
+            maxError = std::max(maxError, std::abs(parallel - cascade));
+        }
+
+        return std::isfinite(sectionPeakSum)
+            && sectionPeakSum <= maxCancellation * std::max(1.0, peak)
+            && maxError <= responseTolerance * std::max(1.0, peak);
+    }
+
+    //==============================================================================
+    // Both forms realise the same transfer function with two states per section,
+    // so the state of one carries over into the other. A section's zero-input
+    // output is (s1 + s2 z^-1) / A(z), and the serial chain's is a sum of the same
+    // terms, one per pole pair. The parallel states are found from that sum at
+    // the poles, like the numerators in decompose().
+    template <int NumSections>
+    void getParallelState(const std::array<BiquadCoefficients<double>, NumSections>& sections,
+                          const ParallelCoefficients<double, NumSections>& expansion,
+                          const double* serialState, double* parallelState) noexcept
+    {
+        using Complex = std::complex<double>;
+
+        for( int k = 0; k < NumSections; ++k )
+        {
+            Complex x1, x2;
+
+            if( ! getRoots(expansion.a1[k], expansion.a2[k], x1, x2) )
+            {
+                parallelState[2 * k] = parallelState[2 * k + 1] = 0.0;
+                continue;
+            }
+
+            // The serial zero-input output times A_k. Terms entering after section k
+            // are multiplied by A_k and vanish at its roots.
+            auto evaluate = [&](Complex x)
+            {
+                Complex y(0.0);
+
+                for( int j = 0; j < NumSections; ++j )
+                {
+                    auto& c = sections[j];
+                    auto numerator = (c.b0 + x * (c.b1 + x * c.b2)) * y;
+
+                    if( j <= k )
+                        numerator += serialState[2 * j] + serialState[2 * j + 1] * x;
+
+                    y = j == k ? numerator : numerator / (1.0 + x * (c.a1 + x * c.a2));
+                }
+
+                return y;
+            };
+
+            auto v1 = evaluate(x1), v2 = evaluate(x2);
+            auto slope = (v1 - v2) / (x1 - x2);
+
+            parallelState[2 * k] = (v1 - slope * x1).real();
+            parallelState[2 * k + 1] = slope.real();
+        }
+    }
+
+    // The inverse, solved section by section. At the poles of section k the parallel
+    // state only sees the serial states up to k, and section k's own enters as
+    //     P_k(x) = (B_k(x) y_k-1(x) + S_k(x)) prod_{j > k} B_j(x) / A_j(x)
+    // with y_k-1 the zero-input output of the sections before it, known by then.
+    // False if a later section's zeros hide the poles of an earlier one.
+    template <int NumSections>
+    bool getSerialState(const std::array<BiquadCoefficients<double>, NumSections>& sections,
+                        const ParallelCoefficients<double, NumSections>& expansion,
+                        const double* parallelState, double* serialState) noexcept
+    {
+        using Complex = std::complex<double>;
+
+        for( int k = 0; k < NumSections; ++k )
+        {
+            serialState[2 * k] = serialState[2 * k + 1] = 0.0;
+
+            // A unity band without a second pole has no parallel state to come from
+            Complex x1, x2;
+
+            if( ! getRoots(expansion.a1[k], expansion.a2[k], x1, x2) )
+                continue;
+
+            auto evaluate = [&](Complex x)
+            {
+                Complex y(0.0);
+
+                for( int j = 0; j < k; ++j )
+                {
+                    auto& c = sections[j];
+                    y = ((c.b0 + x * (c.b1 + x * c.b2)) * y + serialState[2 * j] + serialState[2 * j + 1] * x)
+                      / (1.0 + x * (c.a1 + x * c.a2));
+                }
+
+                Complex later(1.0);
+
+                for( int j = k + 1; j < NumSections; ++j )
+                {
+                    auto& c = sections[j];
+                    later *= (c.b0 + x * (c.b1 + x * c.b2)) / (1.0 + x * (c.a1 + x * c.a2));
+                }
+
+                auto& c = sections[k];
+                return (parallelState[2 * k] + parallelState[2 * k + 1] * x) / later - (c.b0 + x * (c.b1 + x * c.b2)) * y;
+            };
+
+            auto v1 = evaluate(x1), v2 = evaluate(x2);
+
+            if( ! std::isfinite(std::abs(v1)) || ! std::isfinite(std::abs(v2)) )
+                return false;
+
+            auto slope = (v1 - v2) / (x1 - x2);
+
+            serialState[2 * k] = (v1 - slope * x1).real();
+            serialState[2 * k + 1] = slope.real();
+        }
+
+        return true;
+    }
+
+    // Both maps are exact, but the parallel state is rounded as the chain runs and the
+    // serial state it maps back to can come out far less accurate: close poles give
+    // large parallel states that cancel. This bounds the damage, the Skeel condition
+    // number of the map, max over i of (|S| |P| 1)_i with P the map to the parallel
+    // form and S its inverse. Parallel states accurate to a relative eps map back to
+    // serial states within eps times this of the largest one.
+    template <int NumSections>
+    double getStateConditioning(const std::array<BiquadCoefficients<double>, NumSections>& sections,
+                                const ParallelCoefficients<double, NumSections>& expansion) noexcept
+    {
+        constexpr int numStates = 2 * NumSections;
+
+        // Row sums of |P|, and S column by column
+        double parallelSums[numStates] {};
+        double inverse[numStates][numStates];
+
+        for( int j = 0; j < numStates; ++j )
+        {
+            double unit[numStates] {}, column[numStates];
+            unit[j] = 1.0;
+
+            getParallelState<NumSections>(sections, expansion, unit, column);
+
+            for( int i = 0; i < numStates; ++i )
+                parallelSums[i] += std::abs(column[i]);
+
+            if( ! getSerialState<NumSections>(sections, expansion, unit, column) )
+                return std::numeric_limits<double>::infinity();
+
+            for( int i = 0; i < numStates; ++i )
+                inverse[i][j] = column[i];
+        }
+
+        double conditioning = 0.0;
+
+        for( int i = 0; i < numStates; ++i )
+        {
+            double sum = 0.0;
+
+            for( int j = 0; j < numStates; ++j )
+                sum += std::abs(inverse[i][j]) * parallelSums[j];
+
+            conditioning = std::max(conditioning, sum);
+        }
+
+        return conditioning;
+    }
+
+    // How far a stretch in the parallel form may move the serial state, relative to its
+    // largest element. About 80 roundings in single precision: any more and the state
+    // that carries into a ramp or a jump audibly differs from the serial chain's.
+    constexpr double maxStateDrift = 1.0e-5;
+}
+
+//==============================================================================
+template <int NumPeaks, typename SampleType = float>
+class ParallelPeakChain
+{
+public:
+    static_assert(NumPeaks == 2 || NumPeaks == 4 || NumPeaks == 8, "Unsupported number of peaks");
+
+    static constexpr int numPeaks = NumPeaks;
+    static constexpr int maxChannels = 2;
+
+    using SerialChain = PeakChain<NumPeaks, SampleType>;
+    using Coefficients = BiquadCoefficients<SampleType>;
+    using CoefficientArray = std::array<Coefficients, NumPeaks>;
+
+    void reset()
+    {
+        serial.reset();
+        state = {};
+    }
+
+    static CoefficientArray makeCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        return SerialChain::makeCoefficients(chainSettings, sampleRate);
+    }
+
+    // Jumps straight to the new design, cancelling any ramp in progress
+    void updateCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        setTarget(makeCoefficients(chainSettings, sampleRate), getGainLinear(), 0);
+    }
+
+    void setGainLinear(SampleType newGain)
+    {
+        serial.setGainLinear(newGain);
+        gain = newGain;
+    }
+
+    SampleType getGainLinear() const noexcept { return serial.getGainLinear(); }
+
+    // Ramps like PeakChain::setTarget. The ramp runs in the serial form, the chain
+    // moves to the parallel form once it has settled on a design with an expansion.
+    void setTarget(const CoefficientArray& newTarget, SampleType newTargetGain, int rampLength) noexcept
+    {
+        switchToSerial();
+        serial.setTarget(newTarget, newTargetGain, rampLength);
+        needsExpansion = true;
+
+        if( ! serial.isRamping() )
+            trySwitchToParallel();
+    }
+
+    bool isRamping() const noexcept { return serial.isRamping(); }
+    bool isParallel() const noexcept { return useParallel; }
+
+    // The serial design, which the serial chain keeps up to date in either form
+    const CoefficientArray& getCoefficients() const { return serial.getCoefficients(); }
+
+    // Continues from a serial chain of any precision, ramp included
+    template <typename OtherSampleType>
+    void copyStateFrom(const PeakChain<NumPeaks, OtherSampleType>& other) noexcept
+    {
+        serial.copyStateFrom(other);
+        useParallel = false;
+        needsExpansion = true;
+
+        if( ! serial.isRamping() )
+            trySwitchToParallel();
+    }
+
+    // Hands the running filter over to a serial chain of any precision
+    template <typename OtherSampleType>
+    void copyStateTo(PeakChain<NumPeaks, OtherSampleType>& other) const noexcept
+    {
+        auto copy = *this;
+        copy.switchToSerial();
+        other.copyStateFrom(copy.serial);
+    }
+
+    // Kernel variants of the parallel form, like PeakChain's, see PeakKernels.cpp.
+    // The serial chain keeps its own.
+    using ProcessFunction = void (*)(ParallelPeakChain&, SampleType* const*, int, int) noexcept;
+
+    void setProcessFunctions(ProcessFunction newFunction, typename SerialChain::ProcessFunction serialFunction) noexcept
+    {
+        processFunction = newFunction;
+        serial.setProcessFunction(serialFunction);
+    }
+
+    static void processGeneric(ParallelPeakChain& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        chain.processInline(channels, numChannels, numSamples);
+    }
+
+    // Processes up to two channels in place, output gain included
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        // A ramp that ran out since the last call leaves the chain settled
+        if( needsExpansion && ! serial.isRamping() )
+            trySwitchToParallel();
+
+        if( useParallel )
+            processFunction(*this, channels, numChannels, numSamples);
+        else
+            serial.process(channels, numChannels, numSamples);
+    }
+
+    // The parallel kernel body, inlined into each instruction set variant
+    PEAK_CHAIN_FORCEINLINE void processInline(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if( numChannels >= 2 )
+            processChannels<2>(channels, numSamples);
+        else if( numChannels == 1 )
+            processChannels<1>(channels, numSamples);
+        else
+            processChannels<0>(channels, numSamples);
+    }
+
+private:
+    using Parallel = ParallelCoefficients<SampleType, NumPeaks>;
+
+    // Section states with the sections side by side, so a vector holds the
+    // states of several sections
+    struct ChannelState
+    {
+        std::array<SampleType, NumPeaks> s1 {}, s2 {};
+    };
+
+    using ChannelStates = std::array<ChannelState, maxChannels>;
+
+    SerialChain serial;
+    bool useParallel { false }, needsExpansion { false };
+
+    Parallel coefficients;
+    ChannelStates state;
+    SampleType gain { 1 };
+
+    // Exact in double precision, the state transfer needs them
+    ParallelCoefficients<double, NumPeaks> expansion;
+
+    ProcessFunction processFunction { &ParallelPeakChain::processGeneric };
+
+    static std::array<BiquadCoefficients<double>, NumPeaks> toDouble(const CoefficientArray& sections) noexcept
+    {
+        std::array<BiquadCoefficients<double>, NumPeaks> result;
+
+        for( int k = 0; k < NumPeaks; ++k )
+            result[k] = BiquadCoefficients<double>(sections[k]);
+
+        return result;
+    }
+
+    // Called once per settled design, so the expansion isn't computed at control rate
+    void trySwitchToParallel() noexcept
+    {
+        needsExpansion = false;
+
+        auto sections = toDouble(serial.getCoefficients());
+
+        if( ! ParallelForm::decompose<NumPeaks>(sections, expansion) )
+            return;
+
+        // The chain has to get back to the serial form for the next ramp with the state
+        // it would have had there, designs that can't promise that stay serial
+        auto drift = ParallelForm::getStateConditioning<NumPeaks>(sections, expansion)
+                   * double(std::numeric_limits<SampleType>::epsilon());
+
+        if( ! (drift <= ParallelForm::maxStateDrift) )
+            return;
+
+        for( int ch = 0; ch < maxChannels; ++ch )
+        {
+            double serialState[2 * NumPeaks], parallelState[2 * NumPeaks];
+
+            for( int k = 0; k < NumPeaks; ++k )
+            {
+                serialState[2 * k] = double(serial.state[k].s1[ch]);
+                serialState[2 * k + 1] = double(serial.state[k].s2[ch]);
+            }
+
+            ParallelForm::getParallelState<NumPeaks>(sections, expansion, serialState, parallelState);
+
+            for( int k = 0; k < NumPeaks; ++k )
+            {
+                state[ch].s1[k] = SampleType(parallelState[2 * k]);
+                state[ch].s2[k] = SampleType(parallelState[2 * k + 1]);
+            }
+        }
+
+        coefficients = Parallel(expansion);
+        gain = serial.getGainLinear();
+        useParallel = true;
+    }
+
+    void switchToSerial() noexcept
+    {
+        if( ! useParallel )
+            return;
+
+        auto sections = toDouble(serial.getCoefficients());
+
+        for( int ch = 0; ch < maxChannels; ++ch )
+        {
+            double parallelState[2 * NumPeaks], serialState[2 * NumPeaks];
+
+            for( int k = 0; k < NumPeaks; ++k )
+            {
+                parallelState[2 * k] = double(state[ch].s1[k]);
+                parallelState[2 * k + 1] = double(state[ch].s2[k]);
+            }
+
+            // Can't fail, getStateConditioning() ran the same map before the switch
+            ParallelForm::getSerialState<NumPeaks>(sections, expansion, parallelState, serialState);
+
+            for( int k = 0; k < NumPeaks; ++k )
+            {
+                serial.state[k].s1[ch] = SampleType(serialState[2 * k]);
+                serial.state[k].s2[ch] = SampleType(serialState[2 * k + 1]);
+            }
+        }
+
+        useParallel = false;
+    }
+
+    template <int NumChannels>
+    PEAK_CHAIN_FORCEINLINE void processChannels(SampleType* const* channels, int numSamples) noexcept
+    {
+        // Local copies, as in PeakChain, so the compiler keeps them in registers
+        auto c = coefficients;
+        auto st = state;
+
+        for( int i = 0; i < numSamples; ++i )
+            processFrame<NumChannels>(channels, i, c, gain, st);
+
+        state = st;
+    }
+
+    template <int NumChannels>
+    static PEAK_CHAIN_FORCEINLINE void processFrame(SampleType* const* channels, int index,
+                                                    const Parallel& c, SampleType g, ChannelStates& st) noexcept
+    {
+        for( int ch = 0; ch < NumChannels; ++ch )
+        {
+            auto x = channels[ch][index];
+            auto& s = st[ch];
+
+            // The sections are independent, so this loop vectorises across them
+            std::array<SampleType, NumPeaks> v;
+
+            for( int k = 0; k < NumPeaks; ++k )
+            {
+                v[k] = c.b0[k] * x + s.s1[k];
+                s.s1[k] = c.b1[k] * x - c.a1[k] * v[k] + s.s2[k];
+                s.s2[k] = -c.a2[k] * v[k];
+            }
+
+            auto sum = c.direct * x;
+
+            for( int k = 0; k < NumPeaks; ++k )
+                sum += v[k];
+
+            channels[ch][index] = g * sum;
+        }
+    }
+};
+
+// Hands the running filter between chains of any form and precision
+template <int NumPeaks, typename To, typename From>
+void transferChainState(PeakChain<NumPeaks, To>& to, const PeakChain<NumPeaks, From>& from) noexcept
+{
+    to.copyStateFrom(from);
+}
+
+template <int NumPeaks, typename To, typename From>
+void transferChainState(PeakChain<NumPeaks, To>& to, const ParallelPeakChain<NumPeaks, From>& from) noexcept
+{
+    from.copyStateTo(to);
+}
+
+template <int NumPeaks, typename To, typename From>
+void transferChainState(ParallelPeakChain<NumPeaks, To>& to, const PeakChain<NumPeaks, From>& from) noexcept
+{
+    to.copyStateFrom(from);
+}
+
+//==============================================================================
+// Instruction set variants of the parallel kernel, defined in PeakKernels.cpp
+template <int NumPeaks, typename SampleType>
+typename ParallelPeakChain<NumPeaks, SampleType>::ProcessFunction getParallelPeakKernelFunction(PeakKernel kernel);
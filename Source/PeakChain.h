@@ -0,0 +1,493 @@
+/*
+  ==============================================================================
+
+    PeakChain.h
+
+    N-band peak chain. The number of peaks is a compile-time constant, so the
+    per-sample loop over the bands is unrolled and each band count gets its own
+    specialised kernel. SPAN spreads the peaks geometrically above FREQ and BAL
+    tilts the gain from the lowest to the highest peak.
+
+    Coefficient changes can be ramped linearly sample by sample inside the
+    kernel, so a new design only has to be computed at control rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+#if defined(__GNUC__) || defined(__clang__)
+ #define PEAK_CHAIN_FORCEINLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+ #define PEAK_CHAIN_FORCEINLINE __forceinline
+#else
+ #define PEAK_CHAIN_FORCEINLINE inline
+#endif
+
+// How a peak's analog prototype is turned into biquad coefficients
+enum class PeakDesign
+{
+    bilinear,   // RBJ cookbook, the peak cramps towards Nyquist
+    matched     // Magnitude matched to the analog peak up to Nyquist
+};
+
+// Where Pitch Track takes FREQ from, see PitchTracker.h
+enum class PitchTrackSource
+{
+    off,        // FREQ as set
+    input,      // The fundamental of the input
+    sidechain   // The fundamental of the sidechain, or of the input without one
+};
+
+struct ChainSettings
+{
+    float peak1Freq { 0 }, peak1GainInDecibels { 0 }, peak1Quality { 1.f },
+    peak2Freq { 0 }, peak2GainInDecibels { 0 }, peak2Quality { 1.f },
+    span { 0 }, balance { 0 }, outputGain { 0.f };
+
+    int numPeaks { 2 };
+    PeakDesign design { PeakDesign::bilinear };
+
+    float morph { 0 };      // 0 peak, 1 low shelf, 2 high shelf, 3 band-pass, 4 notch, see MorphChain.h
+
+    bool saturate { false };
+    float drive { 0 };      // Decibels into the saturator, see Saturator.h
+
+    float snapshotMorph { 0 };  // 0 the parameters as they are, above it from snapshot A to B, see SnapshotMorph.h
+
+    bool autoGain { false };    // Make-up gain from the response on top of the chain gain, see AutoGain.h
+
+    bool keyTrack { false };    // The held MIDI notes' voices instead of the bands, see VoiceBank.h
+
+    PitchTrackSource pitchTrack { PitchTrackSource::off };
+};
+
+// Band counts selectable with the "Bands" parameter
+constexpr int peakChainSizes[] { 2, 4, 8 };
+constexpr int maxNumPeaks = 8;
+
+template <typename SampleType>
+struct BiquadCoefficients
+{
+    SampleType b0 { 1 }, b1 { 0 }, b2 { 0 }, a1 { 0 }, a2 { 0 };
+
+    // Element-wise arithmetic, used to ramp linearly between two designs
+    BiquadCoefficients& operator+= (const BiquadCoefficients& other) noexcept
+    {
+        b0 += other.b0; b1 += other.b1; b2 += other.b2; a1 += other.a1; a2 += other.a2;
+        return *this;
+    }
+
+    BiquadCoefficients operator+ (const BiquadCoefficients& other) const noexcept
+    {
+        return { b0 + other.b0, b1 + other.b1, b2 + other.b2, a1 + other.a1, a2 + other.a2 };
+    }
+
+    BiquadCoefficients operator- (const BiquadCoefficients& other) const noexcept
+    {
+        return { b0 - other.b0, b1 - other.b1, b2 - other.b2, a1 - other.a1, a2 - other.a2 };
+    }
+
+    BiquadCoefficients operator* (SampleType factor) const noexcept
+    {
+        return { b0 * factor, b1 * factor, b2 * factor, a1 * factor, a2 * factor };
+    }
+
+    // Conversion to another precision, e.g. BiquadCoefficients<double>(floatCoefficients)
+    template <typename OtherType>
+    explicit operator BiquadCoefficients<OtherType>() const noexcept
+    {
+        return { OtherType(b0), OtherType(b1), OtherType(b2), OtherType(a1), OtherType(a2) };
+    }
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const
+    {
+        // |H(e^jw)| evaluated directly from the numerator and denominator
+        auto w = 2.0 * 3.14159265358979323846 * frequency / sampleRate;
+        auto c1 = std::cos(w), s1 = std::sin(w);
+        auto c2 = std::cos(2.0 * w), s2 = std::sin(2.0 * w);
+
+        auto numRe = double(b0) + double(b1) * c1 + double(b2) * c2;
+        auto numIm = -(double(b1) * s1 + double(b2) * s2);
+        auto denRe = 1.0 + double(a1) * c1 + double(a2) * c2;
+        auto denIm = -(double(a1) * s1 + double(a2) * s2);
+
+        return std::sqrt((numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm));
+    }
+};
+
+template <typename SampleType>
+BiquadCoefficients<SampleType> makePeakCoefficients(double sampleRate, double frequency, double quality, double gainFactor)
+{
+    // Same design as juce::dsp::IIR::Coefficients::makePeakFilter, without the heap allocation
+    auto A = std::sqrt(std::max(0.0, gainFactor));
+    auto omega = (2.0 * 3.14159265358979323846 * frequency) / sampleRate;
+    auto alpha = std::sin(omega) / (quality * 2.0);
+    auto c2 = -2.0 * std::cos(omega);
+    auto alphaTimesA = alpha * A;
+    auto alphaOverA = alpha / A;
+    auto a0 = 1.0 + alphaOverA;
+
+    BiquadCoefficients<SampleType> c;
+    c.b0 = SampleType((1.0 + alphaTimesA) / a0);
+    c.b1 = SampleType(c2 / a0);
+    c.b2 = SampleType((1.0 - alphaTimesA) / a0);
+    c.a1 = SampleType(c2 / a0);
+    c.a2 = SampleType((1.0 - alphaOverA) / a0);
+    return c;
+}
+
+// Magnitude of the analog peak that both designs approximate,
+// H(s) = (s^2 + s A / Q + 1) / (s^2 + s / (A Q) + 1) with A = sqrt(gainFactor)
+inline double getAnalogPeakMagnitude(double frequency, double centreFrequency, double quality, double gainFactor)
+{
+    auto A = std::sqrt(std::max(0.0, gainFactor));
+    auto x = frequency / centreFrequency;
+    auto d = 1.0 - x * x;
+    auto numerator = A * x / quality;
+    auto denominator = x / (A * quality);
+
+    return std::sqrt((d * d + numerator * numerator) / (d * d + denominator * denominator));
+}
+
+template <typename SampleType>
+BiquadCoefficients<SampleType> makeMatchedPeakCoefficients(double sampleRate, double frequency, double quality, double gainFactor)
+{
+    // M. Vicanek, "Matched Second Order Digital Filters" (2016): impulse invariant poles,
+    // and a numerator fitted to the analog magnitude at DC, at the centre frequency and
+    // at Nyquist. The fit only works well for boosts, so a cut is designed as the
+    // opposite boost and inverted, the analog cut being the reciprocal of that boost.
+    constexpr double pi = 3.14159265358979323846;
+
+    auto boost = std::max(gainFactor, 1.0 / std::max(gainFactor, 1.0e-6));
+    auto A = std::sqrt(boost);
+
+    // The fit divides by sin^2(w0), stay a little below Nyquist
+    auto w0 = std::min(2.0 * pi * frequency / sampleRate, 0.995 * pi);
+    auto zeta = 1.0 / (2.0 * A * quality);
+
+    auto decay = std::exp(-zeta * w0);
+    auto a1 = zeta <= 1.0 ? -2.0 * decay * std::cos(std::sqrt(1.0 - zeta * zeta) * w0)
+                          : -2.0 * decay * std::cosh(std::sqrt(zeta * zeta - 1.0) * w0);
+    auto a2 = decay * decay;
+
+    // |H|^2 = (B0 phi0 + B1 phi1 + B2 phi2) / (A0 phi0 + A1 phi1 + A2 phi2)
+    auto A0 = (1.0 + a1 + a2) * (1.0 + a1 + a2);
+    auto A1 = (1.0 - a1 + a2) * (1.0 - a1 + a2);
+    auto A2 = -4.0 * a2;
+
+    auto phi1 = std::sin(0.5 * w0) * std::sin(0.5 * w0);
+    auto phi0 = 1.0 - phi1;
+    auto phi2 = 4.0 * phi0 * phi1;
+
+    auto nyquistMagnitude = getAnalogPeakMagnitude(0.5 * sampleRate, w0 * sampleRate / (2.0 * pi), quality, boost);
+
+    auto B0 = A0;
+    auto B1 = A1 * nyquistMagnitude * nyquistMagnitude;
+    auto B2 = (boost * boost * (A0 * phi0 + A1 * phi1 + A2 * phi2) - B0 * phi0 - B1 * phi1) / phi2;
+
+    auto W = 0.5 * (std::sqrt(B0) + std::sqrt(B1));
+    auto b0 = 0.5 * (W + std::sqrt(std::max(0.0, W * W + B2)));
+    auto b1 = 0.5 * (std::sqrt(B0) - std::sqrt(B1));
+    auto b2 = -B2 / (4.0 * b0);
+
+    BiquadCoefficients<SampleType> c;
+
+    if( gainFactor >= 1.0 )
+    {
+        c.b0 = SampleType(b0);
+        c.b1 = SampleType(b1);
+        c.b2 = SampleType(b2);
+        c.a1 = SampleType(a1);
+        c.a2 = SampleType(a2);
+    }
+    else
+    {
+        // The boost's zeros are inside the unit circle, so the inverse is stable
+        c.b0 = SampleType(1.0 / b0);
+        c.b1 = SampleType(a1 / b0);
+        c.b2 = SampleType(a2 / b0);
+        c.a1 = SampleType(b1 / b0);
+        c.a2 = SampleType(b2 / b0);
+    }
+
+    return c;
+}
+
+// Frequency of a band, spread geometrically between FREQ and FREQ * (1 + SPAN / 2)
+inline double getPeakBandFrequency(const ChainSettings& chainSettings, int band, int numPeaks, double sampleRate)
+{
+    double spanFactor = 1.0 + (chainSettings.span / 2.0);
+    double position = numPeaks > 1 ? double(band) / double(numPeaks - 1) : 0.0;
+
+    // Ensure the frequency stays a little below Nyquist, where the bilinear peak's poles
+    // reach the unit circle, and does not fall below a certain minimum
+    return std::min(std::max(chainSettings.peak1Freq * std::pow(spanFactor, position), 20.0), 0.49 * sampleRate);
+}
+
+// Gain of a band, tilted by BAL from -balance on the lowest to +balance on the highest peak.
+// GAIN is shared out over the bands, so where they overlap (at SPAN 0 all of them) they add
+// up to twice GAIN as the two bands always did, rather than to N times GAIN.
+inline double getPeakBandGainInDecibels(const ChainSettings& chainSettings, int band, int numPeaks)
+{
+    double position = numPeaks > 1 ? double(band) / double(numPeaks - 1) : 0.5;
+    double share = numPeaks > 2 ? 2.0 / double(numPeaks) : 1.0;
+
+    return chainSettings.peak1GainInDecibels * share + chainSettings.balance * (2.0 * position - 1.0);
+}
+
+template <typename SampleType>
+BiquadCoefficients<SampleType> makePeakBandCoefficients(const ChainSettings& chainSettings, int band, int numPeaks, double sampleRate)
+{
+    auto frequency = getPeakBandFrequency(chainSettings, band, numPeaks, sampleRate);
+    auto gainFactor = std::pow(10.0, getPeakBandGainInDecibels(chainSettings, band, numPeaks) * 0.05);
+
+    if( chainSettings.design == PeakDesign::matched )
+        return makeMatchedPeakCoefficients<SampleType>(sampleRate, frequency, chainSettings.peak1Quality, gainFactor);
+
+    return makePeakCoefficients<SampleType>(sampleRate, frequency, chainSettings.peak1Quality, gainFactor);
+}
+
+//==============================================================================
+template <int NumPeaks, typename SampleType = float>
+class PeakChain
+{
+public:
+    static_assert(NumPeaks == 2 || NumPeaks == 4 || NumPeaks == 8, "Unsupported number of peaks");
+
+    static constexpr int numPeaks = NumPeaks;
+    static constexpr int maxChannels = 2;
+
+    using Coefficients = BiquadCoefficients<SampleType>;
+    using CoefficientArray = std::array<Coefficients, NumPeaks>;
+
+    void reset()
+    {
+        state = {};
+    }
+
+    static CoefficientArray makeCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        CoefficientArray newCoefficients;
+
+        for( int band = 0; band < NumPeaks; ++band )
+            newCoefficients[band] = makePeakBandCoefficients<SampleType>(chainSettings, band, NumPeaks, sampleRate);
+
+        return newCoefficients;
+    }
+
+    // Jumps straight to the new design, cancelling any ramp in progress
+    void updateCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        coefficients = target = makeCoefficients(chainSettings, sampleRate);
+        rampSamplesRemaining = 0;
+    }
+
+    void setGainLinear(SampleType newGain)
+    {
+        gain = targetGain = newGain;
+        rampSamplesRemaining = 0;
+    }
+
+    SampleType getGainLinear() const noexcept { return gain; }
+
+    // Ramps the coefficients and the gain linearly from their current values
+    // to the new ones over the next rampLength samples
+    void setTarget(const CoefficientArray& newTarget, SampleType newTargetGain, int rampLength) noexcept
+    {
+        target = newTarget;
+        targetGain = newTargetGain;
+
+        if( rampLength <= 0 )
+        {
+            coefficients = target;
+            gain = targetGain;
+            rampSamplesRemaining = 0;
+            return;
+        }
+
+        auto scale = SampleType(1) / SampleType(rampLength);
+
+        for( int band = 0; band < NumPeaks; ++band )
+            increments[band] = (target[band] - coefficients[band]) * scale;
+
+        gainIncrement = (targetGain - gain) * scale;
+        rampSamplesRemaining = rampLength;
+    }
+
+    bool isRamping() const noexcept { return rampSamplesRemaining > 0; }
+
+    const CoefficientArray& getCoefficients() const { return coefficients; }
+
+    // Continues from the coefficients, ramp, gain and filter state of a chain with
+    // another precision, so the signal runs on without a discontinuity
+    template <typename OtherSampleType>
+    void copyStateFrom(const PeakChain<NumPeaks, OtherSampleType>& other) noexcept
+    {
+        for( int band = 0; band < NumPeaks; ++band )
+        {
+            coefficients[band] = Coefficients(other.coefficients[band]);
+            target[band] = Coefficients(other.target[band]);
+            increments[band] = Coefficients(other.increments[band]);
+
+            for( int ch = 0; ch < maxChannels; ++ch )
+            {
+                state[band].s1[ch] = SampleType(other.state[band].s1[ch]);
+                state[band].s2[ch] = SampleType(other.state[band].s2[ch]);
+            }
+        }
+
+        gain = SampleType(other.gain);
+        targetGain = SampleType(other.targetGain);
+        gainIncrement = SampleType(other.gainIncrement);
+        rampSamplesRemaining = other.rampSamplesRemaining;
+    }
+
+    // Kernel variant used by process(). The variants are the same code compiled
+    // for different instruction sets, see PeakKernels.cpp.
+    using ProcessFunction = void (*)(PeakChain&, SampleType* const*, int, int) noexcept;
+
+    void setProcessFunction(ProcessFunction newFunction) noexcept { processFunction = newFunction; }
+
+    static void processGeneric(PeakChain& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        chain.processInline(channels, numChannels, numSamples);
+    }
+
+    // Processes up to two channels in place, output gain included
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        processFunction(*this, channels, numChannels, numSamples);
+    }
+
+    // The kernel body, inlined into each instruction set variant
+    PEAK_CHAIN_FORCEINLINE void processInline(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if( numChannels >= 2 )
+            processChannels<2>(channels, numSamples);
+        else if( numChannels == 1 )
+            processChannels<1>(channels, numSamples);
+        else
+            processChannels<0>(channels, numSamples);
+    }
+
+private:
+    template <int, typename> friend class PeakChain;
+    template <int, typename> friend class ParallelPeakChain;
+    template <int, typename> friend class MorphChain;
+
+    // Filter state of one band, with the channels side by side so both
+    // channels of a frame can share the same vector instructions
+    struct BandState
+    {
+        std::array<SampleType, maxChannels> s1 {}, s2 {};
+    };
+
+    using BandStates = std::array<BandState, NumPeaks>;
+
+    template <int NumChannels>
+    PEAK_CHAIN_FORCEINLINE void processChannels(SampleType* const* channels, int numSamples) noexcept
+    {
+        // Work on local copies, the compiler cannot keep members in registers
+        // because the sample pointers might alias them
+        auto c = coefficients;
+        auto g = gain;
+        auto st = state;
+
+        auto numRampSamples = std::min(numSamples, rampSamplesRemaining);
+        int i = 0;
+
+        for( ; i < numRampSamples; ++i )
+        {
+            for( int band = 0; band < NumPeaks; ++band )
+                c[band] += increments[band];
+
+            g += gainIncrement;
+
+            processFrame<NumChannels>(channels, i, c, g, st);
+        }
+
+        if( numRampSamples > 0 )
+        {
+            rampSamplesRemaining -= numRampSamples;
+
+            // Land exactly on the target rather than on the accumulated increments
+            if( rampSamplesRemaining == 0 )
+            {
+                c = target;
+                g = targetGain;
+            }
+        }
+
+        for( ; i < numSamples; ++i )
+            processFrame<NumChannels>(channels, i, c, g, st);
+
+        coefficients = c;
+        gain = g;
+        state = st;
+    }
+
+    template <int NumChannels>
+    static PEAK_CHAIN_FORCEINLINE void processFrame(SampleType* const* channels, int index,
+                                                    const CoefficientArray& c, SampleType g, BandStates& st) noexcept
+    {
+        std::array<SampleType, NumChannels> x;
+
+        for( int ch = 0; ch < NumChannels; ++ch )
+            x[ch] = channels[ch][index];
+
+        processBands(x, c, st, std::make_index_sequence<NumPeaks>());
+
+        for( int ch = 0; ch < NumChannels; ++ch )
+            channels[ch][index] = g * x[ch];
+    }
+
+    template <size_t NumChannels, size_t... Bands>
+    static PEAK_CHAIN_FORCEINLINE void processBands(std::array<SampleType, NumChannels>& x, const CoefficientArray& c,
+                                                    BandStates& st, std::index_sequence<Bands...>) noexcept
+    {
+        // Expands to NumPeaks transposed direct form II sections in series
+        (processBand(x, c[Bands], st[Bands]), ...);
+    }
+
+    template <size_t NumChannels>
+    static PEAK_CHAIN_FORCEINLINE void processBand(std::array<SampleType, NumChannels>& x, const Coefficients& c, BandState& s) noexcept
+    {
+        for( size_t ch = 0; ch < NumChannels; ++ch )
+        {
+            auto y = c.b0 * x[ch] + s.s1[ch];
+            s.s1[ch] = c.b1 * x[ch] - c.a1 * y + s.s2[ch];
+            s.s2[ch] = c.b2 * x[ch] - c.a2 * y;
+            x[ch] = y;
+        }
+    }
+
+    CoefficientArray coefficients, target, increments;
+    BandStates state;
+    SampleType gain { 1 }, targetGain { 1 }, gainIncrement { 0 };
+    int rampSamplesRemaining { 0 };
+
+    ProcessFunction processFunction { &PeakChain::processGeneric };
+};
+
+//==============================================================================
+// Instruction set variants of the PeakChain kernel, defined in PeakKernels.cpp
+enum class PeakKernel
+{
+    generic,    // Whatever the project is compiled for, SSE2 on x86-64
+    avx2,       // AVX2 + FMA
+    avx512      // AVX-512F
+};
+
+// The best variant the CPU supports, decided with CPUID
+PeakKernel getBestPeakKernel();
+
+bool isPeakKernelSupported(PeakKernel kernel);
+
+template <int NumPeaks, typename SampleType>
+typename PeakChain<NumPeaks, SampleType>::ProcessFunction getPeakKernelFunction(PeakKernel kernel);
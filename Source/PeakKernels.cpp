@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    PeakKernels.cpp
+
+    Instruction set variants of the PeakChain, ParallelPeakChain, MorphChain,
+    Saturator and VoiceBank kernels.
+    Each variant inlines the same processInline body into a function compiled
+    for a wider instruction set, so one binary can run on old and new CPUs and
+    picks the best variant at prepareToPlay.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include "MorphChain.h"
+#include "Saturator.h"
+#include "VoiceBank.h"
+
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #define PEAK_KERNEL_VARIANTS 1
+ #define PEAK_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+ // MSVC has no per-function targets and other platforms only get the generic kernel
+ #define PEAK_KERNEL_VARIANTS 0
+#endif
+
+#if PEAK_KERNEL_VARIANTS
+template <int NumPeaks, typename SampleType>
+PEAK_KERNEL_TARGET("avx2,fma")
+static void processAVX2(PeakChain<NumPeaks, SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    chain.processInline(channels, numChannels, numSamples);
+}
+
+template <int NumPeaks, typename SampleType>
+PEAK_KERNEL_TARGET("avx512f,avx2,fma")
+static void processAVX512(PeakChain<NumPeaks, SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    chain.processInline(channels, numChannels, numSamples);
+}
+
+template <int NumPeaks, typename SampleType>
+PEAK_KERNEL_TARGET("avx2,fma")
+static void processParallelAVX2(ParallelPeakChain<NumPeaks, SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    chain.processInline(channels, numChannels, numSamples);
+}
+
+template <int NumPeaks, typename SampleType>
+PEAK_KERNEL_TARGET("avx512f,avx2,fma")
+static void processParallelAVX512(ParallelPeakChain<NumPeaks, SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    chain.processInline(channels, numChannels, numSamples);
+}
+
+template <int NumPeaks, typename SampleType>
+PEAK_KERNEL_TARGET("avx2,fma")
+static void processMorphAVX2(MorphChain<NumPeaks, SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    chain.processInline(channels, numChannels, numSamples);
+}
+
+template <int NumPeaks, typename SampleType>
+PEAK_KERNEL_TARGET("avx512f,avx2,fma")
+static void processMorphAVX512(MorphChain<NumPeaks, SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    chain.processInline(channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+PEAK_KERNEL_TARGET("avx2,fma")
+static void processSaturatorAVX2(Saturator<SampleType>& saturator, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    saturator.processInline(channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+PEAK_KERNEL_TARGET("avx512f,avx2,fma")
+static void processSaturatorAVX512(Saturator<SampleType>& saturator, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    saturator.processInline(channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+PEAK_KERNEL_TARGET("avx2,fma")
+static void processVoiceBankAVX2(VoiceBank<SampleType>& bank, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    bank.processInline(channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+PEAK_KERNEL_TARGET("avx512f,avx2,fma")
+static void processVoiceBankAVX512(VoiceBank<SampleType>& bank, SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    bank.processInline(channels, numChannels, numSamples);
+}
+#endif
+
+//==============================================================================
+bool isPeakKernelSupported(PeakKernel kernel)
+{
+    switch( kernel )
+    {
+       #if PEAK_KERNEL_VARIANTS
+        case PeakKernel::avx2:   return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+        case PeakKernel::avx512: return juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+       #else
+        case PeakKernel::avx2:
+        case PeakKernel::avx512: return false;
+       #endif
+        case PeakKernel::generic:
+        default:                 return true;
+    }
+}
+
+PeakKernel getBestPeakKernel()
+{
+    for( auto kernel : { PeakKernel::avx512, PeakKernel::avx2 } )
+        if( isPeakKernelSupported(kernel) )
+            return kernel;
+
+    return PeakKernel::generic;
+}
+
+template <int NumPeaks, typename SampleType>
+typename PeakChain<NumPeaks, SampleType>::ProcessFunction getPeakKernelFunction(PeakKernel kernel)
+{
+    jassert(isPeakKernelSupported(kernel));
+
+   #if PEAK_KERNEL_VARIANTS
+    if( kernel == PeakKernel::avx512 )
+        return &processAVX512<NumPeaks, SampleType>;
+
+    if( kernel == PeakKernel::avx2 )
+        return &processAVX2<NumPeaks, SampleType>;
+   #endif
+
+    juce::ignoreUnused(kernel);
+    return &PeakChain<NumPeaks, SampleType>::processGeneric;
+}
+
+template PeakChain<2, float>::ProcessFunction getPeakKernelFunction<2, float>(PeakKernel);
+template PeakChain<4, float>::ProcessFunction getPeakKernelFunction<4, float>(PeakKernel);
+template PeakChain<8, float>::ProcessFunction getPeakKernelFunction<8, float>(PeakKernel);
+
+template <int NumPeaks, typename SampleType>
+typename ParallelPeakChain<NumPeaks, SampleType>::ProcessFunction getParallelPeakKernelFunction(PeakKernel kernel)
+{
+    jassert(isPeakKernelSupported(kernel));
+
+   #if PEAK_KERNEL_VARIANTS
+    if( kernel == PeakKernel::avx512 )
+        return &processParallelAVX512<NumPeaks, SampleType>;
+
+    if( kernel == PeakKernel::avx2 )
+        return &processParallelAVX2<NumPeaks, SampleType>;
+   #endif
+
+    juce::ignoreUnused(kernel);
+    return &ParallelPeakChain<NumPeaks, SampleType>::processGeneric;
+}
+
+template ParallelPeakChain<2, float>::ProcessFunction getParallelPeakKernelFunction<2, float>(PeakKernel);
+template ParallelPeakChain<4, float>::ProcessFunction getParallelPeakKernelFunction<4, float>(PeakKernel);
+template ParallelPeakChain<8, float>::ProcessFunction getParallelPeakKernelFunction<8, float>(PeakKernel);
+
+template <int NumPeaks, typename SampleType>
+typename MorphChain<NumPeaks, SampleType>::ProcessFunction getMorphKernelFunction(PeakKernel kernel)
+{
+    jassert(isPeakKernelSupported(kernel));
+
+   #if PEAK_KERNEL_VARIANTS
+    if( kernel == PeakKernel::avx512 )
+        return &processMorphAVX512<NumPeaks, SampleType>;
+
+    if( kernel == PeakKernel::avx2 )
+        return &processMorphAVX2<NumPeaks, SampleType>;
+   #endif
+
+    juce::ignoreUnused(kernel);
+    return &MorphChain<NumPeaks, SampleType>::processGeneric;
+}
+
+template MorphChain<2, float>::ProcessFunction getMorphKernelFunction<2, float>(PeakKernel);
+template MorphChain<4, float>::ProcessFunction getMorphKernelFunction<4, float>(PeakKernel);
+template MorphChain<8, float>::ProcessFunction getMorphKernelFunction<8, float>(PeakKernel);
+
+template <typename SampleType>
+typename Saturator<SampleType>::ProcessFunction getSaturatorKernelFunction(PeakKernel kernel)
+{
+    jassert(isPeakKernelSupported(kernel));
+
+   #if PEAK_KERNEL_VARIANTS
+    if( kernel == PeakKernel::avx512 )
+        return &processSaturatorAVX512<SampleType>;
+
+    if( kernel == PeakKernel::avx2 )
+        return &processSaturatorAVX2<SampleType>;
+   #endif
+
+    juce::ignoreUnused(kernel);
+    return &Saturator<SampleType>::processGeneric;
+}
+
+template Saturator<float>::ProcessFunction getSaturatorKernelFunction<float>(PeakKernel);
+
+template <typename SampleType>
+typename VoiceBank<SampleType>::ProcessFunction getVoiceBankKernelFunction(PeakKernel kernel)
+{
+    jassert(isPeakKernelSupported(kernel));
+
+   #if PEAK_KERNEL_VARIANTS
+    if( kernel == PeakKernel::avx512 )
+        return &processVoiceBankAVX512<SampleType>;
+
+    if( kernel == PeakKernel::avx2 )
+        return &processVoiceBankAVX2<SampleType>;
+   #endif
+
+    juce::ignoreUnused(kernel);
+    return &VoiceBank<SampleType>::processGeneric;
+}
+
+template VoiceBank<float>::ProcessFunction getVoiceBankKernelFunction<float>(PeakKernel);
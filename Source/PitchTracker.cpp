@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    PitchTracker.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchTracker.h"
+#include "Trace.h"
+
+void PitchTracker::prepare(double sampleRate)
+{
+    decimation = juce::jmax(1, (int) std::floor(sampleRate / targetAnalysisRate));
+    analysisRate = sampleRate / double(decimation);
+
+    // Two RBJ low-passes with the Q of the fourth-order Butterworth's pole pairs, cutting off at
+    // 0.3 times the decimated rate: the fundamentals pass, the aliases fold from above 0.5 of it
+    constexpr double qualities[] { 0.54119610, 1.30656296 };
+
+    auto w = juce::MathConstants<double>::twoPi * 0.3 / double(decimation);
+    auto cosW = std::cos(w);
+
+    for( size_t i = 0; i < antiAliasing.size(); ++i )
+    {
+        auto alpha = std::sin(w) / (2.0 * qualities[i]);
+        auto a0 = 1.0 + alpha;
+
+        auto& section = antiAliasing[i];
+        section.b0 = section.b2 = 0.5 * (1.0 - cosW) / a0;
+        section.b1 = (1.0 - cosW) / a0;
+        section.a1 = -2.0 * cosW / a0;
+        section.a2 = (1.0 - alpha) / a0;
+    }
+
+    history.assign((size_t) windowSize, 0.f);
+    frame.assign((size_t) windowSize, 0.f);
+    fftData.assign((size_t) fftSize * 2, 0.f);
+    nsdf.assign((size_t) windowSize / 2 + 2, 0.0);
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+
+    averageMicroseconds = 0.f;
+    peakMicroseconds = 0.f;
+
+    reset();
+}
+
+void PitchTracker::reset() noexcept
+{
+    for( auto& section : antiAliasing )
+        section.s1 = section.s2 = 0.0;
+
+    std::fill(history.begin(), history.end(), 0.f);
+    writePosition = numBuffered = samplesSinceAnalysis = decimationPhase = 0;
+
+    numRecent = 0;
+    frequency = 0.f;
+}
+
+void PitchTracker::push(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if( history.empty() || numChannels <= 0 )
+        return;
+
+    auto channelScale = 1.0 / double(numChannels);
+
+    for( int i = 0; i < numSamples; ++i )
+    {
+        double x = 0.0;
+
+        for( int ch = 0; ch < numChannels; ++ch )
+            x += double(channels[ch][i]);
+
+        x = antiAliasing[1].process(antiAliasing[0].process(x * channelScale));
+
+        if( ++decimationPhase < decimation )
+            continue;
+
+        decimationPhase = 0;
+
+        history[(size_t) writePosition] = float(x);
+
+        if( ++writePosition == windowSize )
+            writePosition = 0;
+
+        numBuffered = juce::jmin(numBuffered + 1, windowSize);
+        samplesSinceAnalysis = juce::jmin(samplesSinceAnalysis + 1, hopSize);
+    }
+}
+
+bool PitchTracker::analyse() noexcept
+{
+    // Hops that passed without a tick are skipped, only the latest window matters
+    if( numBuffered < windowSize || samplesSinceAnalysis < hopSize )
+        return false;
+
+    SDF_TRACE_SCOPE("PitchTracker::analyse");
+
+    samplesSinceAnalysis = 0;
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    auto period = findPeriod();
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    auto microseconds = float(seconds * 1.0e6);
+    auto average = averageMicroseconds.load(std::memory_order_relaxed);
+
+    averageMicroseconds.store(average > 0.f ? average + 0.05f * (microseconds - average) : microseconds, std::memory_order_relaxed);
+    peakMicroseconds.store(juce::jmax(peakMicroseconds.load(std::memory_order_relaxed), microseconds), std::memory_order_relaxed);
+
+    if( period <= 0.0 )
+        return false;
+
+    recentFrequencies[0] = recentFrequencies[1];
+    recentFrequencies[1] = recentFrequencies[2];
+    recentFrequencies[2] = float(analysisRate / period);
+    numRecent = juce::jmin(numRecent + 1, 3);
+
+    auto a = recentFrequencies[0], b = recentFrequencies[1], c = recentFrequencies[2];
+    auto median = numRecent < 3 ? c : juce::jmax(juce::jmin(a, b), juce::jmin(juce::jmax(a, b), c));
+
+    frequency.store(median, std::memory_order_relaxed);
+    return true;
+}
+
+double PitchTracker::findPeriod() noexcept
+{
+    // The window in time order without its mean, the oldest sample is where the next one goes
+    double mean = 0.0;
+
+    for( int i = 0; i < windowSize; ++i )
+        mean += double(history[(size_t) ((writePosition + i) % windowSize)]);
+
+    mean /= double(windowSize);
+
+    double energy = 0.0;
+
+    for( int i = 0; i < windowSize; ++i )
+    {
+        auto x = double(history[(size_t) ((writePosition + i) % windowSize)]) - mean;
+        frame[(size_t) i] = float(x);
+        energy += x * x;
+    }
+
+    // Quieter than -80 dBFS RMS counts as unvoiced
+    if( energy < double(windowSize) * 1.0e-8 )
+        return 0.0;
+
+    // Autocorrelation as the inverse transform of the power spectrum, zero-padded so it doesn't wrap
+    std::fill(fftData.begin(), fftData.end(), 0.f);
+    std::copy(frame.begin(), frame.end(), fftData.begin());
+
+    fft->performRealOnlyForwardTransform(fftData.data(), true);
+
+    for( int bin = 0; bin <= fftSize / 2; ++bin )
+    {
+        auto re = fftData[(size_t) (2 * bin)];
+        auto im = fftData[(size_t) (2 * bin + 1)];
+
+        fftData[(size_t) (2 * bin)] = re * re + im * im;
+        fftData[(size_t) (2 * bin + 1)] = 0.f;
+    }
+
+    fft->performRealOnlyInverseTransform(fftData.data());
+
+    // r(0) is the energy, which fixes whatever scale the transforms leave on r
+    if( fftData[0] <= 0.f )
+        return 0.0;
+
+    auto scale = energy / double(fftData[0]);
+
+    auto minLag = juce::jmax(2, (int) std::floor(analysisRate / maxFrequency));
+    auto maxLag = juce::jmin(windowSize / 2, (int) std::ceil(analysisRate / minFrequency));
+
+    // Normalised square difference 2 r(tau) / m(tau), m(tau) the energy of both overlapping parts
+    auto m = 2.0 * energy;
+    nsdf[0] = 1.0;
+
+    for( int tau = 1; tau <= maxLag; ++tau )
+    {
+        auto first = double(frame[(size_t) (tau - 1)]);
+        auto last = double(frame[(size_t) (windowSize - tau)]);
+
+        m -= first * first + last * last;
+        nsdf[(size_t) tau] = m > 0.0 ? 2.0 * scale * double(fftData[(size_t) tau]) / m : 0.0;
+    }
+
+    // The key maxima, the highest point of every positive lobe after the one around lag 0
+    std::array<int, windowSize / 2> keyMaxima;
+    int numKeyMaxima = 0;
+    double highest = 0.0;
+
+    int tau = 1;
+
+    while( tau < maxLag && nsdf[(size_t) tau] > 0.0 )
+        ++tau;
+
+    while( tau < maxLag )
+    {
+        while( tau < maxLag && nsdf[(size_t) tau] <= 0.0 )
+            ++tau;
+
+        int best = 0;
+
+        for( ; tau < maxLag && nsdf[(size_t) tau] > 0.0; ++tau )
+            if( best == 0 || nsdf[(size_t) tau] > nsdf[(size_t) best] )
+                best = tau;
+
+        if( best >= minLag )
+        {
+            keyMaxima[(size_t) numKeyMaxima++] = best;
+            highest = juce::jmax(highest, nsdf[(size_t) best]);
+        }
+    }
+
+    // The first maximum close to the highest, which picks the fundamental over its multiples
+    constexpr double closeToHighest = 0.9;
+
+    for( int i = 0; i < numKeyMaxima; ++i )
+    {
+        auto lag = keyMaxima[(size_t) i];
+
+        if( nsdf[(size_t) lag] < closeToHighest * highest )
+            continue;
+
+        if( nsdf[(size_t) lag] < double(clarityThreshold) )
+            return 0.0;
+
+        // Parabolic interpolation between the lags either side
+        auto before = nsdf[(size_t) (lag - 1)], at = nsdf[(size_t) lag], after = nsdf[(size_t) (lag + 1)];
+        auto curvature = before - 2.0 * at + after;
+        auto offset = curvature < 0.0 ? juce::jlimit(-0.5, 0.5, 0.5 * (before - after) / curvature) : 0.0;
+
+        return double(lag) + offset;
+    }
+
+    return 0.0;
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    PitchTracker.h
+
+    Pitch Track mode: FREQ follows the fundamental of the input or of the
+    sidechain. The audio is mixed to mono, low-passed and decimated to about
+    8 kHz as it arrives, which is all the work done per sample. Analyses run
+    at the processor's control ticks, at most one per hop of new decimated
+    samples, on the latest window only: the McLeod pitch method, with the
+    autocorrelation taken through a zero-padded FFT. One analysis is a pair
+    of fixed size FFTs and a few linear passes, whatever the host's block
+    size, and its time is measured on the audio thread.
+
+    A median of the last three voiced estimates rejects single octave slips
+    and unvoiced windows hold the last pitch. The processor glides FREQ to
+    every estimate with the parameter smoother, so the coefficients ramp
+    over control intervals like they do for any other FREQ move.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class PitchTracker
+{
+public:
+    static constexpr double minFrequency = 40.0;
+    static constexpr double maxFrequency = 1500.0;
+
+    static constexpr double targetAnalysisRate = 8000.0;   // Decimated by the integer factor that comes closest from above
+    static constexpr int windowSize = 512;                  // Decimated samples per analysis, 64 ms at 8 kHz
+    static constexpr int hopSize = 128;                     // New decimated samples between analyses, 16 ms at 8 kHz
+    static constexpr float clarityThreshold = 0.7f;         // Normalised correlation below which a window is unvoiced
+
+    // Allocates the buffers and the FFT, call outside the audio callback
+    void prepare(double sampleRate);
+
+    // Forgets the audio and the pitch, the cost measurements stay
+    void reset() noexcept;
+
+    // Takes the latest audio, averaged over the channels
+    void push(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    // Analyses the latest window once a hop of new samples has arrived, true when that gave a new pitch
+    bool analyse() noexcept;
+
+    // The last voiced pitch in Hz, 0 before the first one. Safe to read from any thread.
+    float getFrequency() const noexcept { return frequency.load(std::memory_order_relaxed); }
+
+    // Time per analysis, averaged over the last few dozen and the longest since prepare
+    float getAverageAnalysisMicroseconds() const noexcept { return averageMicroseconds.load(std::memory_order_relaxed); }
+    float getPeakAnalysisMicroseconds() const noexcept { return peakMicroseconds.load(std::memory_order_relaxed); }
+
+    double getAnalysisRate() const noexcept { return analysisRate; }
+
+private:
+    static constexpr int fftOrder = 10;                     // Twice the window, so the autocorrelation doesn't wrap
+    static constexpr int fftSize = 1 << fftOrder;
+
+    static_assert(fftSize >= 2 * windowSize, "The FFT must hold the window zero-padded to twice its length");
+
+    struct Section
+    {
+        double b0 { 1 }, b1 { 0 }, b2 { 0 }, a1 { 0 }, a2 { 0 };
+        double s1 { 0 }, s2 { 0 };
+
+        double process(double x) noexcept
+        {
+            auto y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    // The period in decimated samples of the latest window, 0 when unvoiced
+    double findPeriod() noexcept;
+
+    double analysisRate { targetAnalysisRate };
+    int decimation { 1 }, decimationPhase { 0 };
+
+    // Fourth-order Butterworth low-pass ahead of the decimation
+    std::array<Section, 2> antiAliasing;
+
+    std::vector<float> history;                 // Decimated samples, a ring of windowSize
+    int writePosition { 0 }, numBuffered { 0 }, samplesSinceAnalysis { 0 };
+
+    std::vector<float> frame;                   // The window being analysed, in time order
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData;                 // 2 * fftSize, as the real-only transforms want
+    std::vector<double> nsdf;
+
+    std::array<float, 3> recentFrequencies {};
+    int numRecent { 0 };
+
+    std::atomic<float> frequency { 0.f };
+    std::atomic<float> averageMicroseconds { 0.f }, peakMicroseconds { 0.f };
+};
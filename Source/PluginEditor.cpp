@@ -9,6 +9,12 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+#if JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_LINUX
+ #include <unistd.h>
+#endif
+
 
 struct ThemeColours
 {
@@ -81,6 +87,70 @@ void drawCustomLine(juce::Graphics &g,
     g.fillEllipse(endX, y, width, width);
 }
 
+static double getResidentMemoryMegabytes()
+{
+   #if JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    
+    if( task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS )
+        return double(info.resident_size) / (1024.0 * 1024.0);
+    
+    return 0.0;
+   #elif JUCE_LINUX
+    // The second field of statm is the resident set size in pages
+    auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+    return double(fields[1].getLargeIntValue()) * double(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+   #else
+    return 0.0;
+   #endif
+}
+
+LookAndFeel::LookAndFeel()
+{
+    rubikFont.setTypefaceName("Rubik");
+    rubikFont.setBold(false);
+}
+
+LookAndFeel::FontWidths& LookAndFeel::getFontWidths(const juce::Font &font)
+{
+    for( auto* fontWidths : stringWidths )
+    {
+        if( fontWidths->height == font.getHeight()
+           && fontWidths->typefaceName == font.getTypefaceName()
+           && fontWidths->typefaceStyle == font.getTypefaceStyle() )
+            return *fontWidths;
+    }
+    
+    // Only a handful of fonts are in use, more means the window is being resized
+    if( stringWidths.size() >= 8 )
+        stringWidths.remove(0);
+    
+    auto* fontWidths = stringWidths.add(new FontWidths());
+    fontWidths->typefaceName = font.getTypefaceName();
+    fontWidths->typefaceStyle = font.getTypefaceStyle();
+    fontWidths->height = font.getHeight();
+    
+    return *fontWidths;
+}
+
+float LookAndFeel::getStringWidth(const juce::Font &font, const juce::String &text)
+{
+    auto& widths = getFontWidths(font).widths;
+    
+    if( widths.contains(text) )
+        return widths[text];
+    
+    // The value strings change all the time, so keep the cache from growing forever
+    if( widths.size() > 512 )
+        widths.clear();
+    
+    auto width = juce::GlyphArrangement::getStringWidth(font, text);
+    widths.set(text, width);
+    
+    return width;
+}
+
 void LookAndFeel::drawRotarySlider(juce::Graphics &g,
                                    int x,
                                    int y,
@@ -93,10 +163,7 @@ void LookAndFeel::drawRotarySlider(juce::Graphics &g,
 {
     using namespace juce;
     
-    Font font;
-    font.setTypefaceName("Rubik");
-    font.setBold(false);
-    g.setFont(font);
+    g.setFont(rubikFont);
     
     auto bounds = Rectangle<int>(x, y, width, height).toFloat();
 
@@ -155,8 +222,7 @@ void LookAndFeel::drawRotarySlider(juce::Graphics &g,
             g.setFont(30.f * scaleFactor);
             auto text = rswl->getDisplayString();
 
-            GlyphArrangement glyphArrangement;
-            auto strWidth = glyphArrangement.getStringWidth(g.getCurrentFont(), text);
+            auto strWidth = getStringWidth(g.getCurrentFont(), text);
 
             r.setSize(strWidth + (scaleFactor * 4), rswl->getTextHeight() + (scaleFactor * 2));
             r.setCentre(bounds.getCentreX(), bounds.getCentreY() + yShift);
@@ -225,10 +291,7 @@ void RotarySliderWithLabels::paint(juce::Graphics &g)
 
     
     // Draw the big label
-    Font font;
-    font.setTypefaceName("Rubik");
-    font.setBold(false);
-    g.setFont(font);
+    g.setFont(lnf->getRubikFont());
     g.setColour(theme.big_label_colour);
     g.setFont(50.0f * scaleFactor);
     
@@ -250,20 +313,15 @@ void RotarySliderWithLabels::paint(juce::Graphics &g)
     
     auto leftLabel = labels[0].label;
     
-    // Using GlyphArrangement to calculate text width
-    GlyphArrangement glyphArrangementLeft;
-    glyphArrangementLeft.addFittedText(g.getCurrentFont(), leftLabel, 0, 0, 0, 1.0f, Justification::centred, 1.0f);
-    float leftLabelWidth = glyphArrangementLeft.getStringWidth(g.getCurrentFont(), leftLabel);
+    // The shared LookAndFeel caches the text widths
+    float leftLabelWidth = lnf->getStringWidth(g.getCurrentFont(), leftLabel);
     
     // Draw the label
     g.drawFittedText(leftLabel, x, y + dist * 6.3, leftLabelWidth, 20.0f * scaleFactor, Justification::left, 1);
     
     auto rightLabel = labels[1].label;
     
-    // Using GlyphArrangement to calculate text width
-    GlyphArrangement glyphArrangementRight;
-    glyphArrangementRight.addFittedText(g.getCurrentFont(), rightLabel, 0, 0, 0, 1.0f, Justification::centred, 1.0f);
-    float rightLabelWidth = glyphArrangementRight.getStringWidth(g.getCurrentFont(), rightLabel);
+    float rightLabelWidth = lnf->getStringWidth(g.getCurrentFont(), rightLabel);
     
     // Draw the label
     g.drawFittedText(rightLabel, x + dist * 5 - rightLabelWidth, y + dist * 6.3 , rightLabelWidth, 20.0f * scaleFactor, Justification::right, 1);
@@ -332,8 +390,6 @@ ResponseCurveComponent::ResponseCurveComponent(SimpleDualFilterAudioProcessor& p
     }
     
     updateChain();
-    
-    startTimer(60);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
@@ -350,97 +406,228 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
     parametersChanged.set(true);
 }
 
-void ResponseCurveComponent::timerCallback()
+void ResponseCurveComponent::refresh()
 {
+    SDF_TRACE_SCOPE("ResponseCurveComponent::refresh");
+    
+    auto trackedFrequency = audioProcessor.getPitchTracker().getFrequency();
+    
+    if( trackedFrequency != drawnTrackedFrequency )
+    {
+        drawnTrackedFrequency = trackedFrequency;
+        parametersChanged.set(true);
+    }
+    
     if( parametersChanged.compareAndSetBool(false, true) )
     {
         // update monochain
         updateChain();
         
-        // signal repaint
+        // the new curve is drawn in the background
+        submitFrame();
+    }
+    
+    auto metersMoved = updateMeterReadings();
+    
+    if( renderer.hasNewFrame() )
         repaint();
+    else if( metersMoved )
+        repaint(getMeterArea());
+}
+
+void ResponseCurveComponent::submitFrame()
+{
+    ResponseFrame frame;
+    
+    frame.coefficients = peakCoefficients;
+    frame.numPeaks = numPeaks;
+    frame.sampleRate = audioProcessor.getSampleRate() > 0 ? audioProcessor.getSampleRate() : 44100.0;
+    
+    frame.bounds = getLocalBounds();
+    frame.responseArea = getAnalysisArea();
+    frame.outlineArea = getRenderArea();
+    frame.scaleFactor = float(frame.responseArea.getWidth() / 1050.f);
+    
+    frame.curveColour = theme.responsecurve_colour;
+    frame.outlineColour = theme.responsegrid_outline_colour;
+    
+    renderer.render(frame);
+}
+
+void ResponseCurveComponent::updateRefreshState()
+{
+    // Redraws follow the display refresh and stop entirely while the display is hidden
+    if( isShowing() )
+    {
+        if( vblankAttachment == nullptr )
+        {
+            vblankAttachment = std::make_unique<juce::VBlankAttachment>(this, [this] { refresh(); });
+            
+            updateChain();
+            submitFrame();
+        }
+    }
+    else
+    {
+        vblankAttachment.reset();
+        
+        background = juce::Image();
+        renderer.releaseFrames();
+    }
+}
+
+bool ResponseCurveComponent::updateMeterReadings()
+{
+    auto& input = audioProcessor.getInputMeter();
+    auto& output = audioProcessor.getOutputMeter();
+    
+    MeterReadings readings;
+    
+    for( int ch = 0; ch < LevelMeter::numChannels; ++ch )
+    {
+        readings.inputPeak[ch] = input.getPeak(ch);
+        readings.inputRms[ch] = input.getRms(ch);
+        readings.outputPeak[ch] = output.getPeak(ch);
+        readings.outputRms[ch] = output.getRms(ch);
     }
+    
+    readings.correlation = output.getCorrelation();
+    
+    // Only repaint when something moved visibly
+    auto moved = [](float a, float b) { return std::abs(a - b) > 1.0e-4f; };
+    bool changed = moved(readings.correlation, meterReadings.correlation);
+    
+    for( int ch = 0; ch < LevelMeter::numChannels; ++ch )
+    {
+        changed = changed || moved(readings.inputPeak[ch], meterReadings.inputPeak[ch])
+                          || moved(readings.inputRms[ch], meterReadings.inputRms[ch])
+                          || moved(readings.outputPeak[ch], meterReadings.outputPeak[ch])
+                          || moved(readings.outputRms[ch], meterReadings.outputRms[ch]);
+    }
+    
+    meterReadings = readings;
+    return changed;
 }
 
 void ResponseCurveComponent::updateChain()
 {
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
-    auto peak1Coefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get<ChainPositions::Peak1>().coefficients, peak1Coefficients);
-    auto peak2Coefficients = makePeakFilter2(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get<ChainPositions::Peak2>().coefficients, peak2Coefficients);
+    auto chainSettings = audioProcessor.getMorphedChainSettings();
+    auto sampleRate = audioProcessor.getSampleRate() > 0 ? audioProcessor.getSampleRate() : 44100.0;
+    
+    // With Key Track on the held notes place the peaks, so the FREQ bands aren't drawn
+    numPeaks = chainSettings.keyTrack ? 0 : chainSettings.numPeaks;
+    
+    for( int band = 0; band < numPeaks; ++band )
+        peakCoefficients[band] = makeBandCoefficients<double>(chainSettings, band, numPeaks, sampleRate);
 }
 
 void ResponseCurveComponent::paint (juce::Graphics& g)
 {
+    SDF_TRACE_SCOPE("ResponseCurveComponent::paint");
+    
     using namespace juce;
     
+    if( background.isNull() || background.getBounds() != getLocalBounds() )
+        renderBackground();
+    
     g.drawImage(background, getLocalBounds().toFloat());
     
-    auto responseArea = getAnalysisArea();
+    // A frame rendered for the previous size is stretched until the new one is ready
+    renderer.drawLatestFrame(g, getLocalBounds().toFloat());
     
-    auto w = responseArea.getWidth();
+    paintMeters(g);
+}
+
+void ResponseCurveComponent::paintMeters(juce::Graphics& g)
+{
+    using namespace juce;
     
-    float scaleFactor = float(w / 1050.f);
+    auto area = getMeterArea().toFloat();
     
-    auto& peak1 = monoChain.get<ChainPositions::Peak1>();
-    auto& peak2 = monoChain.get<ChainPositions::Peak2>();
+    float scaleFactor = float(getAnalysisArea().getWidth() / 1050.f);
     
-    auto sampleRate = audioProcessor.getSampleRate();
+    auto labelArea = area.removeFromLeft(50 * scaleFactor);
+    auto correlationArea = area.removeFromRight(area.getWidth() / 5);
+    area.removeFromRight(20 * scaleFactor);
     
-    std::vector<double> mags;
+    // Labels
+    g.setColour(theme.responsegrid_label_colour);
+    g.setFont(lnf->getRubikFont().withHeight(labelArea.getHeight() * 0.4f));
+    g.drawText("IN", labelArea.removeFromTop(labelArea.getHeight() / 2), Justification::centredLeft);
+    g.drawText("OUT", labelArea, Justification::centredLeft);
     
-    mags.resize(w);
+    // Level bars from -48 dB to 0 dB, the same range as the labels on the left of the grid
+    auto rowHeight = area.getHeight() / 4;
     
-    for( int i = 0; i < w; ++i )
+    auto drawLevel = [&](float rms, float peak)
     {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+        auto row = area.removeFromTop(rowHeight).reduced(0, rowHeight * 0.15f);
+        
+        auto toX = [&row](float gain)
+        {
+            auto db = jlimit(-48.f, 0.f, Decibels::gainToDecibels(gain, -48.f));
+            return jmap(db, -48.f, 0.f, row.getX(), row.getRight());
+        };
         
-        mag *= peak1.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        mag *= peak2.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        g.setColour(theme.responsegrid_colour);
+        g.fillRect(row);
         
-        mags[i] = Decibels::gainToDecibels(mag);
-    }
+        g.setColour(theme.light_line_colour);
+        g.fillRect(row.withRight(toX(rms)));
+        
+        g.setColour(theme.value_colour);
+        g.fillRect(Rectangle<float>(toX(peak) - scaleFactor, row.getY(), 2.f * scaleFactor, row.getHeight()));
+    };
     
-    // Response Curve
-    Path responseCurve;
+    for( int ch = 0; ch < LevelMeter::numChannels; ++ch )
+        drawLevel(meterReadings.inputRms[ch], meterReadings.inputPeak[ch]);
     
-    const double outputMin = responseArea.getBottom();
-    const double outputMax = responseArea.getY();
-    auto map = [outputMin, outputMax](double input)
-    {
-        return jmap(input, -24.0, 24.0, outputMin, outputMax);
-    };
+    for( int ch = 0; ch < LevelMeter::numChannels; ++ch )
+        drawLevel(meterReadings.outputRms[ch], meterReadings.outputPeak[ch]);
     
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+    // Output correlation from -1 on the left to +1 on the right
+    auto track = correlationArea.withSizeKeepingCentre(correlationArea.getWidth(), rowHeight * 1.4f);
     
-    for( size_t i = 1; i < mags.size(); ++i )
-    {
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
-    }
+    g.setColour(theme.responsegrid_colour);
+    g.fillRect(track);
     
-    // Draw responsegrid outline
-    g.setColour(theme.responsegrid_outline_colour);
-    g.drawRoundedRectangle(getRenderArea().toFloat(), 1.f * scaleFactor, 3.f * scaleFactor);
-
-    // Draw responsecurve
-    g.setColour(theme.responsecurve_colour);
-    g.strokePath(responseCurve, PathStrokeType(2.f * scaleFactor));
+    g.setColour(theme.responsegrid_highlight_colour);
+    g.fillRect(track.withSizeKeepingCentre(2.f * scaleFactor, track.getHeight()));
+    
+    auto x = jmap(meterReadings.correlation, -1.f, 1.f, track.getX(), track.getRight());
+    
+    g.setColour(theme.value_colour);
+    g.fillRect(Rectangle<float>(x - 1.5f * scaleFactor, track.getY(), 3.f * scaleFactor, track.getHeight()));
 }
 
 void ResponseCurveComponent::resized()
+{
+    // The grid is drawn again on the next paint, not on every step of a window resize
+    background = juce::Image();
+    
+    if( vblankAttachment != nullptr )
+        submitFrame();
+}
+
+void ResponseCurveComponent::visibilityChanged()
+{
+    updateRefreshState();
+}
+
+void ResponseCurveComponent::parentHierarchyChanged()
+{
+    updateRefreshState();
+}
+
+void ResponseCurveComponent::renderBackground()
 {
     using namespace juce;
     
-    background = Image(Image::PixelFormat::ARGB, getWidth(), getHeight(), true);
+    background = Image(Image::PixelFormat::ARGB, jmax(1, getWidth()), jmax(1, getHeight()), true);
     
     Graphics g(background);
     
-    Font font;
-    font.setTypefaceName("Rubik");
-    font.setBold(false);
-    g.setFont(font);
+    g.setFont(lnf->getRubikFont());
     
     Array<float> freqs
     {
@@ -508,8 +695,7 @@ void ResponseCurveComponent::resized()
             str << "k";
         str << "Hz";
         
-        GlyphArrangement glyphArrangement;
-        auto textWidth = glyphArrangement.getStringWidth(g.getCurrentFont(), str);
+        auto textWidth = lnf->getStringWidth(g.getCurrentFont(), str);
         
         auto y = 55 * scaleFactor;
 
@@ -538,8 +724,7 @@ void ResponseCurveComponent::resized()
             str << "+";
         str << gDb;
         
-        GlyphArrangement glyphArrangement;
-        auto textWidth = glyphArrangement.getStringWidth(g.getCurrentFont(), str);
+        auto textWidth = lnf->getStringWidth(g.getCurrentFont(), str);
         
         g.setColour(gDb == 0.f ? theme.responsegrid_label_highlight_colour : theme.responsegrid_label_colour );
         
@@ -551,7 +736,7 @@ void ResponseCurveComponent::resized()
             str.clear();
             str << (gDb -24.f);
             
-            textWidth = glyphArrangement.getStringWidth(g.getCurrentFont(), str);
+            textWidth = lnf->getStringWidth(g.getCurrentFont(), str);
             // Draw dB labels on the left
             g.drawFittedText(str, scaleFactor * 13, y, textWidth, fontHeight, juce::Justification::right, 1);
             
@@ -564,7 +749,7 @@ void ResponseCurveComponent::resized()
             str.clear();
             str << (gDb -24.f);
             
-            textWidth = glyphArrangement.getStringWidth(g.getCurrentFont(), str);
+            textWidth = lnf->getStringWidth(g.getCurrentFont(), str);
             g.drawFittedText(str, scaleFactor * 13, y - fontHeight, textWidth, fontHeight, juce::Justification::right, 1);
         }
         else
@@ -574,7 +759,7 @@ void ResponseCurveComponent::resized()
             str.clear();
             str << (gDb -24.f);
             
-            textWidth = glyphArrangement.getStringWidth(g.getCurrentFont(), str);
+            textWidth = lnf->getStringWidth(g.getCurrentFont(), str);
             g.drawFittedText(str, scaleFactor * 13, y - fontHeight / 2, textWidth, fontHeight, juce::Justification::right, 1);
         }
     }
@@ -594,6 +779,16 @@ juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
     return bounds;
 }
 
+juce::Rectangle<int> ResponseCurveComponent::getMeterArea()
+{
+    // The strip above the frequency labels
+    auto bounds = getRenderArea();
+    
+    float scaleFactor = float(getWidth() / 1150.0f);
+    
+    return bounds.withY(int(18 * scaleFactor)).withHeight(int(30 * scaleFactor));
+}
+
 juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
 {
     auto bounds = getRenderArea();
@@ -641,6 +836,30 @@ outputGainSliderAttachment(audioProcessor.apvts, "Output Gain", outputGainSlider
     outputGainSlider.labels.add({0.f, "-60dB"});
     outputGainSlider.labels.add({1.f, "0dB"});
     
+    // A/B switch between two complete parameter snapshots
+    snapshotButton.setColour(juce::TextButton::buttonColourId, theme.big_label_background_colour);
+    snapshotButton.setColour(juce::TextButton::textColourOffId, theme.big_label_colour);
+    snapshotButton.onClick = [this]
+    {
+        audioProcessor.toggleSnapshot();
+        updateSnapshotButton();
+    };
+    updateSnapshotButton();
+    audioProcessor.addChangeListener(this);
+    
+    // Instances with the same link group name share the leader's filter
+    linkGroupEditor.setColour(juce::TextEditor::backgroundColourId, theme.big_label_background_colour);
+    linkGroupEditor.setColour(juce::TextEditor::textColourId, theme.big_label_colour);
+    linkGroupEditor.setColour(juce::TextEditor::outlineColourId, juce::Colours::transparentBlack);
+    linkGroupEditor.setTextToShowWhenEmpty("LINK", theme.big_label_colour.withAlpha(0.5f));
+    linkGroupEditor.setJustification(juce::Justification::centred);
+    linkGroupEditor.setInputRestrictions(31);
+    updateLinkGroupEditor();
+    linkGroupEditor.onReturnKey = linkGroupEditor.onFocusLost = [this]
+    {
+        audioProcessor.setLinkGroup(linkGroupEditor.getText().trim());
+    };
+    
     
     for( auto* comp : getComps() )
     {
@@ -656,13 +875,41 @@ outputGainSliderAttachment(audioProcessor.apvts, "Output Gain", outputGainSlider
     
     // Set the initial size of the plugin window
     setSize (designWidth, designHeight);
+    
+   #if SDF_ENABLE_TRACE
+    setWantsKeyboardFocus(true);
+   #endif
+    
+    openTimeMilliseconds = juce::Time::getMillisecondCounterHiRes() - openStartTime;
+    openResidentMemoryMegabytes = getResidentMemoryMegabytes();
+    
+    DBG("Editor opened in " << juce::String(openTimeMilliseconds, 2)
+        << " ms, resident memory " << juce::String(openResidentMemoryMegabytes, 1) << " MB");
 
 }
 
 SimpleDualFilterAudioProcessorEditor::~SimpleDualFilterAudioProcessorEditor()
 {
+    audioProcessor.removeChangeListener(this);
 }
 
+#if SDF_ENABLE_TRACE
+bool SimpleDualFilterAudioProcessorEditor::keyPressed (const juce::KeyPress& key)
+{
+    if( key == juce::KeyPress('t', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0) )
+    {
+        auto file = Trace::getDefaultFile();
+        
+        if( Trace::writeJson(file) )
+            DBG("Trace written to " << file.getFullPathName());
+        
+        return true;
+    }
+    
+    return false;
+}
+#endif
+
 //==============================================================================
 void SimpleDualFilterAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -724,7 +971,7 @@ void SimpleDualFilterAudioProcessorEditor::resized()
     // This method allows for drawing on the edge of a component without cutting of anything
     grid.items = { GridItem (responseCurveComponent).withArea(1, 1, 3, 8), GridItem ().withArea(1, 8, 2, 8),
         GridItem (outputGainSlider).withArea(1, 9, 2, 9).withMargin(juce::GridItem::Margin(-20, -20, -20, -20)),
-        GridItem ().withArea(2, 9, 2, 9),
+        GridItem (snapshotButton).withArea(2, 9, 2, 9),
         GridItem (gainSlider).withArea(3, 1, 3, 1).withMargin(juce::GridItem::Margin(-20, -20, -20, -20)),
         GridItem ().withArea(3, 2, 3, 2),
         GridItem (qualitySlider).withArea(3, 3, 3, 3).withMargin(juce::GridItem::Margin(-20, -20, -20, -20)),
@@ -737,6 +984,12 @@ void SimpleDualFilterAudioProcessorEditor::resized()
     };
     
     grid.performLayout(bounds);
+    
+    // The A/B button and the link group name share one grid cell
+    auto cell = snapshotButton.getBounds();
+    snapshotButton.setBounds(cell.removeFromLeft(cell.getWidth() / 3));
+    linkGroupEditor.setBounds(cell.withTrimmedLeft(cell.getHeight() / 4));
+    linkGroupEditor.applyFontToAllText(juce::Font(cell.getHeight() * 0.6f));
 }
 
 std::vector<juce::Component*> SimpleDualFilterAudioProcessorEditor::getComps()
@@ -748,6 +1001,26 @@ std::vector<juce::Component*> SimpleDualFilterAudioProcessorEditor::getComps()
         &spanSlider,
         &balanceSlider,
         &responseCurveComponent,
-        &outputGainSlider
+        &outputGainSlider,
+        &snapshotButton,
+        &linkGroupEditor
     };
 }
+
+void SimpleDualFilterAudioProcessorEditor::updateSnapshotButton()
+{
+    snapshotButton.setButtonText(audioProcessor.getActiveSnapshot() == 0 ? "A" : "B");
+}
+
+void SimpleDualFilterAudioProcessorEditor::updateLinkGroupEditor()
+{
+    // Leave a name the user is still typing alone
+    if( ! linkGroupEditor.hasKeyboardFocus(false) )
+        linkGroupEditor.setText(audioProcessor.getLinkGroupName(), false);
+}
+
+void SimpleDualFilterAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    updateSnapshotButton();
+    updateLinkGroupEditor();
+}
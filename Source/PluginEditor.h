@@ -10,20 +10,42 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ResponseRenderer.h"
 
 // To do : better Colour names, adjust skew factor for freq parameter 
 
-// Features for another Version of this PlugIn: multimode Filters with changeable characteristics and possibly morphing between the different filters.
-
 
+// One LookAndFeel is shared by all editors in the process through juce::SharedResourcePointer,
+// together with the Rubik font and a cache of measured text widths.
 struct LookAndFeel : juce::LookAndFeel_V4
 {
+    LookAndFeel();
+    
     void drawRotarySlider (juce::Graphics&,
                            int x, int y, int width, int height,
                            float sliderPosProportional,
                            float rotaryStartAngle,
                            float rotaryEndAngle,
                            juce::Slider&) override;
+    
+    const juce::Font& getRubikFont() const { return rubikFont; }
+    
+    float getStringWidth(const juce::Font& font, const juce::String& text);
+    
+private:
+    juce::Font rubikFont;
+    
+    // Widths measured with one font, looked up by text alone so paint() doesn't build keys
+    struct FontWidths
+    {
+        juce::String typefaceName, typefaceStyle;
+        float height { 0 };
+        juce::HashMap<juce::String, float> widths;
+    };
+    
+    juce::OwnedArray<FontWidths> stringWidths;
+    
+    FontWidths& getFontWidths(const juce::Font& font);
 };
 
 struct RotarySliderWithLabels : juce::Slider
@@ -33,7 +55,7 @@ struct RotarySliderWithLabels : juce::Slider
     suffix(unitSuffix),
     labelName(labelName)
     {
-        setLookAndFeel(&lnf);
+        setLookAndFeel(&lnf.get());
     }
 
     ~RotarySliderWithLabels()    {
@@ -53,7 +75,7 @@ struct RotarySliderWithLabels : juce::Slider
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
 private:
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<LookAndFeel> lnf;
 
     juce::RangedAudioParameter* param;
     juce::String suffix;
@@ -61,8 +83,7 @@ private:
 };
 
 struct ResponseCurveComponent : juce::Component,
-juce::AudioProcessorParameter::Listener,
-juce::Timer
+juce::AudioProcessorParameter::Listener
 {
     ResponseCurveComponent(SimpleDualFilterAudioProcessor&);
     ~ResponseCurveComponent();
@@ -71,21 +92,53 @@ juce::Timer
     
     void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override { }
     
-    void timerCallback() override;
-    
     void paint(juce::Graphics& g) override;
     void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
 private:
     SimpleDualFilterAudioProcessor& audioProcessor;
     
+    juce::SharedResourcePointer<LookAndFeel> lnf;
+    
     juce::Atomic<bool> parametersChanged { false };
     
-    MonoChain monoChain;
+    // Pitch Track moves FREQ without a parameter change, so the curve watches the pitch too
+    float drawnTrackedFrequency { 0.f };
+    
+    // The curve is drawn by the renderer's worker thread, the message thread only blits it
+    ResponseRenderer renderer;
+    
+    // Only exists while the display is showing
+    std::unique_ptr<juce::VBlankAttachment> vblankAttachment;
+    
+    void updateRefreshState();
+    void refresh();
+    void submitFrame();
+    
+    std::array<BiquadCoefficients<double>, maxNumPeaks> peakCoefficients;
+    int numPeaks { 2 };
     
     void updateChain();
     
+    // Meter values drawn by the last paint, refreshed from the processor's atomics by refresh() on every VBlank
+    struct MeterReadings
+    {
+        std::array<float, LevelMeter::numChannels> inputPeak {}, inputRms {}, outputPeak {}, outputRms {};
+        float correlation { 1.f };
+    };
+    
+    MeterReadings meterReadings;
+    
+    bool updateMeterReadings();
+    void paintMeters(juce::Graphics& g);
+    juce::Rectangle<int> getMeterArea();
+    
+    // Created lazily on the first paint after a resize and released while hidden
     juce::Image background;
     
+    void renderBackground();
+    
     juce::Rectangle<int> getRenderArea();
     
     juce::Rectangle<int> getAnalysisArea();
@@ -94,7 +147,8 @@ private:
 //==============================================================================
 /**
 */
-class SimpleDualFilterAudioProcessorEditor  : public juce::AudioProcessorEditor
+class SimpleDualFilterAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                               private juce::ChangeListener
 {
 public:
     SimpleDualFilterAudioProcessorEditor (SimpleDualFilterAudioProcessor&);
@@ -103,12 +157,26 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    
+    // How long the constructor took, and the process's resident memory when it finished.
+    // The memory reads zero on platforms other than macOS and Linux.
+    double getOpenTimeMilliseconds() const { return openTimeMilliseconds; }
+    double getOpenResidentMemoryMegabytes() const { return openResidentMemoryMegabytes; }
+    
+   #if SDF_ENABLE_TRACE
+    // Ctrl/Cmd+Shift+T writes the trace to the desktop
+    bool keyPressed (const juce::KeyPress&) override;
+   #endif
 
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleDualFilterAudioProcessor& audioProcessor;
     
+    // Used to measure how long opening the editor takes
+    double openStartTime { juce::Time::getMillisecondCounterHiRes() };
+    double openTimeMilliseconds { 0 }, openResidentMemoryMegabytes { 0 };
+    
     RotarySliderWithLabels freqSlider,
     gainSlider,
     qualitySlider,
@@ -118,6 +186,17 @@ private:
     
     ResponseCurveComponent responseCurveComponent;
     
+    juce::TextButton snapshotButton;
+    
+    // Name of the link group, empty when the instance runs on its own
+    juce::TextEditor linkGroupEditor;
+    
+    void updateSnapshotButton();
+    void updateLinkGroupEditor();
+    
+    // Sent by the processor after a host restores the state
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
+    
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
     
@@ -16,16 +16,31 @@ SimpleDualFilterAudioProcessor::SimpleDualFilterAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for( auto* param : getParameters() )
+        if( auto* rangedParam = dynamic_cast<juce::RangedAudioParameter*>(param) )
+            stateParameters.add(rangedParam);
+    
+    jassert(stateParameters.size() <= StateData::maxParameters);
+    
+    // The library reads the layout from chainParameterTable, so the two must agree
+    jassert(stateParameters.size() == numChainParameters);
+    
+    for( int i = 0; i < juce::jmin(stateParameters.size(), numChainParameters); ++i )
+        jassert(stateParameters[i]->getParameterID() == chainParameterTable[i].id
+                && stateParameters[i]->getNormalisableRange().start == chainParameterTable[i].minimum
+                && stateParameters[i]->getNormalisableRange().end == chainParameterTable[i].maximum);
 }
 
 SimpleDualFilterAudioProcessor::~SimpleDualFilterAudioProcessor()
 {
+    setLinkGroup({});
 }
 
 //==============================================================================
@@ -96,20 +111,78 @@ void SimpleDualFilterAudioProcessor::prepareToPlay (double sampleRate, int sampl
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     
-    juce::dsp::ProcessSpec spec;
+    // Pick the kernel variant for this CPU once, outside the audio callback
+    peakKernel = forcedPeakKernel.value_or(getBestPeakKernel());
+    
+    peakChain2.setProcessFunction(getPeakKernelFunction<2, float>(peakKernel));
+    peakChain4.setProcessFunction(getPeakKernelFunction<4, float>(peakKernel));
+    peakChain8.setProcessFunction(getPeakKernelFunction<8, float>(peakKernel));
+    
+    parallelPeakChain2.setProcessFunctions(getParallelPeakKernelFunction<2, float>(peakKernel), getPeakKernelFunction<2, float>(peakKernel));
+    parallelPeakChain4.setProcessFunctions(getParallelPeakKernelFunction<4, float>(peakKernel), getPeakKernelFunction<4, float>(peakKernel));
+    parallelPeakChain8.setProcessFunctions(getParallelPeakKernelFunction<8, float>(peakKernel), getPeakKernelFunction<8, float>(peakKernel));
+    
+    morphChain2.setProcessFunction(getMorphKernelFunction<2, float>(peakKernel));
+    morphChain4.setProcessFunction(getMorphKernelFunction<4, float>(peakKernel));
+    morphChain8.setProcessFunction(getMorphKernelFunction<8, float>(peakKernel));
+    
+    saturator.setProcessFunction(getSaturatorKernelFunction<float>(peakKernel));
+    voiceBank.setProcessFunction(getVoiceBankKernelFunction<float>(peakKernel));
+    
+    // Like the block mode, the engine only changes here, so the chains never swap mid-stream
+    peakEngine = requestedPeakEngine;
+    
+    peakChain2.reset();
+    peakChain4.reset();
+    peakChain8.reset();
     
-    spec.maximumBlockSize = samplesPerBlock;
+    parallelPeakChain2.reset();
+    parallelPeakChain4.reset();
+    parallelPeakChain8.reset();
     
-    spec.numChannels = 1;
+    hqPeakChain2.reset();
+    hqPeakChain4.reset();
+    hqPeakChain8.reset();
     
-    spec.sampleRate = sampleRate;
+    morphChain2.reset();
+    morphChain4.reset();
+    morphChain8.reset();
     
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    hqMorphChain2.reset();
+    hqMorphChain4.reset();
+    hqMorphChain8.reset();
+    
+    saturator.reset();
+    hqSaturator.reset();
+    
+    voiceBank.reset();
+    hqVoiceBank.reset();
+    voicePool.reset();
+    
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+    renderQuality = isNonRealtime() ? RenderQuality::high : RenderQuality::standard;
+    
+    chainControl.prepare(sampleRate);
+    
+    pitchTracker.prepare(sampleRate);
+    pitchTrackSource = PitchTrackSource::off;
+    
+    inputMeter.prepare(sampleRate);
+    outputMeter.prepare(sampleRate);
     
     updateFilters();
     updateGain();
     
+    blockMode = requestedBlockMode;
+    internalBlockSize = requestedBlockSize;
+    
+    fifoBuffer.setSize(PeakChain<2>::maxChannels, blockMode == InternalBlockMode::buffered ? internalBlockSize : 0);
+    fifoBuffer.clear();
+    fifoPosition = 0;
+    
+    setLatencySamples(blockMode == InternalBlockMode::buffered ? internalBlockSize : 0);
+    
+    samplesUntilParameterUpdate = 0;
 }
 
 void SimpleDualFilterAudioProcessor::releaseResources()
@@ -137,6 +210,10 @@ bool SimpleDualFilterAudioProcessor::isBusesLayoutSupported (const BusesLayout&
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // The sidechain only feeds Pitch Track, which takes up to two channels
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet (true, 1).size() > 2)
+        return false;
    #endif
 
     return true;
@@ -146,7 +223,11 @@ bool SimpleDualFilterAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 
 void SimpleDualFilterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    SDF_TRACE_SCOPE("processBlock");
+    
     juce::ScopedNoDenormals noDenormals;
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, buffer.getNumSamples());
+    
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -159,29 +240,245 @@ void SimpleDualFilterAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
+
+    updateRenderQuality();
+    
+    // A restored state jumps to its values instead of smoothing there
+    if( stateRestorePending.exchange(false) )
+    {
+        updateFilters();
+        updateGain();
+    }
+    
+    // Without an internal block size the parameters are read at the start of every host block
+    if( blockMode == InternalBlockMode::off )
+        samplesUntilParameterUpdate = 0;
+    
+    // The sidechain's channels follow the main bus's in the buffer, they are never filtered
+    auto numChannels = juce::jmin(buffer.getNumChannels(), getMainBusNumOutputChannels(), PeakChain<2>::maxChannels);
+    
+    inputMeter.process(buffer.getArrayOfReadPointers(), juce::jmin(numChannels, getMainBusNumInputChannels()), buffer.getNumSamples());
+    
+    pushToPitchTracker(buffer, numChannels);
+    
+    if( blockMode == InternalBlockMode::buffered )
+    {
+        // The FIFO delays the audio by a whole internal block, so the notes start with the host block
+        for( const auto metadata : midiMessages )
+            handleMidiMessage(metadata.getMessage());
+        
+        processBuffered(buffer, numChannels);
+    }
+    else
+    {
+        processWithMidi(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples(), midiMessages);
+    }
     
+    outputMeter.process(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+}
+
+void SimpleDualFilterAudioProcessor::updateTargets()
+{
     // Get current settings, including output gain
-    ChainSettings chainSettings = getChainSettings(apvts);
+    auto chainSettings = withTrackedFrequency(chainParameters.load());
+    auto current = chainControl.getCurrentSettings();
     
-    updateFilters();
-    updateGain();
+    chainControl.setTargetSettings(chainSettings);
+    
+    // A new A/B table changes the design even with the parameters settled
+    if( snapshotMorph.update(chainSettings, getSampleRate()) && (chainSettings.snapshotMorph > 0.f || current.snapshotMorph > 0.f) )
+        chainControl.requestRedesign();
+    
+    if( chainSettings.keyTrack != keyTrackActive )
+        selectKeyTrack(chainSettings.keyTrack);
+    
+    // Followers take the band count from the leader
+    if( chainSettings.numPeaks != activeNumPeaks && ! isFollowingLinkGroup() )
+        updatePeakFilter(chainControl.getCurrentSettings());
+}
 
-    juce::dsp::AudioBlock<float> block(buffer);
+void SimpleDualFilterAudioProcessor::processChain(float* const* channels, int numChannels, int numSamples)
+{
+    auto interval = getEffectiveControlInterval();
+    
+    for( int start = 0; start < numSamples; )
+    {
+        if( samplesUntilParameterUpdate <= 0 )
+        {
+            updateTargets();
+            
+            samplesUntilParameterUpdate = blockMode == InternalBlockMode::off ? std::numeric_limits<int>::max()
+                                                                              : internalBlockSize;
+        }
+        
+        // While parameters move, design new coefficients every control interval and let
+        // the chain ramp towards them. Once settled, the chain runs without redesigns.
+        if( chainControl.isControlTickDue() )
+        {
+            // The analyses run here rather than per host block, at most one per tick and hop
+            if( pitchTrackSource != PitchTrackSource::off && pitchTracker.analyse() )
+                chainControl.setTargetFrequency(withTrackedFrequency(chainParameters.load()).peak1Freq);
+            
+            // The voices neither lead nor follow a link group, their notes are their own
+            auto* group = keyTrackActive ? nullptr : linkGroup.load();
+            auto following = group != nullptr && ! group->isLeader(this);
+            auto voicesMoving = keyTrackActive && voicePool.isMoving();
+            
+            if( keyTrackActive )
+            {
+                if( chainControl.needsDesign() || voicesMoving )
+                    updateVoiceBank(chainControl.skip(interval), interval);
+            }
+            else if( following )
+                followLinkGroup(*group, interval);
+            else if( chainControl.needsDesign() || (group != nullptr && group->needsPublish()) )
+                rampPeakFilter(chainControl.skip(interval), interval);
+            
+            // Idle ticks only check for work, so they needn't come as often as designs in the high quality profile
+            auto busy = following || voicesMoving || chainControl.isSmoothing();
+            chainControl.finishControlTick(busy ? interval : juce::jmax(interval, maxControlInterval));
+        }
+        
+        auto numChunkSamples = juce::jmin(numSamples - start, chainControl.getSamplesUntilControlTick(), samplesUntilParameterUpdate);
+        
+        float* chunk[PeakChain<2>::maxChannels] {};
+        
+        for( int ch = 0; ch < numChannels; ++ch )
+            chunk[ch] = channels[ch] + start;
+        
+        // Process the active peak chain for left and right channels.
+        // The output gain is applied by the chain after the last peak.
+        if( keyTrackActive )
+        {
+            processVoiceBank(chunk, numChannels, numChunkSamples);
+        }
+        else
+        {
+            withPeakChain(activeNumPeaks, [&](auto& chain)
+            {
+                processPeakChain(chain, chunk, numChannels, numChunkSamples);
+            });
+        }
+        
+        start += numChunkSamples;
+        chainControl.advance(numChunkSamples);
+        samplesUntilParameterUpdate -= numChunkSamples;
+    }
+}
+
+void SimpleDualFilterAudioProcessor::processWithMidi(float* const* channels, int numChannels, int numSamples,
+                                                     const juce::MidiBuffer& midiMessages)
+{
+    // Notes start at their own sample, so the chain runs in pieces between the events
+    float* piece[PeakChain<2>::maxChannels] {};
+    int start = 0;
+    
+    auto processUpTo = [&](int end)
+    {
+        if( end <= start )
+            return;
+        
+        for( int ch = 0; ch < numChannels; ++ch )
+            piece[ch] = channels[ch] + start;
+        
+        processChain(piece, numChannels, end - start);
+        start = end;
+    };
     
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    for( const auto metadata : midiMessages )
+    {
+        processUpTo(juce::jlimit(start, numSamples, metadata.samplePosition));
+        handleMidiMessage(metadata.getMessage());
+    }
     
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    processUpTo(numSamples);
+}
 
-    // Process the filters for left and right channels
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+void SimpleDualFilterAudioProcessor::handleMidiMessage(const juce::MidiMessage& message)
+{
+    // Notes are taken on every channel. The pool follows them with Key Track off too,
+    // so switching it on picks up the notes already held.
+    if( message.isNoteOn() )
+        voicePool.noteOn(message.getNoteNumber(), message.getFloatVelocity());
+    else if( message.isNoteOff() )
+        voicePool.noteOff(message.getNoteNumber());
+    else if( message.isAllNotesOff() )
+        voicePool.allNotesOff();
+    else if( message.isAllSoundOff() )
+        voicePool.reset();
+    else
+        return;
     
-    // Apply output gain to both channels after processing the filters
-        float outputGain = juce::Decibels::decibelsToGain(chainSettings.outputGain); // Convert dB to gain
-        buffer.applyGain(outputGain); // Apply gain to the entire buffer
+    // Design the new notes right away rather than on the next idle tick
+    chainControl.triggerControlTick();
+}
 
+void SimpleDualFilterAudioProcessor::pushToPitchTracker(juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    auto source = chainParameters.load().pitchTrack;
+    
+    // A new source starts from scratch rather than from a window of the old one
+    if( source != pitchTrackSource )
+    {
+        pitchTracker.reset();
+        pitchTrackSource = source;
+    }
+    
+    if( source == PitchTrackSource::off )
+        return;
+    
+    auto* sidechainBus = getBus(true, 1);
+    
+    if( source == PitchTrackSource::sidechain && sidechainBus != nullptr && sidechainBus->isEnabled() )
+    {
+        auto sidechain = sidechainBus->getBusBuffer(buffer);
+        pitchTracker.push(sidechain.getArrayOfReadPointers(), juce::jmin(sidechain.getNumChannels(), 2), sidechain.getNumSamples());
+    }
+    else
+    {
+        pitchTracker.push(buffer.getArrayOfReadPointers(), juce::jmin(numChannels, getMainBusNumInputChannels()), buffer.getNumSamples());
+    }
+}
+
+ChainSettings SimpleDualFilterAudioProcessor::withTrackedFrequency(ChainSettings chainSettings) const
+{
+    auto trackedFrequency = pitchTracker.getFrequency();
+    
+    // Kept within FREQ's range, until the first pitch FREQ stays as set
+    if( chainSettings.pitchTrack != PitchTrackSource::off && trackedFrequency > 0.f )
+        chainSettings.peak1Freq = juce::jlimit(20.f, 10000.f, trackedFrequency);
+    
+    return chainSettings;
+}
+
+void SimpleDualFilterAudioProcessor::processBuffered(juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    // The host's samples are swapped into the FIFO for the ones processed during the
+    // previous internal block, so the chain only ever runs on whole internal blocks
+    auto numSamples = buffer.getNumSamples();
+    
+    for( int start = 0; start < numSamples; )
+    {
+        auto numChunkSamples = juce::jmin(numSamples - start, internalBlockSize - fifoPosition);
+        
+        for( int ch = 0; ch < numChannels; ++ch )
+        {
+            auto* io = buffer.getWritePointer(ch, start);
+            auto* fifo = fifoBuffer.getWritePointer(ch, fifoPosition);
+            
+            for( int i = 0; i < numChunkSamples; ++i )
+                std::swap(io[i], fifo[i]);
+        }
+        
+        start += numChunkSamples;
+        fifoPosition += numChunkSamples;
+        
+        if( fifoPosition == internalBlockSize )
+        {
+            processChain(fifoBuffer.getArrayOfWritePointers(), numChannels, internalBlockSize);
+            fifoPosition = 0;
+        }
+    }
 }
 
 //==============================================================================
@@ -199,12 +496,23 @@ juce::AudioProcessorEditor* SimpleDualFilterAudioProcessor::createEditor()
 //==============================================================================
 void SimpleDualFilterAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // The parameters are written as one fixed-layout block. That is much cheaper
+    // than serialising the ValueTree, and hosts call this often for autosave.
+    
+    StateData data;
+    data.numParameters = (juce::uint32) stateParameters.size();
+    readParameterValues(data.values);
+    
+    {
+        const juce::ScopedLock sl(snapshotLock);
+        std::memcpy(data.snapshots, snapshots, sizeof(snapshots));
+        data.snapshotMask = snapshotMask;
+        data.activeSnapshot = activeSnapshot;
+    }
     
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    getLinkGroupName().copyToUTF8(data.linkGroup, sizeof(data.linkGroup));
+    
+    destData.replaceAll(&data, sizeof(data));
 }
 
 void SimpleDualFilterAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -212,85 +520,637 @@ void SimpleDualFilterAudioProcessor::setStateInformation (const void* data, int
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
     
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if( tree.isValid() )
+    // Blocks written by older versions are shorter, the fields they lack keep their defaults
+    constexpr auto version1Size = offsetof(StateData, linkGroup);
+    
+    StateData state;
+    std::memcpy(&state, data, (size_t) juce::jlimit(0, (int) sizeof(StateData), sizeInBytes));
+    
+    auto requiredSize = state.version >= 2 ? sizeof(StateData) : version1Size;
+    
+    if( sizeInBytes >= (int) version1Size
+       && state.magic == StateData::magicNumber
+       && state.version <= StateData::currentVersion
+       && sizeInBytes >= (int) requiredSize )
     {
+        state.linkGroup[sizeof(state.linkGroup) - 1] = 0;
+        setLinkGroup(juce::CharPointer_UTF8(state.linkGroup));
+        
+        writeParameterValues(state.values, (int) juce::jmin(state.numParameters, (juce::uint32) StateData::maxParameters));
+        
+        const juce::ScopedLock sl(snapshotLock);
+        std::memcpy(snapshots, state.snapshots, sizeof(snapshots));
+        snapshotMask = state.snapshotMask;
+        activeSnapshot = juce::jlimit(0, StateData::numSnapshots - 1, (int) state.activeSnapshot);
+        updateSnapshotMorph();
+    }
+    else
+    {
+        // Sessions saved before the binary format hold the whole ValueTree
+        auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+        if( ! tree.isValid() )
+            return;
+        
         apvts.replaceState(tree);
-        updateFilters();
-        updateGain();
+        
+        const juce::ScopedLock sl(snapshotLock);
+        snapshotMask = 0;
+        activeSnapshot = 0;
+        updateSnapshotMorph();
     }
+    
+    // Hosts restore from any thread, the chains are redesigned by the next processBlock
+    stateRestorePending = true;
+    sendChangeMessage();
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+void SimpleDualFilterAudioProcessor::readParameterValues(float* values) const
+{
+    for( int i = 0; i < stateParameters.size(); ++i )
+    {
+        auto* param = stateParameters.getUnchecked(i);
+        values[i] = param->convertFrom0to1(param->getValue());
+    }
+}
+
+void SimpleDualFilterAudioProcessor::writeParameterValues(const float* values, int numValues)
 {
-    ChainSettings settings;
+    // Parameters that did not exist when the values were stored go back to their defaults
+    for( int i = 0; i < stateParameters.size(); ++i )
+    {
+        auto* param = stateParameters.getUnchecked(i);
+        auto normalisedValue = i < numValues ? param->convertTo0to1(values[i]) : param->getDefaultValue();
+        param->setValueNotifyingHost(normalisedValue);
+    }
+}
+
+//==============================================================================
+void SimpleDualFilterAudioProcessor::storeSnapshot(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, StateData::numSnapshots));
+    
+    const juce::ScopedLock sl(snapshotLock);
+    readParameterValues(snapshots[slot]);
+    snapshotMask |= 1u << slot;
     
-    settings.peak1Freq = apvts.getRawParameterValue("Peak1 Freq")->load();
-    settings.peak1GainInDecibels = apvts.getRawParameterValue("Peak1 Gain")->load();
-    settings.peak1Quality = apvts.getRawParameterValue("Peak1 Quality")->load();
-//    settings.peak2Freq = apvts.getRawParameterValue("Peak2 Freq")->load();
-//    settings.peak2GainInDecibels = apvts.getRawParameterValue("Peak2 Gain")->load();
-//    settings.peak2Quality = apvts.getRawParameterValue("Peak2 Quality")->load();
-    settings.span = apvts.getRawParameterValue("Span")->load();
-    settings.balance = apvts.getRawParameterValue("Balance")->load();
-    settings.outputGain = apvts.getRawParameterValue("Output Gain")->load();
+    updateSnapshotMorph();
+}
+
+void SimpleDualFilterAudioProcessor::recallSnapshot(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, StateData::numSnapshots));
+    
+    const juce::ScopedLock sl(snapshotLock);
+    
+    if( snapshotMask & (1u << slot) )
+    {
+        float values[StateData::maxParameters];
+        std::copy(std::begin(snapshots[slot]), std::end(snapshots[slot]), values);
+        
+        // A/B MORPH moves between the snapshots, so it stays where it is
+        auto morphIndex = stateParameters.indexOf(apvts.getParameter("A/B Morph"));
+        
+        if( auto* param = stateParameters[morphIndex] )
+            values[morphIndex] = param->convertFrom0to1(param->getValue());
+        
+        writeParameterValues(values, stateParameters.size());
+    }
+    
+    activeSnapshot = slot;
+}
 
-    return settings;
+void SimpleDualFilterAudioProcessor::toggleSnapshot()
+{
+    const juce::ScopedLock sl(snapshotLock);
+    
+    // Keep the edits made on the current slot, then switch to the other one.
+    // An empty slot starts as a copy of the current settings.
+    storeSnapshot(activeSnapshot);
+    
+    auto other = 1 - activeSnapshot;
+    
+    if( (snapshotMask & (1u << other)) == 0 )
+        storeSnapshot(other);
+    
+    recallSnapshot(other);
+}
+
+int SimpleDualFilterAudioProcessor::getActiveSnapshot() const
+{
+    const juce::ScopedLock sl(snapshotLock);
+    return activeSnapshot;
+}
+
+ChainSettings SimpleDualFilterAudioProcessor::getMorphedChainSettings() const
+{
+    return snapshotMorph.getMorphedSettings(withTrackedFrequency(chainParameters.load()));
+}
+
+void SimpleDualFilterAudioProcessor::updateSnapshotMorph()
+{
+    const juce::ScopedLock sl(snapshotLock);
+    
+    if( (snapshotMask & 3u) == 3u )
+        snapshotMorph.setSnapshots(snapshots[0], snapshots[1]);
+    else
+        snapshotMorph.clearSnapshots();
+}
+
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    return ChainParameters(apvts).load();
+}
+
+ChainParameters::ChainParameters(juce::AudioProcessorValueTreeState& apvts)
+{
+    for( int i = 0; i < numChainParameters; ++i )
+        values[i] = apvts.getRawParameterValue(chainParameterTable[i].id);
+}
+
+ChainSettings ChainParameters::load() const
+{
+    return makeChainSettings([this](int index) { return values[index]->load(); });
 }
 
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                               chainSettings.peak1Freq,
-                                                               chainSettings.peak1Quality,
-                                                               juce::Decibels::decibelsToGain(chainSettings.peak1GainInDecibels - chainSettings.balance));
+    // First peak of the dual peak chain
+    auto c = makePeakBandCoefficients<float>(chainSettings, 0, 2, sampleRate);
+    return Coefficients(new juce::dsp::IIR::Coefficients<float>(c.b0, c.b1, c.b2, 1.f, c.a1, c.a2));
 }
 
 Coefficients makePeakFilter2(const ChainSettings& chainSettings, double sampleRate)
 {
     // Span spaces the second filter based on a percentage of the first frequency
-    double spanFactor = 1.0 + (chainSettings.span / 2.0);
+    auto c = makePeakBandCoefficients<float>(chainSettings, 1, 2, sampleRate);
+    return Coefficients(new juce::dsp::IIR::Coefficients<float>(c.b0, c.b1, c.b2, 1.f, c.a1, c.a2));
+}
+
+void SimpleDualFilterAudioProcessor::updatePeakFilter(const ChainSettings &parameterSettings)
+{
+    SDF_TRACE_SCOPE("updatePeakFilter");
+    
+    // Jumps are rare, so they design from the A/B settings rather than read the table
+    auto chainSettings = snapshotMorph.apply(parameterSettings);
+    
+    // Start a newly selected chain from silence instead of its stale state
+    auto newChain = chainSettings.numPeaks != activeNumPeaks;
+    
+    if( newChain )
+    {
+        morphActive = usesMorphCore(chainSettings);
+        
+        withPeakChain(chainSettings.numPeaks, [](auto& chain) { chain.reset(); });
+        
+        activeNumPeaks = chainSettings.numPeaks;
+    }
+    else
+    {
+        selectMorphCore(usesMorphCore(chainSettings));
+    }
+    
+    withPeakChain(chainSettings.numPeaks, [&chainSettings, newChain, this](auto& chain)
+    {
+        chain.updateCoefficients(chainSettings, getSampleRate());
+        
+        auto& coefficients = chain.getCoefficients();
+        
+        // The make-up gain needs the new design
+        if( newChain )
+            chain.setGainLinear(chainControl.getChainGainLinear(chainSettings, coefficients.data(), (int) coefficients.size()));
+        
+        publishToLinkGroup(chainSettings, coefficients.data(), (int) coefficients.size(), float(chain.getGainLinear()));
+    });
+    
+    updateSaturator(chainSettings);
+}
+
+void SimpleDualFilterAudioProcessor::rampPeakFilter(const ChainSettings &parameterSettings, int numSamples)
+{
+    SDF_TRACE_SCOPE("rampPeakFilter");
+    
+    // The settings the A/B position stands for, designed from until the table fits and published to followers
+    auto chainSettings = snapshotMorph.apply(parameterSettings);
+    
+    // With a table for these settings A/B MORPH only interpolates coefficients
+    auto* table = snapshotMorph.isEngaged(parameterSettings) ? snapshotMorph.getTable(parameterSettings, getSampleRate())
+                                                             : nullptr;
+    
+    selectMorphCore(usesMorphCore(chainSettings));
     
-    // Ensure the frequency does not exceed Nyquist or fall below a certain minimum
-    double peak2Freq = juce::jlimit(20.0, sampleRate / 2.0, chainSettings.peak1Freq * spanFactor);
+    withPeakChain(activeNumPeaks, [&chainSettings, &parameterSettings, table, numSamples, this](auto& chain)
+    {
+        typename std::decay_t<decltype(chain)>::CoefficientArray coefficients;
+        
+        if( table != nullptr && table->numPeaks == (int) coefficients.size() )
+            table->getCoefficients(parameterSettings.snapshotMorph, coefficients);
+        else
+            coefficients = chain.makeCoefficients(chainSettings, getSampleRate());
+        
+        auto gainCoefficient = chainControl.rampChain(chain, coefficients, chainSettings, numSamples);
+        
+        publishToLinkGroup(chainSettings, coefficients.data(), (int) coefficients.size(), gainCoefficient);
+    });
+    
+    updateSaturator(chainSettings, numSamples);
+}
 
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                               peak2Freq,
-                                                               chainSettings.peak1Quality,
-                                                               juce::Decibels::decibelsToGain(chainSettings.peak1GainInDecibels + chainSettings.balance));
+void SimpleDualFilterAudioProcessor::updateSaturator(const ChainSettings& chainSettings, int numSamples)
+{
+    chainControl.updateSaturator(chainSettings, numSamples, [this](auto&& process)
+    {
+        process(saturator);
+        process(hqSaturator);
+    });
+}
+
+void SimpleDualFilterAudioProcessor::selectKeyTrack(bool shouldTrack)
+{
+    if( shouldTrack == keyTrackActive )
+        return;
+    
+    // The two have nothing in common to hand over, so the one taking over ramps in from silence
+    if( shouldTrack )
+    {
+        voiceBank.reset();
+        hqVoiceBank.reset();
+    }
+    else
+    {
+        withPeakChain(activeNumPeaks, [](auto& chain) { chain.reset(); });
+    }
+    
+    keyTrackActive = shouldTrack;
+    chainControl.requestRedesign();
 }
 
+void SimpleDualFilterAudioProcessor::updateVoiceBank(const ChainSettings& parameterSettings, int numSamples)
+{
+    SDF_TRACE_SCOPE("updateVoiceBank");
+    
+    // A/B MORPH moves the voices' GAIN, QUAL, SPAN and BAL like the bands'
+    auto chainSettings = snapshotMorph.apply(parameterSettings);
+    
+    VoiceBankCoefficients<double> coefficients;
+    voicePool.design(chainSettings, getSampleRate(), numSamples, coefficients);
+    
+    // Auto Gain doesn't apply, its make-up gain is for a cascade and the voices change with every note
+    auto gainCoefficient = juce::Decibels::decibelsToGain(getChainGainInDecibels(chainSettings));
+    
+    if( renderQuality.load(std::memory_order_relaxed) == RenderQuality::high )
+        hqVoiceBank.setTarget(coefficients, double(gainCoefficient), numSamples);
+    else
+        voiceBank.setTarget(VoiceBankCoefficients<float>(coefficients), gainCoefficient, numSamples);
+    
+    updateSaturator(chainSettings, numSamples);
+}
+
+void SimpleDualFilterAudioProcessor::processVoiceBank(float* const* channels, int numChannels, int numSamples)
+{
+    if( renderQuality.load(std::memory_order_relaxed) == RenderQuality::high )
+    {
+        processConverted(channels, numChannels, numSamples, [this](double* const* hqChannels, int numHqChannels, int numHqSamples)
+        {
+            hqVoiceBank.process(hqChannels, numHqChannels, numHqSamples);
+            
+            if( chainControl.isSaturatorActive() )
+                hqSaturator.process(hqChannels, numHqChannels, numHqSamples);
+        });
+        
+        return;
+    }
+    
+    voiceBank.process(channels, numChannels, numSamples);
+    
+    if( chainControl.isSaturatorActive() )
+        saturator.process(channels, numChannels, numSamples);
+}
+
+void SimpleDualFilterAudioProcessor::selectMorphCore(bool shouldMorph)
+{
+    if( shouldMorph == morphActive )
+        return;
+    
+    if( renderQuality.load(std::memory_order_relaxed) == RenderQuality::high )
+    {
+        switch( activeNumPeaks )
+        {
+            case 4:  handOverMorphCore(hqPeakChain4, hqMorphChain4, shouldMorph); break;
+            case 8:  handOverMorphCore(hqPeakChain8, hqMorphChain8, shouldMorph); break;
+            default: handOverMorphCore(hqPeakChain2, hqMorphChain2, shouldMorph); break;
+        }
+    }
+    else if( peakEngine == PeakEngine::parallel )
+    {
+        switch( activeNumPeaks )
+        {
+            case 4:  handOverMorphCore(parallelPeakChain4, morphChain4, shouldMorph); break;
+            case 8:  handOverMorphCore(parallelPeakChain8, morphChain8, shouldMorph); break;
+            default: handOverMorphCore(parallelPeakChain2, morphChain2, shouldMorph); break;
+        }
+    }
+    else
+    {
+        switch( activeNumPeaks )
+        {
+            case 4:  handOverMorphCore(peakChain4, morphChain4, shouldMorph); break;
+            case 8:  handOverMorphCore(peakChain8, morphChain8, shouldMorph); break;
+            default: handOverMorphCore(peakChain2, morphChain2, shouldMorph); break;
+        }
+    }
+    
+    morphActive = shouldMorph;
+}
+
+//==============================================================================
+void SimpleDualFilterAudioProcessor::getFrequencyResponse(const double* frequencies, int numPoints,
+                                                          double* magnitudes, double* phases, double* groupDelays) const
+{
+    getFrequencyResponse(getMorphedChainSettings(), frequencies, numPoints, magnitudes, phases, groupDelays);
+}
+
+void SimpleDualFilterAudioProcessor::getFrequencyResponse(const ChainSettings& chainSettings, const double* frequencies, int numPoints,
+                                                          double* magnitudes, double* phases, double* groupDelays) const
+{
+    auto sampleRate = getSampleRate() > 0 ? getSampleRate() : 44100.0;
+    
+    computeChainResponse(chainSettings, sampleRate, frequencies, numPoints, magnitudes, phases, groupDelays);
+}
+
+//==============================================================================
+void SimpleDualFilterAudioProcessor::setLinkGroup(const juce::String& name)
+{
+    const juce::ScopedLock sl(linkGroupLock);
+    
+    auto* current = linkGroup.load();
+    
+    if( current != nullptr && current->getName() == name )
+        return;
+    
+    // Groups are never deleted, so the audio thread may still finish its tick with the old one
+    linkGroup = nullptr;
+    
+    if( current != nullptr )
+        current->leave(this);
+    
+    if( name.isNotEmpty() )
+        linkGroup = &LinkGroup::join(name, this);
+}
 
-void SimpleDualFilterAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
+juce::String SimpleDualFilterAudioProcessor::getLinkGroupName() const
 {
-    auto peak1Coefficients = makePeakFilter(chainSettings, getSampleRate());
+    auto* group = linkGroup.load();
+    return group != nullptr ? group->getName() : juce::String();
+}
 
-    auto peak2Coefficients = makePeakFilter2(chainSettings, getSampleRate());
+bool SimpleDualFilterAudioProcessor::isLinkLeader() const
+{
+    auto* group = linkGroup.load();
+    return group != nullptr && group->isLeader(this);
+}
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak1>().coefficients, peak1Coefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak1>().coefficients, peak1Coefficients);
+bool SimpleDualFilterAudioProcessor::isFollowingLinkGroup() const
+{
+    auto* group = linkGroup.load();
+    return group != nullptr && ! group->isLeader(this);
+}
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak2>().coefficients, peak2Coefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak2>().coefficients, peak2Coefficients);
+void SimpleDualFilterAudioProcessor::followLinkGroup(LinkGroup& group, int numSamples)
+{
+    if( &group != followedGroup )
+    {
+        followedGroup = &group;
+        lastLinkSequence = 0;
+    }
+    
+    LinkedState state;
+    
+    if( ! group.read(state, lastLinkSequence) )
+        return;
+    
+    if( state.settings.numPeaks != activeNumPeaks )
+        updatePeakFilter(state.settings);
+    
+    selectMorphCore(usesMorphCore(state.settings));
+    
+    // Coefficients designed for another sample rate don't fit, only the settings are shared then
+    if( state.sampleRate != float(getSampleRate()) )
+    {
+        rampPeakFilter(state.settings, numSamples);
+        return;
+    }
+    
+    withPeakChain(activeNumPeaks, [&state, numSamples](auto& chain)
+    {
+        using Chain = std::decay_t<decltype(chain)>;
+        typename Chain::CoefficientArray coefficients;
+        
+        for( size_t band = 0; band < coefficients.size(); ++band )
+            coefficients[band] = typename Chain::Coefficients(state.coefficients[band]);
+        
+        chain.setTarget(coefficients, state.gain, numSamples);
+    });
+    
+    updateSaturator(state.settings, numSamples);
 }
 
-void updateCoefficients(Coefficients &old, const Coefficients &replacements)
+template <typename SectionCoefficients>
+void SimpleDualFilterAudioProcessor::publishToLinkGroup(const ChainSettings& chainSettings,
+                                                        const SectionCoefficients* coefficients,
+                                                        int numPeaks,
+                                                        float gain)
 {
-    *old = *replacements;
+    auto* group = linkGroup.load();
+    
+    if( group == nullptr || ! group->isLeader(this) )
+        return;
+    
+    LinkedState state;
+    state.settings = chainSettings;
+    state.settings.numPeaks = numPeaks;
+    
+    for( int band = 0; band < numPeaks; ++band )
+        state.coefficients[(size_t) band] = BiquadCoefficients<float>(coefficients[band]);
+    
+    state.gain = gain;
+    state.sampleRate = float(getSampleRate());
+    
+    group->publish(state);
 }
 
 void SimpleDualFilterAudioProcessor::updateFilters()
 {
-    auto chainSettings = getChainSettings(apvts);
+    auto chainSettings = chainParameters.load();
+    chainControl.setCurrentSettings(chainSettings);
     updatePeakFilter(chainSettings);
+    
+    keyTrackActive = chainSettings.keyTrack;
+    updateVoiceBank(chainSettings, 0);
+}
+
+void SimpleDualFilterAudioProcessor::setInternalBlockMode(InternalBlockMode mode, int blockSize)
+{
+    requestedBlockMode = mode;
+    requestedBlockSize = juce::jlimit(minInternalBlockSize, maxInternalBlockSize, blockSize);
+}
+
+void SimpleDualFilterAudioProcessor::forcePeakKernel(PeakKernel kernel)
+{
+    jassert(isPeakKernelSupported(kernel));
+    forcedPeakKernel = kernel;
+}
+
+void SimpleDualFilterAudioProcessor::clearForcedPeakKernel()
+{
+    forcedPeakKernel.reset();
+}
+
+void SimpleDualFilterAudioProcessor::setControlInterval(int numSamples)
+{
+    controlInterval.store(juce::jlimit(minControlInterval, maxControlInterval, numSamples));
 }
 
 void SimpleDualFilterAudioProcessor::updateGain()
 {
-    auto chainSettings = getChainSettings(apvts);
-    auto gainCoefficient = juce::Decibels::decibelsToGain(chainSettings.outputGain);
-    leftChain.get<ChainPositions::outputGain>().setGainLinear(gainCoefficient);
-    rightChain.get<ChainPositions::outputGain>().setGainLinear(gainCoefficient);
+    SDF_TRACE_SCOPE("updateGain");
+    
+    // The make-up gain follows the active chain's design, the others get theirs when selected
+    auto chainSettings = snapshotMorph.apply(chainParameters.load());
+    auto gainCoefficient = 0.f;
+    
+    withPeakChain(activeNumPeaks, [&chainSettings, &gainCoefficient, this](auto& chain)
+    {
+        auto& coefficients = chain.getCoefficients();
+        gainCoefficient = chainControl.getChainGainLinear(chainSettings, coefficients.data(), (int) coefficients.size());
+    });
+    
+    peakChain2.setGainLinear(gainCoefficient);
+    peakChain4.setGainLinear(gainCoefficient);
+    peakChain8.setGainLinear(gainCoefficient);
+    parallelPeakChain2.setGainLinear(gainCoefficient);
+    parallelPeakChain4.setGainLinear(gainCoefficient);
+    parallelPeakChain8.setGainLinear(gainCoefficient);
+    hqPeakChain2.setGainLinear(gainCoefficient);
+    hqPeakChain4.setGainLinear(gainCoefficient);
+    hqPeakChain8.setGainLinear(gainCoefficient);
+    morphChain2.setGainLinear(gainCoefficient);
+    morphChain4.setGainLinear(gainCoefficient);
+    morphChain8.setGainLinear(gainCoefficient);
+    hqMorphChain2.setGainLinear(gainCoefficient);
+    hqMorphChain4.setGainLinear(gainCoefficient);
+    hqMorphChain8.setGainLinear(gainCoefficient);
+    
+    // The voices go without the make-up gain, see updateVoiceBank
+    auto voiceGainCoefficient = juce::Decibels::decibelsToGain(getChainGainInDecibels(chainSettings));
+    voiceBank.setGainLinear(voiceGainCoefficient);
+    hqVoiceBank.setGainLinear(double(voiceGainCoefficient));
+    
+    updateSaturator(chainSettings);
+}
+
+void SimpleDualFilterAudioProcessor::setLightProfile(float loadThreshold, int numSamples)
+{
+    lightLoadThreshold.store(juce::jmax(0.f, loadThreshold));
+    lightControlInterval.store(juce::jlimit(minControlInterval, maxControlInterval, numSamples));
+}
+
+RenderQuality SimpleDualFilterAudioProcessor::selectRenderQuality() const
+{
+    if( isNonRealtime() )
+        return RenderQuality::high;
+    
+    auto threshold = lightLoadThreshold.load();
+    
+    if( threshold <= 0.f )
+        return RenderQuality::standard;
+    
+    // Some hysteresis, so a load around the threshold doesn't switch on every block
+    auto load = float(loadMeasurer.getLoadAsProportion());
+    
+    if( renderQuality.load() == RenderQuality::light )
+        return load > threshold * 0.8f ? RenderQuality::light : RenderQuality::standard;
+    
+    return load > threshold ? RenderQuality::light : RenderQuality::standard;
+}
+
+void SimpleDualFilterAudioProcessor::updateRenderQuality()
+{
+    auto quality = selectRenderQuality();
+    auto previous = renderQuality.load();
+    
+    if( quality == previous )
+        return;
+    
+    // Switching precision hands the running filter over to the other chain,
+    // the light profile only changes how often coefficients are designed
+    auto toHigh = quality == RenderQuality::high;
+    
+    if( toHigh != (previous == RenderQuality::high) )
+    {
+        auto handOver = [toHigh](auto& chain, auto& hqChain)
+        {
+            if( toHigh )
+                transferChainState(hqChain, chain);
+            else
+                transferChainState(chain, hqChain);
+        };
+        
+        if( toHigh )
+        {
+            hqSaturator.copyStateFrom(saturator);
+            hqVoiceBank.copyStateFrom(voiceBank);
+        }
+        else
+        {
+            saturator.copyStateFrom(hqSaturator);
+            voiceBank.copyStateFrom(hqVoiceBank);
+        }
+        
+        if( morphActive )
+        {
+            switch( activeNumPeaks )
+            {
+                case 4:  handOver(morphChain4, hqMorphChain4); break;
+                case 8:  handOver(morphChain8, hqMorphChain8); break;
+                default: handOver(morphChain2, hqMorphChain2); break;
+            }
+        }
+        else if( peakEngine == PeakEngine::parallel )
+        {
+            switch( activeNumPeaks )
+            {
+                case 4:  handOver(parallelPeakChain4, hqPeakChain4); break;
+                case 8:  handOver(parallelPeakChain8, hqPeakChain8); break;
+                default: handOver(parallelPeakChain2, hqPeakChain2); break;
+            }
+        }
+        else
+        {
+            switch( activeNumPeaks )
+            {
+                case 4:  handOver(peakChain4, hqPeakChain4); break;
+                case 8:  handOver(peakChain8, hqPeakChain8); break;
+                default: handOver(peakChain2, hqPeakChain2); break;
+            }
+        }
+    }
+    
+    renderQuality = quality;
+    SDF_TRACE_INSTANT("renderQualityChanged");
+    
+    // Continue at the new control interval straight away
+    chainControl.triggerControlTick();
+}
+
+int SimpleDualFilterAudioProcessor::getEffectiveControlInterval() const
+{
+    switch( renderQuality.load() )
+    {
+        case RenderQuality::high:  return 1;
+        case RenderQuality::light: return lightControlInterval.load();
+        case RenderQuality::standard:
+        default:                   return controlInterval.load();
+    }
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SimpleDualFilterAudioProcessor::createParameterLayout()
@@ -315,6 +1175,33 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleDualFilterAudioProcess
     layout.add(std::make_unique<juce::AudioParameterFloat>("Output Gain",
                                                          "Output Gain",
                                                          juce::NormalisableRange<float>(-60.f, 0.f, 0.1f, 0.25f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Bands",
+                                                          "Bands",
+                                                          juce::StringArray { "2", "4", "8" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Peak Design",
+                                                          "Peak Design",
+                                                          juce::StringArray { "Bilinear", "Matched" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Morph",
+                                                         "Morph",
+                                                         juce::NormalisableRange<float>(0.f, 4.f, 0.01f, 1.f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Saturation",
+                                                          "Saturation",
+                                                          juce::StringArray { "Off", "On" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Drive",
+                                                         "Drive",
+                                                         juce::NormalisableRange<float>(0.f, 24.f, 0.1f, 1.f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("A/B Morph",
+                                                         "A/B Morph",
+                                                         juce::NormalisableRange<float>(0.f, 1.f, 0.001f, 1.f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Auto Gain",
+                                                          "Auto Gain",
+                                                          juce::StringArray { "Off", "On" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Key Track",
+                                                          "Key Track",
+                                                          juce::StringArray { "Off", "On" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Pitch Track",
+                                                          "Pitch Track",
+                                                          juce::StringArray { "Off", "Input", "Sidechain" }, 0));
 
     return layout;
 }
@@ -10,39 +10,73 @@
 
 #include <JuceHeader.h>
 
-struct ChainSettings
-{
-    float peak1Freq { 0 }, peak1GainInDecibels { 0 }, peak1Quality { 1.f },
-    peak2Freq { 0 }, peak2GainInDecibels { 0 }, peak2Quality { 1.f },
-    span { 0 }, balance { 0 }, outputGain { 0.f };
-    
-};
+#include "PeakChain.h"
+#include "ParallelPeakChain.h"
+#include "MorphChain.h"
+#include "Saturator.h"
+#include "AutoGain.h"
+#include "ChainControl.h"
+#include "VoiceBank.h"
+#include "PitchTracker.h"
+#include "SnapshotMorph.h"
+#include "LinkGroup.h"
+#include "LevelMeter.h"
+#include "FilterResponse.h"
+#include "StateData.h"
+#include "Trace.h"
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
 using Filter = juce::dsp::IIR::Filter<float>;
 
-using Gain = juce::dsp::Gain<float>;
+using Coefficients = Filter::CoefficientsPtr;
 
-using MonoChain = juce::dsp::ProcessorChain<Filter, Filter, Gain>;
+Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+Coefficients makePeakFilter2(const ChainSettings& chainSettings, double sampleRate);
 
-enum ChainPositions
+// Looks the raw parameter values up once, so reading the settings on the
+// audio thread doesn't search the parameter IDs every block
+struct ChainParameters
 {
-    Peak1,
-    Peak2,
-    outputGain
+    explicit ChainParameters(juce::AudioProcessorValueTreeState& apvts);
+    
+    ChainSettings load() const;
+    
+private:
+    // In the order of chainParameterTable
+    std::atomic<float>* values[numChainParameters];
 };
 
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacemets);
+// How processBlock splits the host's blocks
+enum class InternalBlockMode
+{
+    off,            // Parameters are read at the start of every host block
+    zeroLatency,    // Parameters are read once per internal block, audio is processed in place
+    buffered        // Audio is processed in whole internal blocks, adding one block of latency
+};
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
-Coefficients makePeakFilter2(const ChainSettings& chainSettings, double sampleRate);
+// Chosen at every host block, see SimpleDualFilterAudioProcessor::updateRenderQuality().
+// None of the profiles adds latency, so switching never changes the reported latency.
+enum class RenderQuality
+{
+    light,          // Real time under high load: coefficients are designed less often
+    standard,       // Real time: single precision, designs every control interval
+    high            // Offline bounce: double precision, sample-accurate designs
+};
+
+// Form of the single precision peak chains. The high quality profile always
+// runs the serial double precision chains.
+enum class PeakEngine
+{
+    serial,         // Cascade of biquads
+    parallel        // Sum of second-order sections while the design holds still, see ParallelPeakChain.h
+};
 
 //==============================================================================
 /**
 */
-class SimpleDualFilterAudioProcessor  : public juce::AudioProcessor
+class SimpleDualFilterAudioProcessor  : public juce::AudioProcessor,
+                                         public juce::ChangeBroadcaster
 {
 public:
     //==============================================================================
@@ -82,13 +116,309 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    // Test mode: forces a kernel variant from the next prepareToPlay on,
+    // instead of the best one the CPU supports
+    void forcePeakKernel(PeakKernel kernel);
+    void clearForcedPeakKernel();
+    PeakKernel getPeakKernel() const { return peakKernel; }
+    
+    // Transfer function for numPoints frequencies in Hz, for the current parameter values
+    // or the given settings. Magnitudes are linear, phases in radians and group delays in
+    // seconds, any output may be null. Safe to call from any thread.
+    void getFrequencyResponse(const double* frequencies, int numPoints,
+                              double* magnitudes, double* phases, double* groupDelays) const;
+    void getFrequencyResponse(const ChainSettings& chainSettings, const double* frequencies, int numPoints,
+                              double* magnitudes, double* phases, double* groupDelays) const;
+    
+    // Levels before and after the filter, safe to read from the editor
+    const LevelMeter& getInputMeter() const { return inputMeter; }
+    const LevelMeter& getOutputMeter() const { return outputMeter; }
+    
+    // The pitch FREQ follows with Pitch Track on and the analysis cost, safe to read from the editor
+    const PitchTracker& getPitchTracker() const { return pitchTracker; }
+    
+    // Joins the named in-process link group, an empty name leaves it.
+    // Safe to call from any thread but the audio thread.
+    void setLinkGroup(const juce::String& name);
+    juce::String getLinkGroupName() const;
+    bool isLinkLeader() const;
+    
+    // A/B snapshots of all parameter values, saved with the plugin state.
+    // Recalling one leaves A/B MORPH where it is. A change message goes
+    // out after setStateInformation so an open editor can catch up.
+    void storeSnapshot(int slot);
+    void recallSnapshot(int slot);
+    void toggleSnapshot();
+    int getActiveSnapshot() const;
+    
+    // The current parameter values with A/B MORPH applied, for the response curve.
+    // Call on the message thread.
+    ChainSettings getMorphedChainSettings() const;
+    
+    // Lets tiny or variable host blocks share the per-block work.
+    // Takes effect at the next prepareToPlay.
+    static constexpr int minInternalBlockSize = 32;
+    static constexpr int maxInternalBlockSize = 2048;
+    
+    void setInternalBlockMode(InternalBlockMode mode, int blockSize = 256);
+    InternalBlockMode getInternalBlockMode() const { return blockMode; }
+    
+    // Takes effect at the next prepareToPlay
+    void setPeakEngine(PeakEngine engine) { requestedPeakEngine = engine; }
+    PeakEngine getPeakEngine() const { return peakEngine; }
+    
+    // Number of samples between two coefficient designs while parameters move.
+    // The coefficients are ramped linearly in between.
+    static constexpr int minControlInterval = 16;
+    static constexpr int maxControlInterval = 64;
+    
+    void setControlInterval(int numSamples);
+    int getControlInterval() const { return controlInterval.load(); }
+    
+    // Above loadThreshold (the measured processing time as a proportion of the block
+    // duration) real-time processing drops to the light profile, which designs new
+    // coefficients every lightControlInterval samples. A threshold of 0 disables it.
+    void setLightProfile(float loadThreshold, int lightControlInterval);
+    RenderQuality getRenderQuality() const { return renderQuality.load(); }
+    
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{*this, nullptr, "Parameters", createParameterLayout()};
 
 private:
-    MonoChain leftChain, rightChain;
+    // One stereo chain per selectable band count, only the active one is processed
+    PeakChain<2> peakChain2;
+    PeakChain<4> peakChain4;
+    PeakChain<8> peakChain8;
+    
+    // The same in parallel form, used instead with PeakEngine::parallel
+    ParallelPeakChain<2> parallelPeakChain2;
+    ParallelPeakChain<4> parallelPeakChain4;
+    ParallelPeakChain<8> parallelPeakChain8;
+    
+    // Double precision chains for the high quality profile
+    PeakChain<2, double> hqPeakChain2;
+    PeakChain<4, double> hqPeakChain4;
+    PeakChain<8, double> hqPeakChain8;
+    
+    // State-variable chains, used instead of the peaks while MORPH is above 0
+    MorphChain<2> morphChain2;
+    MorphChain<4> morphChain4;
+    MorphChain<8> morphChain8;
+    
+    MorphChain<2, double> hqMorphChain2;
+    MorphChain<4, double> hqMorphChain4;
+    MorphChain<8, double> hqMorphChain8;
+    
+    // Runs on each chunk right after the chain while Saturation is on
+    Saturator<float> saturator;
+    Saturator<double> hqSaturator;
+    
+    // Key Track mode: the held MIDI notes' voices, processed instead of the chains
+    VoiceBank<float> voiceBank;
+    VoiceBank<double> hqVoiceBank;
+    VoicePool voicePool;
+    bool keyTrackActive { false };
+    
+    // Pitch Track: listens to the input or the sidechain ahead of the filter
+    PitchTracker pitchTracker;
+    PitchTrackSource pitchTrackSource { PitchTrackSource::off };
+    
+    void pushToPitchTracker(juce::AudioBuffer<float>& buffer, int numChannels);
+    
+    // With Pitch Track on and a pitch found, FREQ is the pitch
+    ChainSettings withTrackedFrequency(ChainSettings chainSettings) const;
+    
+    static constexpr int hqBlockSize = 256;
+    double hqSamples[PeakChain<2>::maxChannels][hqBlockSize] {};
+    
+    int activeNumPeaks { 2 };
+    bool morphActive { false };
+    
+    PeakKernel peakKernel { PeakKernel::generic };
+    std::optional<PeakKernel> forcedPeakKernel;
+    
+    ChainParameters chainParameters { apvts };
+    
+    // Smoothing, control ticks and gains, shared with the library's engine
+    ChainControl chainControl;
+    
+    InternalBlockMode requestedBlockMode { InternalBlockMode::off }, blockMode { InternalBlockMode::off };
+    int requestedBlockSize { 256 }, internalBlockSize { 256 };
+    
+    PeakEngine requestedPeakEngine { PeakEngine::serial }, peakEngine { PeakEngine::serial };
+    
+    // Counts on across host blocks like the control ticks, so short host blocks don't add designs
+    int samplesUntilParameterUpdate { 0 };
+    
+    juce::AudioBuffer<float> fifoBuffer;
+    int fifoPosition { 0 };
+    
+    LevelMeter inputMeter, outputMeter;
+    
+    std::atomic<LinkGroup*> linkGroup { nullptr };
+    juce::CriticalSection linkGroupLock;        // Serialises setLinkGroup() between the editor and state restores
+    
+    // Audio thread only
+    LinkGroup* followedGroup { nullptr };
+    juce::uint32 lastLinkSequence { 0 };
+    
+    bool isFollowingLinkGroup() const;
+    void followLinkGroup(LinkGroup& group, int numSamples);
+    template <typename SectionCoefficients>
+    void publishToLinkGroup(const ChainSettings& chainSettings, const SectionCoefficients* coefficients, int numPeaks, float gain);
+    
+    void updateTargets();
+    void processChain(float* const* channels, int numChannels, int numSamples);
+    void processWithMidi(float* const* channels, int numChannels, int numSamples, const juce::MidiBuffer& midiMessages);
+    void handleMidiMessage(const juce::MidiMessage& message);
+    void processBuffered(juce::AudioBuffer<float>& buffer, int numChannels);
+    
+    std::atomic<int> controlInterval { 32 };
+    
+    // Set by setStateInformation(), processBlock() redesigns the chains from the restored values
+    std::atomic<bool> stateRestorePending { false };
+    
+    std::atomic<RenderQuality> renderQuality { RenderQuality::standard };
+    std::atomic<float> lightLoadThreshold { 0.75f };
+    std::atomic<int> lightControlInterval { maxControlInterval };
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    
+    RenderQuality selectRenderQuality() const;
+    void updateRenderQuality();
+    int getEffectiveControlInterval() const;
+    
+    juce::Array<juce::RangedAudioParameter*> stateParameters;
+    
+    juce::CriticalSection snapshotLock;
+    float snapshots[StateData::numSnapshots][StateData::maxParameters] {};
+    juce::uint32 snapshotMask { 0 };
+    int activeSnapshot { 0 };
+    
+    // Interpolates between the snapshots while A/B MORPH is above 0
+    SnapshotMorph snapshotMorph;
+    
+    // Hands both snapshots to snapshotMorph, or clears them there while one is empty
+    void updateSnapshotMorph();
+    
+    void readParameterValues(float* values) const;
+    void writeParameterValues(const float* values, int numValues);
+    
+    // Calls back with the chain for the band count in the current render quality's precision
+    // and, for the peaks in single precision, the peak engine's form
+    template <typename Callback>
+    void withPeakChain(int numPeaks, Callback&& callback)
+    {
+        auto highQuality = renderQuality.load(std::memory_order_relaxed) == RenderQuality::high;
+        
+        if( morphActive )
+        {
+            if( highQuality )
+            {
+                switch( numPeaks )
+                {
+                    case 4:  callback(hqMorphChain4); break;
+                    case 8:  callback(hqMorphChain8); break;
+                    default: callback(hqMorphChain2); break;
+                }
+            }
+            else
+            {
+                switch( numPeaks )
+                {
+                    case 4:  callback(morphChain4); break;
+                    case 8:  callback(morphChain8); break;
+                    default: callback(morphChain2); break;
+                }
+            }
+        }
+        else if( highQuality )
+        {
+            switch( numPeaks )
+            {
+                case 4:  callback(hqPeakChain4); break;
+                case 8:  callback(hqPeakChain8); break;
+                default: callback(hqPeakChain2); break;
+            }
+        }
+        else if( peakEngine == PeakEngine::parallel )
+        {
+            switch( numPeaks )
+            {
+                case 4:  callback(parallelPeakChain4); break;
+                case 8:  callback(parallelPeakChain8); break;
+                default: callback(parallelPeakChain2); break;
+            }
+        }
+        else
+        {
+            switch( numPeaks )
+            {
+                case 4:  callback(peakChain4); break;
+                case 8:  callback(peakChain8); break;
+                default: callback(peakChain2); break;
+            }
+        }
+    }
+    
+    template <template <int, typename> class Chain, int NumPeaks>
+    void processPeakChain(Chain<NumPeaks, float>& chain, float* const* channels, int numChannels, int numSamples)
+    {
+        chain.process(channels, numChannels, numSamples);
+        
+        if( chainControl.isSaturatorActive() )
+            saturator.process(channels, numChannels, numSamples);
+    }
+    
+    template <template <int, typename> class Chain, int NumPeaks>
+    void processPeakChain(Chain<NumPeaks, double>& chain, float* const* channels, int numChannels, int numSamples)
+    {
+        processConverted(channels, numChannels, numSamples, [&chain, this](double* const* hqChannels, int numHqChannels, int numHqSamples)
+        {
+            chain.process(hqChannels, numHqChannels, numHqSamples);
+            
+            if( chainControl.isSaturatorActive() )
+                hqSaturator.process(hqChannels, numHqChannels, numHqSamples);
+        });
+    }
+    
+    // The double precision filters run on a converted copy of the samples, hqBlockSize at a time
+    template <typename Process>
+    void processConverted(float* const* channels, int numChannels, int numSamples, Process&& process)
+    {
+        double* hqChannels[PeakChain<2>::maxChannels] { hqSamples[0], hqSamples[1] };
+        
+        for( int start = 0; start < numSamples; start += hqBlockSize )
+        {
+            auto numChunkSamples = juce::jmin(numSamples - start, hqBlockSize);
+            
+            for( int ch = 0; ch < numChannels; ++ch )
+                for( int i = 0; i < numChunkSamples; ++i )
+                    hqChannels[ch][i] = double(channels[ch][start + i]);
+            
+            process(hqChannels, numChannels, numChunkSamples);
+            
+            for( int ch = 0; ch < numChannels; ++ch )
+                for( int i = 0; i < numChunkSamples; ++i )
+                    channels[ch][start + i] = float(hqChannels[ch][i]);
+        }
+    }
+    
+    void processVoiceBank(float* const* channels, int numChannels, int numSamples);
     
     void updatePeakFilter(const ChainSettings& chainSettings);
+    void rampPeakFilter(const ChainSettings& chainSettings, int numSamples);
+    
+    // Hands the running filter over between the peak and the morph chain of the active band count
+    void selectMorphCore(bool shouldMorph);
+    
+    // Switches between the chains and the voices, whichever takes over starts from silence
+    void selectKeyTrack(bool shouldTrack);
+    
+    // Designs the voices for the held notes and ramps the voice bank to them over numSamples, 0 jumps
+    void updateVoiceBank(const ChainSettings& chainSettings, int numSamples);
+    
+    // Switches the saturators on or off and jumps their gain to the settings, or ramps it over numSamples
+    void updateSaturator(const ChainSettings& chainSettings, int numSamples = 0);
     
     void updateFilters();
     void updateGain();
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    ResponseRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseRenderer.h"
+#include "Trace.h"
+
+ResponseRenderer::ResponseRenderer()
+{
+    renderThread->addTimeSliceClient(this);
+}
+
+ResponseRenderer::~ResponseRenderer()
+{
+    // Waits for a frame that is being drawn right now
+    renderThread->removeTimeSliceClient(this);
+}
+
+void ResponseRenderer::render(const ResponseFrame& frame)
+{
+    {
+        const juce::SpinLock::ScopedLockType sl(requestLock);
+        request = frame;
+        requestPending = true;
+    }
+
+    renderThread->moveToFrontOfQueue(this);
+}
+
+void ResponseRenderer::drawLatestFrame(juce::Graphics& g, juce::Rectangle<float> area)
+{
+    const juce::SpinLock::ScopedLockType sl(frameLock);
+
+    if( frontImage >= 0 )
+        g.drawImage(images[(size_t) frontImage], area);
+}
+
+void ResponseRenderer::releaseFrames()
+{
+    const juce::SpinLock::ScopedLockType sl(frameLock);
+
+    images = {};
+    frontImage = -1;
+}
+
+int ResponseRenderer::useTimeSlice()
+{
+    ResponseFrame frame;
+
+    {
+        const juce::SpinLock::ScopedLockType sl(requestLock);
+
+        if( ! requestPending )
+            return 500;
+
+        frame = request;
+        requestPending = false;
+    }
+
+    SDF_TRACE_SCOPE("ResponseRenderer::render");
+
+    juce::Image target;
+    int backImage;
+
+    {
+        const juce::SpinLock::ScopedLockType sl(frameLock);
+        backImage = frontImage == 0 ? 1 : 0;
+        target = images[(size_t) backImage];
+    }
+
+    // Software images can be drawn into from any thread
+    if( target.isNull() || target.getBounds() != frame.bounds.withZeroOrigin() )
+        target = juce::Image(juce::Image::ARGB, juce::jmax(1, frame.bounds.getWidth()), juce::jmax(1, frame.bounds.getHeight()),
+                             true, juce::SoftwareImageType());
+    else
+        target.clear(target.getBounds());
+
+    renderFrame(frame, target);
+
+    {
+        const juce::SpinLock::ScopedLockType sl(frameLock);
+        images[(size_t) backImage] = target;
+        frontImage = backImage;
+    }
+
+    newFrame = true;
+
+    // Check straight away whether another frame was queued meanwhile
+    return 0;
+}
+
+void ResponseRenderer::renderFrame(const ResponseFrame& frame, juce::Image& image)
+{
+    using namespace juce;
+
+    Graphics g(image);
+
+    auto responseArea = frame.responseArea;
+    auto w = responseArea.getWidth();
+
+    if( w <= 0 )
+        return;
+
+    // Draw responsegrid outline
+    g.setColour(frame.outlineColour);
+    g.drawRoundedRectangle(frame.outlineArea.toFloat(), 1.f * frame.scaleFactor, 3.f * frame.scaleFactor);
+
+    if( frame.numPeaks <= 0 )
+        return;
+
+    std::vector<double> freqs((size_t) w), mags((size_t) w);
+
+    for( int i = 0; i < w; ++i )
+        freqs[(size_t) i] = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+
+    computeCascadeResponse(frame.coefficients.data(), frame.numPeaks, 1.0, frame.sampleRate,
+                           freqs.data(), w, mags.data(), nullptr, nullptr);
+
+    for( auto& mag : mags )
+        mag = Decibels::gainToDecibels(mag);
+
+    // Response Curve
+    Path responseCurve;
+
+    const double outputMin = responseArea.getBottom();
+    const double outputMax = responseArea.getY();
+    auto map = [outputMin, outputMax](double input)
+    {
+        return jmap(input, -24.0, 24.0, outputMin, outputMax);
+    };
+
+    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+
+    for( size_t i = 1; i < mags.size(); ++i )
+    {
+        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+    }
+
+    // Draw responsecurve
+    g.setColour(frame.curveColour);
+    g.strokePath(responseCurve, PathStrokeType(2.f * frame.scaleFactor));
+}
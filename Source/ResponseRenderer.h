@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    ResponseRenderer.h
+
+    Renders the response curve on a background thread. Each frame is drawn
+    into the back one of two images and then swapped to the front, so the
+    message thread only blits the latest finished frame. All renderers in the
+    process share one worker thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "FilterResponse.h"
+
+// Everything the worker needs to draw one frame, copied at submission
+struct ResponseFrame
+{
+    std::array<BiquadCoefficients<double>, maxNumPeaks> coefficients;
+    int numPeaks { 0 };                         // 0 draws the grid outline without a curve
+    double sampleRate { 44100.0 };
+
+    juce::Rectangle<int> bounds, responseArea, outlineArea;
+    float scaleFactor { 1.f };
+
+    juce::Colour curveColour, outlineColour;
+};
+
+struct ResponseRenderThread : juce::TimeSliceThread
+{
+    ResponseRenderThread() : juce::TimeSliceThread("Response Renderer") { startThread(); }
+    ~ResponseRenderThread() override { stopThread(1000); }
+};
+
+class ResponseRenderer : private juce::TimeSliceClient
+{
+public:
+    ResponseRenderer();
+    ~ResponseRenderer() override;
+
+    // Message thread: queues a frame, replacing one that has not been started yet
+    void render(const ResponseFrame& frame);
+
+    // Message thread: true once for every frame finished since the last call
+    bool hasNewFrame() noexcept { return newFrame.exchange(false); }
+
+    // Message thread: draws the latest finished frame, if any, stretched to the area
+    void drawLatestFrame(juce::Graphics& g, juce::Rectangle<float> area);
+
+    // Message thread: frees both images, e.g. while the display is hidden
+    void releaseFrames();
+
+private:
+    int useTimeSlice() override;
+
+    static void renderFrame(const ResponseFrame& frame, juce::Image& image);
+
+    juce::SharedResourcePointer<ResponseRenderThread> renderThread;
+
+    juce::SpinLock requestLock;
+    ResponseFrame request;
+    bool requestPending { false };
+
+    // frontImage is the finished frame, the worker draws into the other one
+    juce::SpinLock frameLock;
+    std::array<juce::Image, 2> images;
+    int frontImage { -1 };
+
+    std::atomic<bool> newFrame { false };
+
+    JUCE_DECLARE_NON_COPYABLE (ResponseRenderer)
+};
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    Saturator.h
+
+    Soft clipper after the peaks, with first-order antiderivative anti-aliasing
+    (ADAA) instead of oversampling. The curve is the algebraic sigmoid
+
+        f(x) = x / sqrt(1 + x^2),    F(x) = sqrt(1 + x^2)
+
+    and the ADAA output (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1]) simplifies to
+
+        y[n] = (x[n] + x[n-1]) / (r[n] + r[n-1]),    r = sqrt(1 + x^2)
+
+    which has no division by x[n] - x[n-1]. There is no ill-conditioned case
+    to branch around, so the loop vectorises along time: one square root per
+    sample and one division per output. (GCC only vectorises the square root
+    with -fno-math-errno, which Apple clang and MSVC imply.)
+
+    ADAA averages neighbouring samples, which delays the signal by half a
+    sample and rolls the top octave off like (1 + z^-1) / 2, about -2 dB at
+    10 kHz for 48 kHz. The stage only runs while Saturation is on.
+
+    DRIVE is folded into the chain's output gain and the output gain is
+    applied here after the curve, so the curve's ceiling sits at OUT G.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PeakChain.h"
+
+// The gain the peak chain applies after its last band, in decibels
+inline float getChainGainInDecibels(const ChainSettings& chainSettings) noexcept
+{
+    return chainSettings.saturate ? chainSettings.drive : chainSettings.outputGain;
+}
+
+// The gain after the curve, in decibels
+inline float getSaturatorGainInDecibels(const ChainSettings& chainSettings) noexcept
+{
+    return chainSettings.outputGain;
+}
+
+//==============================================================================
+template <typename SampleType = float>
+class Saturator
+{
+public:
+    static constexpr int maxChannels = 2;
+
+    // Samples per pass, the two passes over a block stay in L1
+    static constexpr int blockSize = 64;
+
+    void reset() noexcept
+    {
+        previousInput = {};
+        previousRoot.fill(SampleType(1));
+    }
+
+    void setGainLinear(SampleType newGain) noexcept
+    {
+        gain = targetGain = newGain;
+        rampSamplesRemaining = 0;
+    }
+
+    SampleType getGainLinear() const noexcept { return gain; }
+
+    // Ramps the gain after the curve like PeakChain::setTarget
+    void setTarget(SampleType newTargetGain, int rampLength) noexcept
+    {
+        targetGain = newTargetGain;
+
+        if( rampLength <= 0 )
+        {
+            gain = targetGain;
+            rampSamplesRemaining = 0;
+            return;
+        }
+
+        gainIncrement = (targetGain - gain) / SampleType(rampLength);
+        rampSamplesRemaining = rampLength;
+    }
+
+    // Continues from a saturator with another precision
+    template <typename OtherSampleType>
+    void copyStateFrom(const Saturator<OtherSampleType>& other) noexcept
+    {
+        for( int ch = 0; ch < maxChannels; ++ch )
+        {
+            previousInput[ch] = SampleType(other.previousInput[ch]);
+            previousRoot[ch] = SampleType(other.previousRoot[ch]);
+        }
+
+        gain = SampleType(other.gain);
+        targetGain = SampleType(other.targetGain);
+        gainIncrement = SampleType(other.gainIncrement);
+        rampSamplesRemaining = other.rampSamplesRemaining;
+    }
+
+    // Kernel variant used by process(), see PeakKernels.cpp
+    using ProcessFunction = void (*)(Saturator&, SampleType* const*, int, int) noexcept;
+
+    void setProcessFunction(ProcessFunction newFunction) noexcept { processFunction = newFunction; }
+
+    static void processGeneric(Saturator& saturator, SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        saturator.processInline(channels, numChannels, numSamples);
+    }
+
+    // Processes up to two channels in place, gain after the curve included
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        processFunction(*this, channels, numChannels, numSamples);
+    }
+
+    PEAK_CHAIN_FORCEINLINE void processInline(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        numChannels = std::min(numChannels, maxChannels);
+
+        alignas(64) SampleType gains[blockSize];
+
+        for( int start = 0; start < numSamples; start += blockSize )
+        {
+            auto numBlockSamples = std::min(numSamples - start, blockSize);
+
+            // The gain ramp once per block, shared by the channels
+            auto numRampSamples = std::min(numBlockSamples, rampSamplesRemaining);
+
+            for( int i = 0; i < numRampSamples; ++i )
+                gains[i] = gain + gainIncrement * SampleType(i + 1);
+
+            if( numRampSamples > 0 )
+            {
+                rampSamplesRemaining -= numRampSamples;
+                gain = rampSamplesRemaining == 0 ? targetGain : gains[numRampSamples - 1];
+            }
+
+            for( int i = numRampSamples; i < numBlockSamples; ++i )
+                gains[i] = gain;
+
+            for( int ch = 0; ch < numChannels; ++ch )
+                processBlock(channels[ch] + start, gains, numBlockSamples, previousInput[ch], previousRoot[ch]);
+        }
+    }
+
+private:
+    template <typename> friend class Saturator;
+
+    static PEAK_CHAIN_FORCEINLINE void processBlock(SampleType* samples, const SampleType* gains, int numSamples,
+                                                    SampleType& x1, SampleType& r1) noexcept
+    {
+        // Index 0 holds the last sample of the previous block
+        alignas(64) SampleType x[blockSize + 1], r[blockSize + 1];
+
+        x[0] = x1;
+        r[0] = r1;
+
+        for( int i = 0; i < numSamples; ++i )
+        {
+            x[i + 1] = samples[i];
+            r[i + 1] = std::sqrt(SampleType(1) + samples[i] * samples[i]);
+        }
+
+        for( int i = 0; i < numSamples; ++i )
+            samples[i] = gains[i] * (x[i + 1] + x[i]) / (r[i + 1] + r[i]);
+
+        x1 = x[numSamples];
+        r1 = r[numSamples];
+    }
+
+    std::array<SampleType, maxChannels> previousInput {}, previousRoot { SampleType(1), SampleType(1) };
+    SampleType gain { 1 }, targetGain { 1 }, gainIncrement { 0 };
+    int rampSamplesRemaining { 0 };
+
+    ProcessFunction processFunction { &Saturator::processGeneric };
+};
+
+//==============================================================================
+// Instruction set variants of the saturator kernel, defined in PeakKernels.cpp
+template <typename SampleType>
+typename Saturator<SampleType>::ProcessFunction getSaturatorKernelFunction(PeakKernel kernel);
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    SnapshotMorph.cpp
+
+  ==============================================================================
+*/
+
+#include "SnapshotMorph.h"
+#include "Trace.h"
+
+ChainSettings interpolateSnapshots(const SnapshotValues& a, const SnapshotValues& b, float position, ChainSettings chainSettings) noexcept
+{
+    auto t = juce::jlimit(0.f, 1.f, position);
+
+    auto geometric = [t](float from, float to)
+    {
+        return from * std::pow(to / from, t);
+    };
+
+    auto linear = [t](float from, float to)
+    {
+        return from + (to - from) * t;
+    };
+
+    chainSettings.peak1Freq = geometric(a.peak1Freq, b.peak1Freq);
+    chainSettings.peak1Quality = geometric(a.peak1Quality, b.peak1Quality);
+    chainSettings.peak1GainInDecibels = linear(a.peak1GainInDecibels, b.peak1GainInDecibels);
+    chainSettings.span = linear(a.span, b.span);
+    chainSettings.balance = linear(a.balance, b.balance);
+    chainSettings.snapshotMorph = 0.f;
+
+    return chainSettings;
+}
+
+void SnapshotMorphTable::build(const SnapshotValues& newA, const SnapshotValues& newB, const ChainSettings& chainSettings, double rate)
+{
+    a = newA;
+    b = newB;
+    numPeaks = chainSettings.numPeaks;
+    design = chainSettings.design;
+    morph = chainSettings.morph;
+    sampleRate = rate;
+
+    coefficients.resize((size_t) numPositions * (size_t) numPeaks);
+
+    for( int row = 0; row < numPositions; ++row )
+    {
+        auto settings = interpolateSnapshots(a, b, float(row) / float(numPositions - 1), chainSettings);
+
+        for( int band = 0; band < numPeaks; ++band )
+            coefficients[(size_t) (row * numPeaks + band)] = makeBandCoefficients<double>(settings, band, numPeaks, sampleRate);
+    }
+}
+
+//==============================================================================
+SnapshotMorph::SnapshotMorph()
+{
+    morphThread->addTimeSliceClient(this);
+}
+
+SnapshotMorph::~SnapshotMorph()
+{
+    // Waits for a table that is being built right now
+    morphThread->removeTimeSliceClient(this);
+}
+
+void SnapshotMorph::setSnapshots(const float* valuesA, const float* valuesB)
+{
+    {
+        const juce::SpinLock::ScopedLockType sl(snapshotLock);
+        snapshotA = SnapshotValues::fromStateValues(valuesA);
+        snapshotB = SnapshotValues::fromStateValues(valuesB);
+        hasSnapshots = true;
+        ++snapshotVersion;
+    }
+
+    morphThread->moveToFrontOfQueue(this);
+}
+
+void SnapshotMorph::clearSnapshots()
+{
+    {
+        const juce::SpinLock::ScopedLockType sl(snapshotLock);
+
+        if( ! hasSnapshots )
+            return;
+
+        hasSnapshots = false;
+        ++snapshotVersion;
+    }
+
+    morphThread->moveToFrontOfQueue(this);
+}
+
+ChainSettings SnapshotMorph::getMorphedSettings(const ChainSettings& chainSettings) const
+{
+    const juce::SpinLock::ScopedLockType sl(snapshotLock);
+
+    if( ! hasSnapshots || chainSettings.snapshotMorph <= 0.f )
+        return chainSettings;
+
+    return interpolateSnapshots(snapshotA, snapshotB, chainSettings.snapshotMorph, chainSettings);
+}
+
+bool SnapshotMorph::update(const ChainSettings& chainSettings, double sampleRate) noexcept
+{
+    wantedNumPeaks.store(chainSettings.numPeaks, std::memory_order_relaxed);
+    wantedDesign.store((int) chainSettings.design, std::memory_order_relaxed);
+    wantedMorph.store(chainSettings.morph, std::memory_order_relaxed);
+    wantedSampleRate.store(sampleRate, std::memory_order_relaxed);
+
+    if( (middle.load(std::memory_order_relaxed) & newTableFlag) == 0 )
+        return false;
+
+    front = middle.exchange(front, std::memory_order_acq_rel) & ~newTableFlag;
+    return true;
+}
+
+ChainSettings SnapshotMorph::apply(const ChainSettings& chainSettings) const noexcept
+{
+    if( ! isEngaged(chainSettings) )
+        return chainSettings;
+
+    auto& table = tables[(size_t) front];
+    return interpolateSnapshots(table.a, table.b, chainSettings.snapshotMorph, chainSettings);
+}
+
+const SnapshotMorphTable* SnapshotMorph::getTable(const ChainSettings& chainSettings, double sampleRate) const noexcept
+{
+    auto& table = tables[(size_t) front];
+    return table.fits(chainSettings, sampleRate) ? &table : nullptr;
+}
+
+int SnapshotMorph::useTimeSlice()
+{
+    SnapshotValues a, b;
+    bool snapshotsStored;
+    juce::uint32 version;
+
+    {
+        const juce::SpinLock::ScopedLockType sl(snapshotLock);
+        a = snapshotA;
+        b = snapshotB;
+        snapshotsStored = hasSnapshots;
+        version = snapshotVersion;
+    }
+
+    ChainSettings settings;
+    settings.numPeaks = wantedNumPeaks.load(std::memory_order_relaxed);
+    settings.design = (PeakDesign) wantedDesign.load(std::memory_order_relaxed);
+    settings.morph = wantedMorph.load(std::memory_order_relaxed);
+    auto sampleRate = wantedSampleRate.load(std::memory_order_relaxed);
+
+    // Nothing to do before the audio thread has run, and no table at all without both snapshots
+    auto upToDate = version == builtVersion
+                 && (! snapshotsStored
+                     || sampleRate <= 0
+                     || (settings.numPeaks == builtSettings.numPeaks && settings.design == builtSettings.design
+                         && settings.morph == builtSettings.morph && sampleRate == builtSampleRate));
+
+    // The audio thread reports its settings with every parameter update, so
+    // polling catches the changes that need a new table
+    if( upToDate )
+        return snapshotsStored ? 20 : 500;
+
+    auto& table = tables[(size_t) back];
+
+    if( snapshotsStored && sampleRate > 0 )
+    {
+        SDF_TRACE_SCOPE("SnapshotMorph::build");
+        table.build(a, b, settings, sampleRate);
+    }
+    else
+    {
+        table.numPeaks = 0;
+    }
+
+    back = middle.exchange(back | newTableFlag, std::memory_order_acq_rel) & ~newTableFlag;
+
+    builtVersion = version;
+    builtSettings = settings;
+    builtSampleRate = sampleRate;
+
+    return 20;
+}
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    SnapshotMorph.h
+
+    A/B MORPH moves FREQ, GAIN, QUAL, SPAN and BAL from snapshot A to snapshot
+    B. Frequency and quality move geometrically and the decibel values
+    linearly, so equal steps of the parameter sound like equal steps. At 0 the
+    parameters apply as they are; the snapshots only take over above it.
+
+    The coefficients along the way are designed into a table of numPositions
+    points on a background thread, whenever a snapshot, BANDS, the design,
+    MORPH or the sample rate changes. The audio thread then only interpolates
+    between the two nearest points. The stable region of (a1, a2) is a
+    triangle, which is convex, so the interpolated sections stay stable. Until
+    the table fits the current settings the processor designs from the
+    interpolated settings as usual.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "MorphChain.h"
+
+// The morphed values of one snapshot, the first five values in StateData order
+struct SnapshotValues
+{
+    float peak1Freq { 20.f }, peak1GainInDecibels { 0 }, peak1Quality { 1.f }, span { 0 }, balance { 0 };
+
+    static SnapshotValues fromStateValues(const float* values) noexcept
+    {
+        return { values[0], values[1], values[2], values[3], values[4] };
+    }
+};
+
+// The settings with FREQ, GAIN, QUAL, SPAN and BAL at the position between a and b.
+// The result's snapshotMorph is 0, so it designs the same without the snapshots.
+ChainSettings interpolateSnapshots(const SnapshotValues& a, const SnapshotValues& b, float position, ChainSettings chainSettings) noexcept;
+
+//==============================================================================
+struct SnapshotMorphTable
+{
+    static constexpr int numPositions = 257;
+
+    SnapshotValues a, b;
+    int numPeaks { 0 };
+    PeakDesign design { PeakDesign::bilinear };
+    float morph { 0 };
+    double sampleRate { 0 };
+
+    // numPositions rows of numPeaks sections
+    std::vector<BiquadCoefficients<double>> coefficients;
+
+    bool isEmpty() const noexcept { return numPeaks == 0; }
+
+    // Whether the table was built for everything of the settings it doesn't interpolate
+    bool fits(const ChainSettings& chainSettings, double rate) const noexcept
+    {
+        return ! isEmpty() && numPeaks == chainSettings.numPeaks && design == chainSettings.design
+            && morph == chainSettings.morph && sampleRate == rate;
+    }
+
+    // Allocates, call on the background thread
+    void build(const SnapshotValues& newA, const SnapshotValues& newB, const ChainSettings& chainSettings, double rate);
+
+    // The sections at the position, interpolated between the two nearest rows
+    template <typename CoefficientArray>
+    void getCoefficients(float position, CoefficientArray& sections) const noexcept
+    {
+        using Coefficients = typename CoefficientArray::value_type;
+
+        jassert((int) sections.size() == numPeaks);
+
+        auto x = double(juce::jlimit(0.f, 1.f, position)) * (numPositions - 1);
+        auto row = juce::jmin((int) x, numPositions - 2);
+        auto fraction = x - row;
+
+        auto* lower = coefficients.data() + (size_t) row * (size_t) numPeaks;
+        auto* upper = lower + numPeaks;
+
+        for( int band = 0; band < numPeaks; ++band )
+            sections[(size_t) band] = Coefficients(lower[band] + (upper[band] - lower[band]) * fraction);
+    }
+};
+
+//==============================================================================
+struct SnapshotMorphThread : juce::TimeSliceThread
+{
+    SnapshotMorphThread() : juce::TimeSliceThread("Snapshot Morph") { startThread(); }
+    ~SnapshotMorphThread() override { stopThread(1000); }
+};
+
+// Builds the tables of one processor. All instances in the process share one worker thread.
+class SnapshotMorph : private juce::TimeSliceClient
+{
+public:
+    SnapshotMorph();
+    ~SnapshotMorph() override;
+
+    // Message thread: both snapshots in StateData order, or clearSnapshots() while one is empty
+    void setSnapshots(const float* valuesA, const float* valuesB);
+    void clearSnapshots();
+
+    // Message thread: the settings the table's position stands for, unchanged without both snapshots
+    ChainSettings getMorphedSettings(const ChainSettings& chainSettings) const;
+
+    // Audio thread: takes a newer table if there is one and returns true then.
+    // The settings and sample rate tell the worker what the next table must fit.
+    bool update(const ChainSettings& chainSettings, double sampleRate) noexcept;
+
+    // Audio thread: whether A/B MORPH is above 0 and a table holds both snapshots
+    bool isEngaged(const ChainSettings& chainSettings) const noexcept
+    {
+        return chainSettings.snapshotMorph > 0.f && ! tables[(size_t) front].isEmpty();
+    }
+
+    // Audio thread: the settings at the position between the current table's snapshots,
+    // unchanged unless engaged
+    ChainSettings apply(const ChainSettings& chainSettings) const noexcept;
+
+    // Audio thread: the current table if it fits the settings, otherwise null
+    const SnapshotMorphTable* getTable(const ChainSettings& chainSettings, double sampleRate) const noexcept;
+
+private:
+    int useTimeSlice() override;
+
+    juce::SharedResourcePointer<SnapshotMorphThread> morphThread;
+
+    mutable juce::SpinLock snapshotLock;
+    SnapshotValues snapshotA, snapshotB;
+    bool hasSnapshots { false };
+    juce::uint32 snapshotVersion { 0 };
+
+    // What the audio thread last asked for
+    std::atomic<int> wantedNumPeaks { 0 };
+    std::atomic<int> wantedDesign { 0 };
+    std::atomic<float> wantedMorph { 0 };
+    std::atomic<double> wantedSampleRate { 0 };
+
+    // Triple buffer: the audio thread owns front, the worker back, and they swap
+    // through middle, whose newTableFlag says the worker put a newer table there
+    static constexpr int newTableFlag = 4;
+
+    std::array<SnapshotMorphTable, 3> tables;
+    std::atomic<int> middle { 1 };
+    int front { 0 };
+    int back { 2 };
+
+    // Worker only: what the last published table was built for
+    juce::uint32 builtVersion { 0 };
+    ChainSettings builtSettings;
+    double builtSampleRate { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SnapshotMorph)
+};
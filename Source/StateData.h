@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    StateData.h
+
+    Fixed-layout binary plugin state, shared by the plugin and the library in
+    Library/, so either can load what the other saved.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+// Parameter values are stored in the order of createParameterLayout, so new
+// parameters must only ever be appended there.
+struct StateData
+{
+    static constexpr std::uint32_t magicNumber = 0x31464453; // "SDF1"
+    static constexpr std::uint32_t currentVersion = 2;
+    static constexpr int maxParameters = 32;
+    static constexpr int numSnapshots = 2;
+    
+    std::uint32_t magic { magicNumber };
+    std::uint32_t version { currentVersion };
+    std::uint32_t numParameters { 0 };
+    std::uint32_t snapshotMask { 0 };   // Bit n is set when snapshot n holds values
+    std::int32_t activeSnapshot { 0 };
+    
+    float values[maxParameters] {};
+    float snapshots[numSnapshots][maxParameters] {};
+    
+    // Version 2
+    char linkGroup[32] {};              // UTF-8, null terminated
+};
+
+static_assert(std::is_trivially_copyable<StateData>::value, "StateData is written with memcpy");
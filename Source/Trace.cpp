@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    Trace.cpp
+
+  ==============================================================================
+*/
+
+#include "Trace.h"
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 start, end;
+    };
+
+    // Written only by its own thread. The reader copies events while the thread
+    // goes on writing and drops those that may have been overwritten meanwhile.
+    struct ThreadRing
+    {
+        static constexpr juce::uint32 capacity = 1 << 14;
+
+        std::atomic<juce::uint32> numWritten { 0 };
+        Event events[capacity];
+
+        int threadId { 0 };
+        juce::String threadName;
+        ThreadRing* next { nullptr };
+    };
+
+    // Rings are pushed onto a lock-free list the first time a thread traces and
+    // live until the plugin is unloaded, so a reader never sees one go away
+    struct RingList
+    {
+        ~RingList()
+        {
+            for( auto* ring = head.load(); ring != nullptr; )
+                delete std::exchange(ring, ring->next);
+        }
+
+        std::atomic<ThreadRing*> head { nullptr };
+        std::atomic<int> nextThreadId { 1 };
+    };
+
+    RingList& getRings()
+    {
+        static RingList rings;
+        return rings;
+    }
+
+    juce::String getCurrentThreadName(int threadId)
+    {
+        if( juce::MessageManager::existsAndIsCurrentThread() )
+            return "Message Thread";
+
+        if( auto* thread = juce::Thread::getCurrentThread() )
+            return thread->getThreadName();
+
+        // Threads JUCE didn't start are the host's, usually its audio threads
+        return "Host Thread " + juce::String(threadId);
+    }
+
+    ThreadRing* createRing()
+    {
+        // Once per thread: the first trace point on an audio thread allocates
+        auto& rings = getRings();
+
+        auto* ring = new ThreadRing();
+        ring->threadId = rings.nextThreadId++;
+        ring->threadName = getCurrentThreadName(ring->threadId);
+
+        ring->next = rings.head.load();
+
+        while( ! rings.head.compare_exchange_weak(ring->next, ring) )
+            ;
+
+        return ring;
+    }
+}
+
+void Trace::writeEvent(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    thread_local ThreadRing* ring = createRing();
+
+    auto index = ring->numWritten.load(std::memory_order_relaxed);
+    ring->events[index & (ThreadRing::capacity - 1)] = { name, startTicks, endTicks };
+    ring->numWritten.store(index + 1, std::memory_order_release);
+}
+
+//==============================================================================
+void Trace::writeJson(juce::OutputStream& out)
+{
+    auto ticksToMicroseconds = 1.0e6 / double(juce::Time::getHighResolutionTicksPerSecond());
+    bool first = true;
+
+    auto beginEvent = [&]
+    {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::vector<Event> events(ThreadRing::capacity);
+
+    for( auto* ring = getRings().head.load(); ring != nullptr; ring = ring->next )
+    {
+        beginEvent();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId
+            << ",\"args\":{\"name\":" << juce::JSON::toString(ring->threadName) << "}}";
+
+        auto end = ring->numWritten.load(std::memory_order_acquire);
+        auto copyBegin = end > ThreadRing::capacity ? end - ThreadRing::capacity : 0u;
+
+        for( auto i = copyBegin; i != end; ++i )
+            events[i - copyBegin] = ring->events[i & (ThreadRing::capacity - 1)];
+
+        // Events the thread overwrote while they were copied are dropped, including
+        // the one in the slot it may have been writing to
+        auto endAfterCopy = ring->numWritten.load(std::memory_order_acquire);
+        auto begin = endAfterCopy - copyBegin >= ThreadRing::capacity ? endAfterCopy - ThreadRing::capacity + 1 : copyBegin;
+
+        for( auto i = begin; i < end; ++i )
+        {
+            auto& event = events[i - copyBegin];
+            auto timestamp = double(event.start) * ticksToMicroseconds;
+
+            beginEvent();
+            out << "{\"name\":" << juce::JSON::toString(event.name) << ",\"pid\":1,\"tid\":" << ring->threadId
+                << ",\"ts\":" << juce::String(timestamp, 3);
+
+            if( event.end == event.start )
+                out << ",\"ph\":\"i\",\"s\":\"t\"}";
+            else
+                out << ",\"ph\":\"X\",\"dur\":" << juce::String(double(event.end - event.start) * ticksToMicroseconds, 3) << "}";
+        }
+    }
+
+    out << "\n]}\n";
+}
+
+bool Trace::writeJson(const juce::File& file)
+{
+    juce::FileOutputStream out(file);
+
+    if( ! out.openedOk() )
+        return false;
+
+    out.setPosition(0);
+    out.truncate();
+
+    writeJson(out);
+    out.flush();
+
+    return out.getStatus().wasOk();
+}
+
+juce::File Trace::getDefaultFile()
+{
+    auto name = "SimpleDualFilter-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json";
+    return juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile(name);
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    Trace.h
+
+    Optional trace points, compiled in with SDF_ENABLE_TRACE=1. Each thread
+    writes timestamped events into its own lock-free ring of the most recent
+    events, and writeJson() dumps all rings in the Chrome trace event format,
+    which chrome://tracing and ui.perfetto.dev open. With tracing disabled the
+    macros compile to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef SDF_ENABLE_TRACE
+ #define SDF_ENABLE_TRACE 0
+#endif
+
+namespace Trace
+{
+    // Names must be string literals, only the pointer is stored
+    void writeEvent(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    inline juce::int64 now() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    struct ScopedEvent
+    {
+        explicit ScopedEvent(const char* eventName) noexcept : name(eventName), start(now()) {}
+        ~ScopedEvent() { writeEvent(name, start, now()); }
+
+        const char* name;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedEvent)
+    };
+
+    // Every event still in the rings, from every thread that has traced so far.
+    // Safe to call from any thread while the others keep tracing.
+    void writeJson(juce::OutputStream& out);
+    bool writeJson(const juce::File& file);
+
+    // Desktop/SimpleDualFilter-<date>.json
+    juce::File getDefaultFile();
+}
+
+#if SDF_ENABLE_TRACE
+ // Records the time from here to the end of the enclosing scope
+ #define SDF_TRACE_SCOPE(name)   const Trace::ScopedEvent JUCE_JOIN_MACRO (traceEvent_, __LINE__) (name)
+ // Records a point in time
+ #define SDF_TRACE_INSTANT(name) do { auto traceTicks_ = Trace::now(); Trace::writeEvent (name, traceTicks_, traceTicks_); } while (false)
+#else
+ #define SDF_TRACE_SCOPE(name)
+ #define SDF_TRACE_INSTANT(name)
+#endif
@@ -0,0 +1,526 @@
+/*
+  ==============================================================================
+
+    VoiceBank.h
+
+    Key Track mode: every held MIDI note gets a voice of two peaks in series,
+    the first at the note's pitch and the second SPAN harmonics above it, so
+    whole SPAN values land on the note's overtones. GAIN, QUAL, BAL and the
+    peak design apply to every voice as they do to the two bands of the chain.
+
+    The voices all filter the same input and the bank outputs
+
+        y = x + sum over v of level[v] * (H_v(x) - x)
+
+    so a single voice at full level is exactly its dual peak, and voices whose
+    peaks don't overlap combine like a cascade. Summing makes the voices
+    independent of each other, so their coefficients and states are stored
+    voice by voice in arrays and one vector instruction advances 8 or 16
+    voices at once. The whole pool costs about as much as four serial chains,
+    not sixteen, and with no note sounding the bank only applies the gain.
+
+    VoicePool allocates the voices from a fixed pool, with no allocation on
+    the audio thread, and moves each voice's level with a short attack and
+    release. The levels are part of the coefficients, so the bank ramps them
+    with everything else between control ticks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "PeakChain.h"
+
+constexpr int maxKeyTrackVoices = 16;
+
+// The coefficients of all voices, each row holding one coefficient for every voice
+template <typename SampleType>
+struct VoiceBankCoefficients
+{
+    using Lanes = std::array<SampleType, maxKeyTrackVoices>;
+
+    // The first peak's b0 b1 b2 a1 a2, the second peak's, then the voice's level
+    enum Row { b0, b1, b2, a1, a2, secondB0, secondB1, secondB2, secondA1, secondA2, level, numRows };
+
+    VoiceBankCoefficients() noexcept
+    {
+        // Silent voices with pass-through sections
+        rows[b0].fill(SampleType(1));
+        rows[secondB0].fill(SampleType(1));
+    }
+
+    Lanes& operator[] (int row) noexcept { return rows[(size_t) row]; }
+    const Lanes& operator[] (int row) const noexcept { return rows[(size_t) row]; }
+
+    void setVoice(int voice, const BiquadCoefficients<double>& first, const BiquadCoefficients<double>& second, double voiceLevel) noexcept
+    {
+        const double values[numRows] { first.b0, first.b1, first.b2, first.a1, first.a2,
+                                        second.b0, second.b1, second.b2, second.a1, second.a2, voiceLevel };
+
+        for( int row = 0; row < numRows; ++row )
+            rows[(size_t) row][(size_t) voice] = SampleType(values[row]);
+    }
+
+    bool isSilent() const noexcept
+    {
+        return std::all_of(rows[level].begin(), rows[level].end(), [](SampleType value) { return value == SampleType(0); });
+    }
+
+    template <typename OtherType>
+    explicit operator VoiceBankCoefficients<OtherType>() const noexcept
+    {
+        VoiceBankCoefficients<OtherType> result;
+
+        for( int row = 0; row < numRows; ++row )
+            for( int voice = 0; voice < maxKeyTrackVoices; ++voice )
+                result[row][(size_t) voice] = OtherType(rows[(size_t) row][(size_t) voice]);
+
+        return result;
+    }
+
+    alignas(64) std::array<Lanes, numRows> rows {};
+};
+
+//==============================================================================
+template <typename SampleType = float>
+class VoiceBank
+{
+public:
+    static constexpr int numVoices = maxKeyTrackVoices;
+    static constexpr int maxChannels = 2;
+
+    using Coefficients = VoiceBankCoefficients<SampleType>;
+
+    void reset() noexcept
+    {
+        state = {};
+    }
+
+    // Jumps the gain, and the coefficients with it so no ramp is left half way
+    void setGainLinear(SampleType newGain) noexcept
+    {
+        gain = targetGain = newGain;
+        coefficients = target;
+        rampSamplesRemaining = 0;
+        updateSounding();
+    }
+
+    SampleType getGainLinear() const noexcept { return gain; }
+
+    // Ramps the coefficients, levels included, and the gain like PeakChain::setTarget
+    void setTarget(const Coefficients& newTarget, SampleType newTargetGain, int rampLength) noexcept
+    {
+        target = newTarget;
+        targetGain = newTargetGain;
+
+        if( rampLength <= 0 )
+        {
+            coefficients = target;
+            gain = targetGain;
+            rampSamplesRemaining = 0;
+            updateSounding();
+            return;
+        }
+
+        auto scale = SampleType(1) / SampleType(rampLength);
+
+        for( int row = 0; row < Coefficients::numRows; ++row )
+            for( int voice = 0; voice < numVoices; ++voice )
+                increments[row][(size_t) voice] = (target[row][(size_t) voice] - coefficients[row][(size_t) voice]) * scale;
+
+        gainIncrement = (targetGain - gain) * scale;
+        rampStart = coefficients;
+        rampPosition = 0;
+        rampSamplesRemaining = rampLength;
+        sounding = ! coefficients.isSilent() || ! target.isSilent();
+    }
+
+    bool isRamping() const noexcept { return rampSamplesRemaining > 0; }
+
+    // Continues from a bank with another precision, like PeakChain::copyStateFrom
+    template <typename OtherSampleType>
+    void copyStateFrom(const VoiceBank<OtherSampleType>& other) noexcept
+    {
+        coefficients = Coefficients(other.coefficients);
+        target = Coefficients(other.target);
+        increments = Coefficients(other.increments);
+        rampStart = Coefficients(other.rampStart);
+
+        for( int ch = 0; ch < maxChannels; ++ch )
+            for( int voice = 0; voice < numVoices; ++voice )
+            {
+                state[ch].s1[(size_t) voice] = SampleType(other.state[ch].s1[(size_t) voice]);
+                state[ch].s2[(size_t) voice] = SampleType(other.state[ch].s2[(size_t) voice]);
+                state[ch].t1[(size_t) voice] = SampleType(other.state[ch].t1[(size_t) voice]);
+                state[ch].t2[(size_t) voice] = SampleType(other.state[ch].t2[(size_t) voice]);
+            }
+
+        gain = SampleType(other.gain);
+        targetGain = SampleType(other.targetGain);
+        gainIncrement = SampleType(other.gainIncrement);
+        rampPosition = other.rampPosition;
+        rampSamplesRemaining = other.rampSamplesRemaining;
+        sounding = other.sounding;
+    }
+
+    // Kernel variant used by process(), see PeakKernels.cpp
+    using ProcessFunction = void (*)(VoiceBank&, SampleType* const*, int, int) noexcept;
+
+    void setProcessFunction(ProcessFunction newFunction) noexcept { processFunction = newFunction; }
+
+    static void processGeneric(VoiceBank& bank, SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        bank.processInline(channels, numChannels, numSamples);
+    }
+
+    // Processes up to two channels in place, gain included
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        processFunction(*this, channels, numChannels, numSamples);
+    }
+
+    // The kernel body, inlined into each instruction set variant
+    PEAK_CHAIN_FORCEINLINE void processInline(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if( numChannels >= 2 )
+            processChannels<2>(channels, numSamples);
+        else if( numChannels == 1 )
+            processChannels<1>(channels, numSamples);
+        else
+            processChannels<0>(channels, numSamples);
+    }
+
+private:
+    template <typename> friend class VoiceBank;
+
+    // The states of all voices side by side, like the coefficients
+    struct ChannelState
+    {
+        typename Coefficients::Lanes s1 {}, s2 {}, t1 {}, t2 {};
+    };
+
+    using ChannelStates = std::array<ChannelState, maxChannels>;
+
+    void updateSounding() noexcept
+    {
+        sounding = ! coefficients.isSilent();
+
+        // Silent voices would otherwise hold their last state until a note reuses them
+        if( ! sounding )
+            state = {};
+    }
+
+    template <int NumChannels>
+    PEAK_CHAIN_FORCEINLINE void processChannels(SampleType* const* channels, int numSamples) noexcept
+    {
+        auto numRampSamples = std::min(numSamples, rampSamplesRemaining);
+        auto g = gain;
+        int i = 0;
+
+        if( ! sounding )
+        {
+            // Every voice stays silent through the ramp, so only the gain needs to move
+            for( ; i < numRampSamples; ++i )
+            {
+                g += gainIncrement;
+
+                for( int ch = 0; ch < NumChannels; ++ch )
+                    channels[ch][i] *= g;
+            }
+
+            if( finishRamp(numRampSamples, g) )
+                coefficients = target;
+
+            for( ; i < numSamples; ++i )
+                for( int ch = 0; ch < NumChannels; ++ch )
+                    channels[ch][i] *= g;
+
+            gain = g;
+            return;
+        }
+
+        // Local copies, as in PeakChain, so the compiler keeps them out of memory it can't trust
+        auto c = coefficients;
+        auto st = state;
+
+        for( ; i < numRampSamples; ++i )
+        {
+            // Stepped from the start of the ramp rather than accumulated: the low voices' poles
+            // sit close to the unit circle, where the rounding of summed float increments shows
+            auto position = SampleType(++rampPosition);
+
+            for( int row = 0; row < Coefficients::numRows; ++row )
+                for( int voice = 0; voice < numVoices; ++voice )
+                    c[row][(size_t) voice] = rampStart[row][(size_t) voice] + increments[row][(size_t) voice] * position;
+
+            g += gainIncrement;
+
+            processFrame<NumChannels>(channels, i, c, g, st);
+        }
+
+        if( finishRamp(numRampSamples, g) )
+            c = target;
+
+        for( ; i < numSamples; ++i )
+            processFrame<NumChannels>(channels, i, c, g, st);
+
+        coefficients = c;
+        gain = g;
+        state = st;
+
+        if( ! isRamping() )
+            updateSounding();
+    }
+
+    // Lands exactly on the target once the ramp runs out, true if it did
+    bool finishRamp(int numRampSamples, SampleType& g) noexcept
+    {
+        if( numRampSamples == 0 )
+            return false;
+
+        rampSamplesRemaining -= numRampSamples;
+
+        if( rampSamplesRemaining > 0 )
+            return false;
+
+        g = targetGain;
+        return true;
+    }
+
+    template <int NumChannels>
+    static PEAK_CHAIN_FORCEINLINE void processFrame(SampleType* const* channels, int index,
+                                                    const Coefficients& c, SampleType g, ChannelStates& st) noexcept
+    {
+        using C = Coefficients;
+
+        for( int ch = 0; ch < NumChannels; ++ch )
+        {
+            auto x = channels[ch][index];
+            auto& s = st[ch];
+
+            // The voices are independent, so this loop vectorises across them
+            typename C::Lanes d;
+
+            for( size_t v = 0; v < (size_t) numVoices; ++v )
+            {
+                auto u = c[C::b0][v] * x + s.s1[v];
+                s.s1[v] = c[C::b1][v] * x - c[C::a1][v] * u + s.s2[v];
+                s.s2[v] = c[C::b2][v] * x - c[C::a2][v] * u;
+
+                auto y = c[C::secondB0][v] * u + s.t1[v];
+                s.t1[v] = c[C::secondB1][v] * u - c[C::secondA1][v] * y + s.t2[v];
+                s.t2[v] = c[C::secondB2][v] * u - c[C::secondA2][v] * y;
+
+                d[v] = c[C::level][v] * (y - x);
+            }
+
+            auto sum = x;
+
+            for( size_t v = 0; v < (size_t) numVoices; ++v )
+                sum += d[v];
+
+            channels[ch][index] = g * sum;
+        }
+    }
+
+    Coefficients coefficients, target, increments, rampStart;
+    ChannelStates state;
+    SampleType gain { 1 }, targetGain { 1 }, gainIncrement { 0 };
+    int rampPosition { 0 }, rampSamplesRemaining { 0 };
+    bool sounding { false };
+
+    ProcessFunction processFunction { &VoiceBank::processGeneric };
+};
+
+//==============================================================================
+// Notes to voices, on the audio thread. Holds no memory beyond the fixed pool.
+class VoicePool
+{
+public:
+    static constexpr double attackSeconds = 0.005;
+    static constexpr double releaseSeconds = 0.05;
+
+    // Silences every voice at once
+    void reset() noexcept
+    {
+        voices = {};
+        notesChanged = true;
+    }
+
+    // A note that still sounds is picked up again. Without a free voice the quietest
+    // released one is taken, then the oldest held one, and glides to the new note.
+    void noteOn(int note, float velocity) noexcept
+    {
+        auto* voice = findVoice(note);
+
+        if( voice == nullptr )
+            voice = findFreeVoice();
+
+        voice->note = note;
+        voice->held = true;
+        voice->velocity = double(velocity);
+        voice->startedAt = ++noteCounter;
+        notesChanged = true;
+    }
+
+    void noteOff(int note) noexcept
+    {
+        if( auto* voice = findVoice(note) )
+        {
+            voice->held = false;
+            notesChanged = true;
+        }
+    }
+
+    // Releases every held note
+    void allNotesOff() noexcept
+    {
+        for( auto& voice : voices )
+            voice.held = false;
+
+        notesChanged = true;
+    }
+
+    // True while a note changed since the last design or a level is still moving
+    bool isMoving() const noexcept
+    {
+        if( notesChanged )
+            return true;
+
+        return std::any_of(voices.begin(), voices.end(), [](const Voice& voice)
+        {
+            return voice.note >= 0 && voice.level != voice.getTargetLevel();
+        });
+    }
+
+    // Advances the levels by numSamples and writes the design to ramp to over them.
+    // A voice is only designed again when its note or the settings change.
+    void design(const ChainSettings& chainSettings, double sampleRate, int numSamples,
+                VoiceBankCoefficients<double>& coefficients) noexcept
+    {
+        auto settingsChanged = sampleRate != designedSampleRate || ! hasSameVoiceDesign(chainSettings, designedSettings);
+
+        designedSettings = chainSettings;
+        designedSampleRate = sampleRate;
+        notesChanged = false;
+
+        // With no samples to advance by, the design only catches up with the notes and settings
+        auto attackStep = numSamples > 0 ? double(numSamples) / (attackSeconds * sampleRate) : 0.0;
+        auto releaseStep = numSamples > 0 ? double(numSamples) / (releaseSeconds * sampleRate) : 0.0;
+
+        for( int index = 0; index < maxKeyTrackVoices; ++index )
+        {
+            auto& voice = voices[(size_t) index];
+
+            if( voice.note >= 0 )
+            {
+                auto targetLevel = voice.getTargetLevel();
+
+                voice.level = voice.level < targetLevel ? std::min(targetLevel, voice.level + attackStep)
+                                                        : std::max(targetLevel, voice.level - releaseStep);
+
+                if( voice.note != voice.designedNote || settingsChanged )
+                {
+                    designVoice(voice, chainSettings, sampleRate);
+                    voice.designedNote = voice.note;
+                }
+
+                // Released and faded out, the voice is free again but keeps its design
+                if( ! voice.held && voice.level == 0.0 )
+                    voice.note = -1;
+            }
+
+            coefficients.setVoice(index, voice.first, voice.second, voice.level);
+        }
+    }
+
+    // Frequency of a MIDI note, A4 = 440 Hz
+    static double getNoteFrequency(int note) noexcept
+    {
+        return 440.0 * std::pow(2.0, double(note - 69) / 12.0);
+    }
+
+private:
+    struct Voice
+    {
+        int note { -1 };
+        bool held { false };
+        double velocity { 0 }, level { 0 };
+        std::uint32_t startedAt { 0 };
+
+        // The sections last designed, kept while the voice is free so a fade-out keeps its shape
+        int designedNote { -1 };
+        BiquadCoefficients<double> first, second;
+
+        double getTargetLevel() const noexcept { return held ? velocity : 0.0; }
+    };
+
+    Voice* findVoice(int note) noexcept
+    {
+        for( auto& voice : voices )
+            if( voice.note == note )
+                return &voice;
+
+        return nullptr;
+    }
+
+    Voice* findFreeVoice() noexcept
+    {
+        Voice* quietestReleased = nullptr;
+        Voice* oldestHeld = nullptr;
+
+        for( auto& voice : voices )
+        {
+            if( voice.note < 0 )
+                return &voice;
+
+            if( ! voice.held && (quietestReleased == nullptr || voice.level < quietestReleased->level) )
+                quietestReleased = &voice;
+
+            if( voice.held && (oldestHeld == nullptr || voice.startedAt < oldestHeld->startedAt) )
+                oldestHeld = &voice;
+        }
+
+        return quietestReleased != nullptr ? quietestReleased : oldestHeld;
+    }
+
+    static void designVoice(Voice& voice, const ChainSettings& chainSettings, double sampleRate) noexcept
+    {
+        auto frequency = getNoteFrequency(voice.note);
+
+        voice.first = makeVoicePeak(chainSettings, frequency, 0, sampleRate);
+        voice.second = makeVoicePeak(chainSettings, frequency * (1.0 + double(chainSettings.span)), 1, sampleRate);
+    }
+
+    static BiquadCoefficients<double> makeVoicePeak(const ChainSettings& chainSettings, double frequency, int band, double sampleRate) noexcept
+    {
+        // Clamped like getPeakBandFrequency, tilted by BAL like the chain's two bands
+        frequency = std::min(std::max(frequency, 20.0), 0.49 * sampleRate);
+        auto gainFactor = std::pow(10.0, getPeakBandGainInDecibels(chainSettings, band, 2) * 0.05);
+
+        if( chainSettings.design == PeakDesign::matched )
+            return makeMatchedPeakCoefficients<double>(sampleRate, frequency, chainSettings.peak1Quality, gainFactor);
+
+        return makePeakCoefficients<double>(sampleRate, frequency, chainSettings.peak1Quality, gainFactor);
+    }
+
+    static bool hasSameVoiceDesign(const ChainSettings& a, const ChainSettings& b) noexcept
+    {
+        return a.peak1GainInDecibels == b.peak1GainInDecibels && a.peak1Quality == b.peak1Quality
+            && a.span == b.span && a.balance == b.balance && a.design == b.design;
+    }
+
+    std::array<Voice, maxKeyTrackVoices> voices;
+    ChainSettings designedSettings;
+    double designedSampleRate { 0 };
+    std::uint32_t noteCounter { 0 };
+    bool notesChanged { false };
+};
+
+//==============================================================================
+// Instruction set variants of the voice bank kernel, defined in PeakKernels.cpp
+template <typename SampleType>
+typename VoiceBank<SampleType>::ProcessFunction getVoiceBankKernelFunction(PeakKernel kernel);
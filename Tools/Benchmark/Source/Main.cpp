@@ -0,0 +1,332 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Measures the cost per sample of SimpleDualFilterAudioProcessor::processBlock
+    for host block sizes from 1 to 1024 samples in every InternalBlockMode,
+    while FREQ is automated, to show how the fixed per-block work is amortised,
+    the cost per point of the batch frequency response query, and the serial
+    peak cascade against its parallel form and the morphing SVF chain on a
+    settled design, the cost of the saturator after them, of a full pool of
+    Key Track voices and of the Pitch Track detector, and how long the editor
+    takes to open.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/PluginEditor.h"
+
+static double measureNanosecondsPerSample(InternalBlockMode mode, int blockSize)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numSeconds = 10;
+    constexpr int internalBlockSize = 256;
+
+    SimpleDualFilterAudioProcessor processor;
+    processor.setInternalBlockMode(mode, internalBlockSize);
+    processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::Random random(1);
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+    juce::MidiBuffer midi;
+
+    for( int ch = 0; ch < noise.getNumChannels(); ++ch )
+        for( int i = 0; i < blockSize; ++i )
+            noise.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+    auto* freq = processor.apvts.getParameter("Peak1 Freq");
+
+    // Move FREQ 20 times per second so the smoothing and the coefficient ramps run
+    auto totalSamples = int(sampleRate) * numSeconds;
+    auto automationInterval = int(sampleRate) / 20;
+    int samplesSinceAutomation = 0;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for( int done = 0; done < totalSamples; done += blockSize )
+    {
+        samplesSinceAutomation += blockSize;
+
+        if( samplesSinceAutomation >= automationInterval )
+        {
+            freq->setValueNotifyingHost(random.nextFloat());
+            samplesSinceAutomation = 0;
+        }
+
+        buffer.makeCopyOf(noise, true);
+        processor.processBlock(buffer, midi);
+    }
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    processor.releaseResources();
+
+    return seconds * 1.0e9 / double(totalSamples);
+}
+
+static double measureResponseNanosecondsPerPoint()
+{
+    constexpr int numPoints = 1 << 20;
+
+    SimpleDualFilterAudioProcessor processor;
+    processor.setPlayConfigDetails(2, 2, 48000.0, 512);
+
+    ChainSettings settings;
+    settings.peak1Freq = 500.f;
+    settings.peak1GainInDecibels = 9.f;
+    settings.span = 3.f;
+    settings.numPeaks = maxNumPeaks;
+
+    std::vector<double> frequencies(numPoints), magnitudes(numPoints), phases(numPoints), groupDelays(numPoints);
+
+    for( int i = 0; i < numPoints; ++i )
+        frequencies[(size_t) i] = juce::mapToLog10(double(i) / double(numPoints), 20.0, 20000.0);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    processor.getFrequencyResponse(settings, frequencies.data(), numPoints,
+                                   magnitudes.data(), phases.data(), groupDelays.data());
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    return seconds * 1.0e9 / double(numPoints);
+}
+
+// A settled design, where the parallel form runs, on stereo blocks of 256 samples
+template <typename Chain>
+static double measureChainNanosecondsPerSample(Chain& chain, float morph = 0.f)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    constexpr int numBlocks = 20000;
+
+    ChainSettings settings;
+    settings.peak1Freq = 500.f;
+    settings.peak1GainInDecibels = 9.f;
+    settings.peak1Quality = 2.f;
+    settings.span = 3.f;
+    settings.balance = 4.f;
+    settings.morph = morph;
+
+    chain.updateCoefficients(settings, sampleRate);
+    chain.setGainLinear(0.5f);
+
+    juce::Random random(1);
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+
+    for( int ch = 0; ch < noise.getNumChannels(); ++ch )
+        for( int i = 0; i < blockSize; ++i )
+            noise.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for( int block = 0; block < numBlocks; ++block )
+    {
+        buffer.makeCopyOf(noise, true);
+        chain.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+    }
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    return seconds * 1.0e9 / double(numBlocks * blockSize);
+}
+
+template <int NumPeaks>
+static void compareChainForms(PeakKernel kernel)
+{
+    PeakChain<NumPeaks> serial;
+    serial.setProcessFunction(getPeakKernelFunction<NumPeaks, float>(kernel));
+
+    ParallelPeakChain<NumPeaks> parallel;
+    parallel.setProcessFunctions(getParallelPeakKernelFunction<NumPeaks, float>(kernel), getPeakKernelFunction<NumPeaks, float>(kernel));
+
+    // Between low and high shelf, the one SVF per band a morph position costs
+    MorphChain<NumPeaks> morph;
+    morph.setProcessFunction(getMorphKernelFunction<NumPeaks, float>(kernel));
+
+    auto serialTime = measureChainNanosecondsPerSample(serial);
+    auto parallelTime = measureChainNanosecondsPerSample(parallel);
+    auto morphTime = measureChainNanosecondsPerSample(morph, 1.5f);
+
+    std::printf("%d peaks         %10.2f %10.2f %10.2f%s\n", NumPeaks, serialTime, parallelTime, morphTime,
+                parallel.isParallel() ? "" : "  (no expansion, ran serial)");
+}
+
+// Drives the curve hard, a settled gain, same blocks as above
+static double measureSaturatorNanosecondsPerSample(PeakKernel kernel)
+{
+    constexpr int blockSize = 256;
+    constexpr int numBlocks = 20000;
+
+    Saturator<float> saturator;
+    saturator.setProcessFunction(getSaturatorKernelFunction<float>(kernel));
+    saturator.setGainLinear(0.5f);
+
+    juce::Random random(1);
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+
+    for( int ch = 0; ch < noise.getNumChannels(); ++ch )
+        for( int i = 0; i < blockSize; ++i )
+            noise.setSample(ch, i, (random.nextFloat() * 2.f - 1.f) * 8.f);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for( int block = 0; block < numBlocks; ++block )
+    {
+        buffer.makeCopyOf(noise, true);
+        saturator.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+    }
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    return seconds * 1.0e9 / double(numBlocks * blockSize);
+}
+
+// Every voice of the pool held, same blocks as above
+static double measureVoiceBankNanosecondsPerSample(PeakKernel kernel)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    constexpr int numBlocks = 20000;
+
+    ChainSettings settings;
+    settings.peak1GainInDecibels = 9.f;
+    settings.peak1Quality = 2.f;
+    settings.span = 1.f;
+
+    VoicePool pool;
+
+    for( int voice = 0; voice < maxKeyTrackVoices; ++voice )
+        pool.noteOn(48 + 2 * voice, 1.f);
+
+    // Long enough for every attack to finish
+    VoiceBankCoefficients<double> coefficients;
+
+    for( int i = 0; i < 8; ++i )
+        pool.design(settings, sampleRate, blockSize, coefficients);
+
+    VoiceBank<float> bank;
+    bank.setProcessFunction(getVoiceBankKernelFunction<float>(kernel));
+    bank.setTarget(VoiceBankCoefficients<float>(coefficients), 0.5f, 0);
+
+    juce::Random random(1);
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+
+    for( int ch = 0; ch < noise.getNumChannels(); ++ch )
+        for( int i = 0; i < blockSize; ++i )
+            noise.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for( int block = 0; block < numBlocks; ++block )
+    {
+        buffer.makeCopyOf(noise, true);
+        bank.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+    }
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    return seconds * 1.0e9 / double(numBlocks * blockSize);
+}
+
+// Listening and analysing at every block, like the processor's control ticks at the idle rate
+static double measurePitchTrackerNanosecondsPerSample(PitchTracker& tracker)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 64;
+    constexpr int numBlocks = 80000;
+    constexpr int toneLength = 1 << 18;
+
+    tracker.prepare(sampleRate);
+
+    // A sawtooth gliding up two octaves and starting over, so every window is voiced
+    std::vector<float> tone((size_t) toneLength);
+    double phase = 0.0;
+
+    for( int i = 0; i < toneLength; ++i )
+    {
+        auto toneFrequency = 80.0 * std::exp2(2.0 * double(i) / double(toneLength));
+
+        tone[(size_t) i] = float(0.5 * (phase / juce::MathConstants<double>::pi - 1.0));
+        phase = std::fmod(phase + juce::MathConstants<double>::twoPi * toneFrequency / sampleRate, juce::MathConstants<double>::twoPi);
+    }
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for( int block = 0; block < numBlocks; ++block )
+    {
+        auto* samples = tone.data() + (block * blockSize) % toneLength;
+        const float* channels[] { samples, samples };
+
+        tracker.push(channels, 2, blockSize);
+        tracker.analyse();
+    }
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    return seconds * 1.0e9 / double(numBlocks * blockSize);
+}
+
+int main()
+{
+    // The parameter tree needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::printf("ns per sample   %10s %12s %10s\n", "off", "zeroLatency", "buffered");
+
+    for( int blockSize = 1; blockSize <= 1024; blockSize *= 2 )
+    {
+        std::printf("block %5d     ", blockSize);
+
+        for( auto mode : { InternalBlockMode::off, InternalBlockMode::zeroLatency, InternalBlockMode::buffered } )
+            std::printf(" %10.2f", measureNanosecondsPerSample(mode, blockSize));
+
+        std::printf("\n");
+    }
+
+    std::printf("\nresponse query, %d peaks: %.2f ns per point\n", maxNumPeaks, measureResponseNanosecondsPerPoint());
+
+    std::printf("\nns per sample   %10s %10s %10s   (stereo, settled design, best kernel)\n", "serial", "parallel", "morph");
+
+    auto kernel = getBestPeakKernel();
+    compareChainForms<2>(kernel);
+    compareChainForms<4>(kernel);
+    compareChainForms<8>(kernel);
+
+    std::printf("\nsaturator: %.2f ns per sample (stereo, best kernel)\n", measureSaturatorNanosecondsPerSample(kernel));
+
+    PeakChain<2> dualPeak;
+    dualPeak.setProcessFunction(getPeakKernelFunction<2, float>(kernel));
+
+    std::printf("key track, %d voices: %.2f ns per sample, %d serial dual peaks: %.2f (stereo, best kernel)\n",
+                maxKeyTrackVoices, measureVoiceBankNanosecondsPerSample(kernel),
+                maxKeyTrackVoices, maxKeyTrackVoices * measureChainNanosecondsPerSample(dualPeak));
+
+    PitchTracker tracker;
+    auto pitchTrackTime = measurePitchTrackerNanosecondsPerSample(tracker);
+
+    std::printf("pitch track: %.2f ns per sample (stereo), %.1f us per analysis on average, %.1f at most\n",
+                pitchTrackTime, tracker.getAverageAnalysisMicroseconds(), tracker.getPeakAnalysisMicroseconds());
+
+    // The first editor also pays for loading the typefaces
+    SimpleDualFilterAudioProcessor processor;
+
+    std::printf("\n");
+
+    for( int i = 1; i <= 3; ++i )
+    {
+        std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditorAndMakeActive());
+        auto* pluginEditor = dynamic_cast<SimpleDualFilterAudioProcessorEditor*>(editor.get());
+        jassert(pluginEditor != nullptr);
+
+        std::printf("editor %d: opened in %.2f ms, resident memory %.1f MB\n", i,
+                    pluginEditor->getOpenTimeMilliseconds(), pluginEditor->getOpenResidentMemoryMegabytes());
+    }
+
+    return 0;
+}
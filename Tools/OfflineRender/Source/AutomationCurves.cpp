@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    AutomationCurves.cpp
+
+  ==============================================================================
+*/
+
+#include "AutomationCurves.h"
+
+float AutomationCurve::getValueAt(double seconds, size_t& cursor) const noexcept
+{
+    while( cursor + 1 < points.size() && points[cursor + 1].first <= seconds )
+        ++cursor;
+
+    auto& current = points[cursor];
+
+    if( cursor + 1 == points.size() || seconds <= current.first || stepped )
+        return current.second;
+
+    auto& next = points[cursor + 1];
+    auto t = (seconds - current.first) / (next.first - current.first);
+
+    return float(current.second + (next.second - current.second) * t);
+}
+
+//==============================================================================
+AutomationCurves::AutomationCurves(juce::AudioProcessor& processor)
+{
+    for( auto* param : processor.getParameters() )
+    {
+        if( auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param) )
+        {
+            parameters.add(ranged);
+            parameterIDs.add(ranged->getParameterID());
+
+            AutomationCurve curve;
+            curve.points.push_back({ 0.0, ranged->convertFrom0to1(ranged->getDefaultValue()) });
+            curve.stepped = dynamic_cast<juce::AudioParameterChoice*>(ranged) != nullptr;
+            curves.push_back(curve);
+        }
+    }
+
+    cursors.resize(curves.size(), 0);
+}
+
+juce::String AutomationCurves::loadFromFile(const juce::File& file)
+{
+    if( ! file.existsAsFile() )
+        return "Cannot read " + file.getFullPathName();
+
+    auto error = file.hasFileExtension("json") ? loadJson(file.loadFileAsString())
+                                               : loadCsv(juce::StringArray::fromLines(file.loadFileAsString()));
+
+    return error.isEmpty() ? error : file.getFileName() + ": " + error;
+}
+
+void AutomationCurves::getValues(double seconds, float* values) noexcept
+{
+    for( size_t i = 0; i < curves.size(); ++i )
+        values[i] = curves[i].getValueAt(seconds, cursors[i]);
+}
+
+juce::String AutomationCurves::setCurve(const juce::String& parameterID, std::vector<std::pair<double, float>> points)
+{
+    auto index = getIndex(parameterID);
+
+    if( index < 0 )
+        return "unknown parameter \"" + parameterID + "\"";
+
+    if( points.empty() )
+        return "no breakpoints for \"" + parameterID + "\"";
+
+    auto& range = parameters[index]->getNormalisableRange();
+    auto& curve = curves[(size_t) index];
+
+    for( auto& point : points )
+    {
+        point.second = juce::jlimit(range.start, range.end, point.second);
+
+        if( curve.stepped )
+            point.second = std::round(point.second);
+    }
+
+    std::stable_sort(points.begin(), points.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+    curve.points = std::move(points);
+    cursors[(size_t) index] = 0;
+
+    return {};
+}
+
+juce::String AutomationCurves::loadJson(const juce::String& text)
+{
+    auto json = juce::JSON::parse(text);
+    auto* object = json.getDynamicObject();
+
+    if( object == nullptr )
+        return "expected an object of parameter IDs";
+
+    for( auto& property : object->getProperties() )
+    {
+        std::vector<std::pair<double, float>> points;
+
+        if( property.value.isArray() )
+        {
+            for( auto& breakpoint : *property.value.getArray() )
+            {
+                if( ! breakpoint.isArray() || breakpoint.size() != 2 )
+                    return "breakpoints of \"" + property.name.toString() + "\" must be [seconds, value] pairs";
+
+                points.push_back({ double(breakpoint[0]), float(breakpoint[1]) });
+            }
+        }
+        else
+        {
+            points.push_back({ 0.0, float(property.value) });
+        }
+
+        auto error = setCurve(property.name.toString(), std::move(points));
+
+        if( error.isNotEmpty() )
+            return error;
+    }
+
+    return {};
+}
+
+juce::String AutomationCurves::loadCsv(const juce::StringArray& lines)
+{
+    std::map<juce::String, std::vector<std::pair<double, float>>> pointsByID;
+    bool firstLine = true;
+
+    for( int i = 0; i < lines.size(); ++i )
+    {
+        auto line = lines[i].upToFirstOccurrenceOf("#", false, false).trim();
+
+        if( line.isEmpty() )
+            continue;
+
+        auto isHeader = std::exchange(firstLine, false);
+
+        auto tokens = juce::StringArray::fromTokens(line, ",", "\"");
+        tokens.trim();
+        tokens.removeEmptyStrings();
+
+        auto isNumber = [](const juce::String& token)
+        {
+            return token.isNotEmpty() && token.containsOnly("0123456789.-+eE");
+        };
+
+        if( tokens.size() != 3 || ! isNumber(tokens[1]) || ! isNumber(tokens[2]) )
+        {
+            // The first line may name the columns
+            if( isHeader )
+                continue;
+
+            return "line " + juce::String(i + 1) + ": expected parameter ID, seconds, value";
+        }
+
+        pointsByID[tokens[0].unquoted()].push_back({ tokens[1].getDoubleValue(), tokens[2].getFloatValue() });
+    }
+
+    for( auto& [parameterID, points] : pointsByID )
+    {
+        auto error = setCurve(parameterID, std::move(points));
+
+        if( error.isNotEmpty() )
+            return error;
+    }
+
+    return {};
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    AutomationCurves.h
+
+    Breakpoint automation for every parameter of createParameterLayout, read
+    from JSON or CSV. Values are in the parameters' real units, choices by
+    their index, and times in seconds from the start of the file.
+
+    JSON: an object with parameter IDs as keys and either a constant or an
+    array of [seconds, value] breakpoints as values:
+
+        { "Peak1 Freq": [[0, 200], [4.5, 2000]], "Peak1 Gain": 6, "Bands": 1 }
+
+    CSV: one "parameter ID, seconds, value" breakpoint per line, '#' starts a
+    comment and a header line is skipped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Breakpoints of one parameter, ordered by time. Values are interpolated
+// linearly, choices hold each value until the next breakpoint.
+struct AutomationCurve
+{
+    std::vector<std::pair<double, float>> points;
+    bool stepped { false };
+
+    // Times must not decrease from one call to the next with the same cursor
+    float getValueAt(double seconds, size_t& cursor) const noexcept;
+};
+
+class AutomationCurves
+{
+public:
+    // Every parameter of the processor, constant at its default value
+    explicit AutomationCurves(juce::AudioProcessor& processor);
+
+    // Replaces the curves of the parameters the file names. Returns an error
+    // message, or an empty string on success.
+    juce::String loadFromFile(const juce::File& file);
+
+    int getNumParameters() const noexcept { return (int) curves.size(); }
+
+    // Position in createParameterLayout, or -1
+    int getIndex(const juce::String& parameterID) const { return parameterIDs.indexOf(parameterID); }
+
+    const AutomationCurve& getCurve(int index) const { return curves[(size_t) index]; }
+
+    // Values of all parameters in layout order. Times must not decrease from one
+    // call to the next, each curve keeps its position between calls.
+    void getValues(double seconds, float* values) noexcept;
+
+private:
+    juce::String setCurve(const juce::String& parameterID, std::vector<std::pair<double, float>> points);
+
+    juce::String loadJson(const juce::String& text);
+    juce::String loadCsv(const juce::StringArray& lines);
+
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    juce::StringArray parameterIDs;
+    std::vector<AutomationCurve> curves;
+    std::vector<size_t> cursors;
+};
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Renders an audio file through the filter with every parameter following
+    breakpoint automation, see AutomationCurves.h for the formats.
+
+        SimpleDualFilterOfflineRender --input in.wav --output out.wav
+                                      [--automation curves.json|curves.csv]
+                                      [--step N] [--block N]
+
+    --step sets the samples per coefficient design, 1 (the default) designs
+    at every sample like the plugin's offline bounce.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include "../../../Source/PluginProcessor.h"
+
+#include "AutomationCurves.h"
+#include "RenderPipeline.h"
+
+static int fail(const juce::String& message)
+{
+    std::fprintf(stderr, "%s\n", message.toRawUTF8());
+    return 1;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // The parameter tree needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+
+    if( ! args.containsOption("--input") || ! args.containsOption("--output") )
+        return fail("Usage: SimpleDualFilterOfflineRender --input in.wav --output out.wav\n"
+                    "                                     [--automation curves.json|curves.csv] [--step N] [--block N]");
+
+    // The processor only provides the parameter layout and defaults
+    SimpleDualFilterAudioProcessor processor;
+    AutomationCurves curves(processor);
+
+    if( args.containsOption("--automation") )
+    {
+        auto error = curves.loadFromFile(args.getFileForOption("--automation"));
+
+        if( error.isNotEmpty() )
+            return fail(error);
+    }
+
+    RenderOptions options;
+
+    if( args.containsOption("--step") )
+        options.controlStep = juce::jmax(1, args.getValueForOption("--step").getIntValue());
+
+    if( args.containsOption("--block") )
+        options.blockSize = juce::jlimit(64, 1 << 16, args.getValueForOption("--block").getIntValue());
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto inputFile = args.getFileForOption("--input");
+    std::unique_ptr<juce::AudioFormatReader> fileReader(formats.createReaderFor(inputFile));
+
+    if( fileReader == nullptr )
+        return fail("Cannot read " + inputFile.getFullPathName());
+
+    auto outputFile = args.getFileForOption("--output");
+    outputFile.deleteFile();
+
+    auto outputStream = outputFile.createOutputStream();
+
+    if( outputStream == nullptr )
+        return fail("Cannot write " + outputFile.getFullPathName());
+
+    auto bitsPerSample = juce::jlimit(16, 32, (int) fileReader->bitsPerSample);
+    auto sampleRate = fileReader->sampleRate;
+    auto numChannels = fileReader->numChannels;
+
+    std::unique_ptr<juce::AudioFormatWriter> fileWriter(juce::WavAudioFormat().createWriterFor(outputStream.get(), sampleRate, numChannels,
+                                                                                               bitsPerSample, {}, 0));
+
+    if( fileWriter == nullptr )
+        return fail("Cannot write a WAV file with " + juce::String(numChannels) + " channels at " + juce::String(sampleRate) + " Hz");
+
+    outputStream.release();
+
+    // Reading ahead and writing behind each get a thread, so the disk overlaps with both stages
+    juce::TimeSliceThread readThread("Read"), writeThread("Write");
+    readThread.startThread();
+    writeThread.startThread();
+
+    RenderStatistics statistics;
+    juce::String error;
+
+    {
+        constexpr int ioBufferSize = 1 << 18;
+
+        juce::BufferingAudioReader reader(fileReader.release(), readThread, ioBufferSize);
+        reader.setReadTimeout(-1);
+
+        juce::AudioFormatWriter::ThreadedWriter writer(fileWriter.release(), writeThread, ioBufferSize);
+
+        error = renderWithAutomation(reader, writer, curves, options, statistics);
+    }
+
+    readThread.stopThread(1000);
+    writeThread.stopThread(1000);
+
+    if( error.isNotEmpty() )
+        return fail(error);
+
+    auto audioSeconds = double(statistics.numSamples) / sampleRate;
+
+    std::printf("%.1f s of audio in %.2f s (%.0fx real time), %lld designs\n",
+                audioSeconds, statistics.seconds, audioSeconds / juce::jmax(1.0e-9, statistics.seconds),
+                (long long) statistics.numSteps);
+    std::printf("design thread: %.2f s busy, %.2f s waiting for room in the queue\n",
+                statistics.designSeconds, statistics.designWaitSeconds);
+    std::printf("render thread: %.2f s in the kernels, %.2f s waiting for designs, %.2f s for reads, %.2f s for writes\n",
+                statistics.processSeconds, statistics.stepWaitSeconds, statistics.readWaitSeconds, statistics.writeWaitSeconds);
+
+    return 0;
+}
@@ -0,0 +1,341 @@
+/*
+  ==============================================================================
+
+    RenderPipeline.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderPipeline.h"
+
+#include "../../../Source/MorphChain.h"
+#include "../../../Source/Saturator.h"
+#include "../../../Source/AutoGain.h"
+
+namespace
+{
+    double getSecondsSince(juce::int64 startTicks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    // Parameter values in layout order to ChainSettings, like ChainParameters::load
+    struct SettingsMapping
+    {
+        explicit SettingsMapping(const AutomationCurves& curves)
+            : peak1Freq(curves.getIndex("Peak1 Freq")),
+              peak1Gain(curves.getIndex("Peak1 Gain")),
+              peak1Quality(curves.getIndex("Peak1 Quality")),
+              span(curves.getIndex("Span")),
+              balance(curves.getIndex("Balance")),
+              outputGain(curves.getIndex("Output Gain")),
+              bands(curves.getIndex("Bands")),
+              design(curves.getIndex("Peak Design")),
+              morph(curves.getIndex("Morph")),
+              saturation(curves.getIndex("Saturation")),
+              drive(curves.getIndex("Drive")),
+              autoGain(curves.getIndex("Auto Gain"))
+        {
+            for( auto index : { peak1Freq, peak1Gain, peak1Quality, span, balance, outputGain, bands, design, morph, saturation, drive, autoGain } )
+                jassert(index >= 0);
+        }
+
+        ChainSettings toChainSettings(const float* values) const noexcept
+        {
+            ChainSettings settings;
+
+            settings.peak1Freq = values[peak1Freq];
+            settings.peak1GainInDecibels = values[peak1Gain];
+            settings.peak1Quality = values[peak1Quality];
+            settings.span = values[span];
+            settings.balance = values[balance];
+            settings.outputGain = values[outputGain];
+            settings.numPeaks = peakChainSizes[juce::jlimit(0, 2, juce::roundToInt(values[bands]))];
+            settings.design = values[design] >= 0.5f ? PeakDesign::matched : PeakDesign::bilinear;
+            settings.morph = values[morph];
+            settings.saturate = values[saturation] >= 0.5f;
+            settings.drive = values[drive];
+            settings.autoGain = values[autoGain] >= 0.5f;
+
+            return settings;
+        }
+
+        int peak1Freq, peak1Gain, peak1Quality, span, balance, outputGain, bands, design, morph, saturation, drive, autoGain;
+    };
+
+    // Everything the kernels need for one control step
+    template <typename Chain>
+    struct ControlStep
+    {
+        typename Chain::CoefficientArray coefficients;
+        double chainGain { 1 }, saturatorGain { 1 };
+        bool saturate { false };
+    };
+
+    template <typename Chain>
+    ControlStep<Chain> designStep(ChainSettings settings, double sampleRate, AutoGain& autoGain)
+    {
+        settings.numPeaks = Chain::numPeaks;
+
+        ControlStep<Chain> step;
+        step.coefficients = Chain::makeCoefficients(settings, sampleRate);
+        step.chainGain = juce::Decibels::decibelsToGain(double(getChainGainInDecibels(settings)));
+
+        if( settings.autoGain )
+            step.chainGain *= autoGain.getMakeUpGain(settings, step.coefficients.data(), (int) step.coefficients.size());
+
+        step.saturatorGain = juce::Decibels::decibelsToGain(double(getSaturatorGainInDecibels(settings)));
+        step.saturate = settings.saturate;
+
+        return step;
+    }
+
+    //==============================================================================
+    // Designs the control steps ahead of the rendering thread into a single-producer
+    // single-consumer queue
+    template <typename Chain>
+    class DesignThread : public juce::Thread
+    {
+    public:
+        DesignThread(AutomationCurves& automationCurves, const SettingsMapping& settingsMapping,
+                     double rate, juce::int64 numSamples, int stepLength, int queueSize)
+            : juce::Thread("Design"), curves(automationCurves), mapping(settingsMapping),
+              sampleRate(rate), totalSamples(numSamples), controlStep(stepLength),
+              fifo(queueSize), steps((size_t) queueSize)
+        {
+            autoGain.prepare(sampleRate);
+        }
+
+        ~DesignThread() override
+        {
+            stopThread(1000);
+        }
+
+        void run() override
+        {
+            std::vector<float> values((size_t) curves.getNumParameters());
+
+            for( juce::int64 start = 0; start < totalSamples && ! threadShouldExit(); start += controlStep )
+            {
+                auto startTicks = juce::Time::getHighResolutionTicks();
+
+                // Each step ramps towards the design at its end, like the plugin's control ticks
+                auto end = juce::jmin(start + controlStep, totalSamples);
+                curves.getValues(double(end) / sampleRate, values.data());
+                auto step = designStep<Chain>(mapping.toChainSettings(values.data()), sampleRate, autoGain);
+
+                designSeconds += getSecondsSince(startTicks);
+                startTicks = juce::Time::getHighResolutionTicks();
+
+                while( fifo.getFreeSpace() == 0 )
+                {
+                    if( threadShouldExit() )
+                        return;
+
+                    juce::Thread::yield();
+                }
+
+                waitSeconds += getSecondsSince(startTicks);
+
+                fifo.write(1).forEach([this, &step](int index) { steps[(size_t) index] = step; });
+                ++numSteps;
+            }
+        }
+
+        // Rendering thread: the next step, waiting for it while the designs are behind
+        ControlStep<Chain> pop(double& waitSeconds)
+        {
+            auto startTicks = juce::Time::getHighResolutionTicks();
+
+            while( fifo.getNumReady() == 0 )
+                juce::Thread::yield();
+
+            waitSeconds += getSecondsSince(startTicks);
+
+            ControlStep<Chain> step;
+            fifo.read(1).forEach([this, &step](int index) { step = steps[(size_t) index]; });
+
+            return step;
+        }
+
+        // Read once the thread has finished
+        double designSeconds { 0 }, waitSeconds { 0 };
+        juce::int64 numSteps { 0 };
+
+    private:
+        AutomationCurves& curves;
+        const SettingsMapping& mapping;
+        double sampleRate;
+        juce::int64 totalSamples;
+        int controlStep;
+
+        AutoGain autoGain;
+
+        juce::AbstractFifo fifo;
+        std::vector<ControlStep<Chain>> steps;
+    };
+
+    //==============================================================================
+    template <typename Chain>
+    juce::String render(juce::AudioFormatReader& reader,
+                        juce::AudioFormatWriter::ThreadedWriter& writer,
+                        AutomationCurves& curves,
+                        const SettingsMapping& mapping,
+                        const RenderOptions& options,
+                        RenderStatistics& statistics)
+    {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        auto numChannels = (int) reader.numChannels;
+        auto sampleRate = reader.sampleRate;
+        auto numSamples = reader.lengthInSamples;
+        auto controlStep = juce::jmax(1, options.controlStep);
+        auto blockSize = juce::jmax(1, options.blockSize);
+
+        // The filter starts settled on the design at time 0, the design thread takes over from there
+        std::vector<float> values((size_t) curves.getNumParameters());
+        curves.getValues(0.0, values.data());
+
+        AutoGain autoGain;
+        autoGain.prepare(sampleRate);
+
+        auto initial = designStep<Chain>(mapping.toChainSettings(values.data()), sampleRate, autoGain);
+
+        Chain chain;
+        chain.setTarget(initial.coefficients, initial.chainGain, 0);
+
+        Saturator<double> saturator;
+        saturator.setGainLinear(initial.saturatorGain);
+        auto saturatorActive = initial.saturate;
+
+        DesignThread<Chain> designThread(curves, mapping, sampleRate, numSamples, controlStep, juce::jmax(2, options.queueSize));
+        designThread.startThread();
+
+        juce::AudioBuffer<float> block(numChannels, blockSize);
+        juce::AudioBuffer<double> samples(numChannels, blockSize);
+        int samplesLeftInStep = 0;
+
+        for( juce::int64 position = 0; position < numSamples; )
+        {
+            auto numBlockSamples = (int) juce::jmin((juce::int64) blockSize, numSamples - position);
+
+            auto ticks = juce::Time::getHighResolutionTicks();
+            reader.read(&block, 0, numBlockSamples, position, true, numChannels > 1);
+            statistics.readWaitSeconds += getSecondsSince(ticks);
+
+            ticks = juce::Time::getHighResolutionTicks();
+            double stepWaitSeconds = 0;
+
+            for( int ch = 0; ch < numChannels; ++ch )
+                for( int i = 0; i < numBlockSamples; ++i )
+                    samples.setSample(ch, i, double(block.getSample(ch, i)));
+
+            for( int offset = 0; offset < numBlockSamples; )
+            {
+                if( samplesLeftInStep == 0 )
+                {
+                    auto step = designThread.pop(stepWaitSeconds);
+                    samplesLeftInStep = (int) juce::jmin((juce::int64) controlStep, numSamples - (position + offset));
+
+                    chain.setTarget(step.coefficients, step.chainGain, samplesLeftInStep);
+
+                    // Like the plugin, switching the curve on starts it from silence and jumps its gain
+                    if( step.saturate != saturatorActive )
+                    {
+                        if( step.saturate )
+                            saturator.reset();
+
+                        saturator.setGainLinear(step.saturatorGain);
+                        saturatorActive = step.saturate;
+                    }
+                    else
+                    {
+                        saturator.setTarget(step.saturatorGain, samplesLeftInStep);
+                    }
+                }
+
+                auto numStepSamples = juce::jmin(samplesLeftInStep, numBlockSamples - offset);
+
+                double* channels[Chain::maxChannels] {};
+
+                for( int ch = 0; ch < numChannels; ++ch )
+                    channels[ch] = samples.getWritePointer(ch, offset);
+
+                chain.process(channels, numChannels, numStepSamples);
+
+                if( saturatorActive )
+                    saturator.process(channels, numChannels, numStepSamples);
+
+                offset += numStepSamples;
+                samplesLeftInStep -= numStepSamples;
+            }
+
+            for( int ch = 0; ch < numChannels; ++ch )
+                for( int i = 0; i < numBlockSamples; ++i )
+                    block.setSample(ch, i, float(samples.getSample(ch, i)));
+
+            statistics.stepWaitSeconds += stepWaitSeconds;
+            statistics.processSeconds += getSecondsSince(ticks) - stepWaitSeconds;
+
+            // The writer's thread drains its buffer to disk, so this only waits when the disk falls behind
+            ticks = juce::Time::getHighResolutionTicks();
+
+            while( ! writer.write(block.getArrayOfReadPointers(), numBlockSamples) )
+                juce::Thread::sleep(1);
+
+            statistics.writeWaitSeconds += getSecondsSince(ticks);
+
+            position += numBlockSamples;
+        }
+
+        designThread.waitForThreadToExit(-1);
+
+        statistics.numSamples = numSamples;
+        statistics.numSteps = designThread.numSteps;
+        statistics.designSeconds = designThread.designSeconds;
+        statistics.designWaitSeconds = designThread.waitSeconds;
+        statistics.seconds = getSecondsSince(startTicks);
+
+        return {};
+    }
+
+    template <template <int, typename> class Chain>
+    juce::String renderWithBands(int numPeaks, juce::AudioFormatReader& reader, juce::AudioFormatWriter::ThreadedWriter& writer,
+                                 AutomationCurves& curves, const SettingsMapping& mapping,
+                                 const RenderOptions& options, RenderStatistics& statistics)
+    {
+        switch( numPeaks )
+        {
+            case 4:  return render<Chain<4, double>>(reader, writer, curves, mapping, options, statistics);
+            case 8:  return render<Chain<8, double>>(reader, writer, curves, mapping, options, statistics);
+            default: return render<Chain<2, double>>(reader, writer, curves, mapping, options, statistics);
+        }
+    }
+}
+
+//==============================================================================
+juce::String renderWithAutomation(juce::AudioFormatReader& reader,
+                                  juce::AudioFormatWriter::ThreadedWriter& writer,
+                                  AutomationCurves& curves,
+                                  const RenderOptions& options,
+                                  RenderStatistics& statistics)
+{
+    if( reader.numChannels < 1 || reader.numChannels > (unsigned int) PeakChain<2>::maxChannels )
+        return "Only mono and stereo files are supported";
+
+    SettingsMapping mapping(curves);
+
+    // The band count picks the chain, so it holds for the whole render
+    std::vector<float> values((size_t) curves.getNumParameters());
+    curves.getValues(0.0, values.data());
+    auto numPeaks = mapping.toChainSettings(values.data()).numPeaks;
+
+    // The peak chain unless MORPH ever leaves 0, like the plugin's choice of core
+    auto& morphPoints = curves.getCurve(mapping.morph).points;
+    auto morphs = std::any_of(morphPoints.begin(), morphPoints.end(), [](auto& point) { return point.second > 0.f; });
+
+    if( morphs )
+        return renderWithBands<MorphChain>(numPeaks, reader, writer, curves, mapping, options, statistics);
+
+    return renderWithBands<PeakChain>(numPeaks, reader, writer, curves, mapping, options, statistics);
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    RenderPipeline.h
+
+    Renders a file through the filter in two stages. A design thread walks the
+    automation curves and designs the coefficients of every control step ahead
+    of the audio into a lock-free queue; the rendering thread only runs the
+    double precision kernels on them, like the plugin's high quality profile.
+    Reading and writing the files happen on two more threads behind buffers,
+    so neither stage waits for the disk.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "AutomationCurves.h"
+
+struct RenderOptions
+{
+    int controlStep { 1 };          // Samples per design, 1 is sample-accurate
+    int blockSize { 4096 };         // Samples per read, process and write
+    int queueSize { 1 << 14 };      // Control steps the design thread may run ahead
+};
+
+struct RenderStatistics
+{
+    juce::int64 numSamples { 0 }, numSteps { 0 };
+    double seconds { 0 };           // Wall clock, all stages overlapped
+    double designSeconds { 0 };     // Design thread, busy
+    double processSeconds { 0 };    // Rendering thread, busy in the kernels
+    double designWaitSeconds { 0 }; // Design thread waiting for room in the queue
+    double stepWaitSeconds { 0 };   // Rendering thread waiting for designs
+    double readWaitSeconds { 0 };   // Rendering thread waiting for the reader
+    double writeWaitSeconds { 0 };  // Rendering thread waiting for room in the writer's buffer
+};
+
+// Renders all of reader into writer. Returns an error message, or an empty string on success.
+// Bands are taken from the curves at time 0, automating them isn't supported.
+juce::String renderWithAutomation(juce::AudioFormatReader& reader,
+                                  juce::AudioFormatWriter::ThreadedWriter& writer,
+                                  AutomationCurves& curves,
+                                  const RenderOptions& options,
+                                  RenderStatistics& statistics);
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Fits FREQ, GAIN, QUAL, SPAN and BAL so that the peaks turn a reference
+    recording into a target recording, or follow a measured curve, and prints
+    the parameter values.
+
+        SimpleDualFilterPeakFit --reference a.wav --target b.wav
+        SimpleDualFilterPeakFit --curve response.txt [--sample-rate N]
+
+            [--bands 2|4|8] [--design bilinear|matched] [--starts N]
+            [--threads N] [--seed N] [--absolute]
+
+    BANDS and the design are not fitted, they are taken as given. --absolute
+    fits the curve's level as well instead of reporting the broadband
+    difference separately, which OUT G can then make up.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include "PeakFitter.h"
+#include "TargetCurve.h"
+
+static bool readAudioFile(juce::AudioFormatManager& formats, const juce::File& file,
+                          juce::AudioBuffer<float>& buffer, double& sampleRate)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+    if( reader == nullptr )
+        return false;
+
+    buffer.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+    reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    sampleRate = reader->sampleRate;
+
+    return true;
+}
+
+static int fail(const juce::String& message)
+{
+    std::fprintf(stderr, "%s\n", message.toRawUTF8());
+    return 1;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    auto readOption = [&args](const char* name, int defaultValue)
+    {
+        return args.containsOption(name) ? args.getValueForOption(name).getIntValue() : defaultValue;
+    };
+
+    FitTarget target;
+    double sampleRate = 48000.0;
+
+    if( args.containsOption("--curve") )
+    {
+        juce::String error;
+        target = TargetCurves::fromCurveFile(args.getFileForOption("--curve"), error);
+
+        if( error.isNotEmpty() )
+            return fail(error);
+
+        if( args.containsOption("--sample-rate") )
+            sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+    }
+    else if( args.containsOption("--reference") && args.containsOption("--target") )
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        juce::AudioBuffer<float> reference, recording;
+        double targetSampleRate = 0.0;
+
+        if( ! readAudioFile(formats, args.getFileForOption("--reference"), reference, sampleRate) )
+            return fail("Cannot read " + args.getValueForOption("--reference"));
+
+        if( ! readAudioFile(formats, args.getFileForOption("--target"), recording, targetSampleRate) )
+            return fail("Cannot read " + args.getValueForOption("--target"));
+
+        if( sampleRate != targetSampleRate )
+            return fail("The recordings have different sample rates");
+
+        target = TargetCurves::fromRecordings(reference, recording, sampleRate);
+    }
+    else
+    {
+        return fail("Usage: SimpleDualFilterPeakFit (--reference a.wav --target b.wav | --curve file [--sample-rate N])\n"
+                    "                               [--bands 2|4|8] [--design bilinear|matched] [--starts N]\n"
+                    "                               [--threads N] [--seed N] [--absolute]");
+    }
+
+    if( sampleRate <= 0.0 )
+        return fail("The sample rate must be positive");
+
+    ChainSettings base;
+    base.numPeaks = readOption("--bands", base.numPeaks);
+    base.design = args.getValueForOption("--design") == "matched" ? PeakDesign::matched : PeakDesign::bilinear;
+
+    if( std::find(std::begin(peakChainSizes), std::end(peakChainSizes), base.numPeaks) == std::end(peakChainSizes) )
+        return fail("--bands must be 2, 4 or 8");
+
+    FitOptions options;
+    options.numStarts = juce::jmax(1, readOption("--starts", options.numStarts));
+    options.numThreads = juce::jmax(1, readOption("--threads", juce::SystemStats::getNumCpus()));
+    options.seed = (std::uint32_t) readOption("--seed", (int) options.seed);
+    options.matchLevel = ! args.containsOption("--absolute");
+
+    auto result = fitPeaks(target, sampleRate, base, options);
+    auto& fitted = result.settings;
+
+    std::printf("Peak1 Freq     %8.0f Hz\n", fitted.peak1Freq);
+    std::printf("Peak1 Gain     %8.1f dB\n", fitted.peak1GainInDecibels);
+    std::printf("Peak1 Quality  %8.1f\n", fitted.peak1Quality);
+    std::printf("Span           %8.2f\n", fitted.span);
+    std::printf("Balance        %8.1f dB\n", fitted.balance);
+    std::printf("Bands          %8d\n", fitted.numPeaks);
+    std::printf("Peak Design    %8s\n", fitted.design == PeakDesign::matched ? "Matched" : "Bilinear");
+
+    if( options.matchLevel )
+        std::printf("Level offset   %8.1f dB\n", result.levelOffset);
+
+    std::printf("\nrms error %.2f dB over %d points, %d evaluations from %d starts on %d threads in %.0f ms\n",
+                result.rmsError, (int) target.frequencies.size(), result.numEvaluations,
+                options.numStarts, options.numThreads, result.seconds * 1000.0);
+
+    return 0;
+}
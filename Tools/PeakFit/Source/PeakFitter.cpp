@@ -0,0 +1,314 @@
+/*
+  ==============================================================================
+
+    PeakFitter.cpp
+
+  ==============================================================================
+*/
+
+#include "PeakFitter.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+namespace
+{
+    constexpr int numDimensions = 5;
+    using Point = std::array<double, numDimensions>;
+
+    // The ranges and intervals of createParameterLayout, log-scaled where the
+    // parameter's skew is
+    struct Dimension
+    {
+        double minimum, maximum, interval;
+        bool logarithmic;
+    };
+
+    constexpr Dimension dimensions[numDimensions]
+    {
+        { 20.0,  10000.0, 1.0,   true  },   // Peak1 Freq
+        { -24.0, 24.0,    0.1,   false },   // Peak1 Gain
+        { 0.1,   10.0,    0.1,   true  },   // Peak1 Quality
+        { 0.0,   10.0,    0.01,  false },   // Span
+        { -12.0, 12.0,    0.1,   false }    // Balance
+    };
+
+    double toValue(int dimension, double position) noexcept
+    {
+        auto& d = dimensions[dimension];
+        position = std::clamp(position, 0.0, 1.0);
+
+        return d.logarithmic ? d.minimum * std::pow(d.maximum / d.minimum, position)
+                             : d.minimum + (d.maximum - d.minimum) * position;
+    }
+
+    double toPosition(int dimension, double value) noexcept
+    {
+        auto& d = dimensions[dimension];
+        value = std::clamp(value, d.minimum, d.maximum);
+
+        return d.logarithmic ? std::log(value / d.minimum) / std::log(d.maximum / d.minimum)
+                             : (value - d.minimum) / (d.maximum - d.minimum);
+    }
+
+    ChainSettings toSettings(const Point& point, ChainSettings settings, bool snap) noexcept
+    {
+        float* fields[numDimensions] { &settings.peak1Freq, &settings.peak1GainInDecibels, &settings.peak1Quality,
+                                       &settings.span, &settings.balance };
+
+        for( int i = 0; i < numDimensions; ++i )
+        {
+            auto value = toValue(i, point[(size_t) i]);
+
+            if( snap )
+            {
+                auto& d = dimensions[i];
+                value = std::clamp(d.minimum + d.interval * std::round((value - d.minimum) / d.interval), d.minimum, d.maximum);
+            }
+
+            *fields[i] = float(value);
+        }
+
+        return settings;
+    }
+
+    //==============================================================================
+    // Owns the response buffers, one per thread
+    class Evaluator
+    {
+    public:
+        Evaluator(const FitTarget& fitTarget, double rate, const ChainSettings& baseSettings, bool shouldMatchLevel)
+            : target(fitTarget), sampleRate(rate), base(baseSettings), matchLevel(shouldMatchLevel),
+              magnitudes(fitTarget.frequencies.size())
+        {
+            for( auto w : target.weights )
+                totalWeight += w;
+        }
+
+        // Weighted mean square of the difference in dB, less its mean with matchLevel
+        double evaluate(const ChainSettings& settings, double* levelOffset = nullptr) noexcept
+        {
+            ++numEvaluations;
+
+            auto numPoints = (int) magnitudes.size();
+            computeChainResponse(settings, sampleRate, target.frequencies.data(), numPoints, magnitudes.data(), nullptr, nullptr);
+
+            double sum = 0, sumOfSquares = 0;
+
+            for( int i = 0; i < numPoints; ++i )
+            {
+                auto residual = target.decibels[(size_t) i] - 20.0 * std::log10(std::max(magnitudes[(size_t) i], 1.0e-12));
+                sum += target.weights[(size_t) i] * residual;
+                sumOfSquares += target.weights[(size_t) i] * residual * residual;
+            }
+
+            if( totalWeight <= 0 )
+                return 0;
+
+            auto mean = matchLevel ? sum / totalWeight : 0.0;
+
+            if( levelOffset != nullptr )
+                *levelOffset = mean;
+
+            return std::max(0.0, sumOfSquares / totalWeight - mean * mean);
+        }
+
+        double evaluate(const Point& point) noexcept
+        {
+            return evaluate(toSettings(point, base, false));
+        }
+
+        int numEvaluations { 0 };
+
+    private:
+        const FitTarget& target;
+        double sampleRate;
+        ChainSettings base;
+        bool matchLevel;
+        double totalWeight { 0 };
+        std::vector<double> magnitudes;
+    };
+
+    struct Candidate
+    {
+        Point point {};
+        double error { std::numeric_limits<double>::max() };
+    };
+
+    // Nelder-Mead with the usual coefficients, points projected into the unit box
+    Candidate minimise(Evaluator& evaluator, const Point& start, double initialStep, int maxEvaluations)
+    {
+        auto project = [](Point p)
+        {
+            for( auto& x : p )
+                x = std::clamp(x, 0.0, 1.0);
+
+            return p;
+        };
+
+        std::array<Candidate, numDimensions + 1> simplex;
+        simplex[0] = { project(start), 0 };
+
+        for( int i = 0; i < numDimensions; ++i )
+        {
+            auto p = simplex[0].point;
+            p[(size_t) i] += p[(size_t) i] + initialStep <= 1.0 ? initialStep : -initialStep;
+            simplex[(size_t) i + 1].point = project(p);
+        }
+
+        auto firstEvaluation = evaluator.numEvaluations;
+
+        for( auto& vertex : simplex )
+            vertex.error = evaluator.evaluate(vertex.point);
+
+        auto along = [](const Point& from, const Point& to, double t)
+        {
+            Point p;
+
+            for( size_t i = 0; i < p.size(); ++i )
+                p[i] = from[i] + t * (to[i] - from[i]);
+
+            return p;
+        };
+
+        while( evaluator.numEvaluations - firstEvaluation < maxEvaluations )
+        {
+            std::sort(simplex.begin(), simplex.end(), [](auto& a, auto& b) { return a.error < b.error; });
+
+            auto& best = simplex.front();
+            auto& worst = simplex.back();
+
+            if( worst.error - best.error < 1.0e-9 * (1.0 + best.error) )
+                break;
+
+            Point centroid {};
+
+            for( size_t v = 0; v < numDimensions; ++v )
+                for( size_t i = 0; i < centroid.size(); ++i )
+                    centroid[i] += simplex[v].point[i] / numDimensions;
+
+            auto reflected = project(along(centroid, worst.point, -1.0));
+            auto reflectedError = evaluator.evaluate(reflected);
+
+            if( reflectedError < best.error )
+            {
+                auto expanded = project(along(centroid, worst.point, -2.0));
+                auto expandedError = evaluator.evaluate(expanded);
+
+                worst = expandedError < reflectedError ? Candidate { expanded, expandedError }
+                                                       : Candidate { reflected, reflectedError };
+                continue;
+            }
+
+            if( reflectedError < simplex[numDimensions - 1].error )
+            {
+                worst = { reflected, reflectedError };
+                continue;
+            }
+
+            auto outside = reflectedError < worst.error;
+            auto contracted = project(along(centroid, outside ? reflected : worst.point, 0.5));
+            auto contractedError = evaluator.evaluate(contracted);
+
+            if( contractedError < (outside ? reflectedError : worst.error) )
+            {
+                worst = { contracted, contractedError };
+                continue;
+            }
+
+            // Shrink towards the best vertex
+            for( size_t v = 1; v < simplex.size(); ++v )
+            {
+                simplex[v].point = along(best.point, simplex[v].point, 0.5);
+                simplex[v].error = evaluator.evaluate(simplex[v].point);
+            }
+        }
+
+        return *std::min_element(simplex.begin(), simplex.end(), [](auto& a, auto& b) { return a.error < b.error; });
+    }
+
+    // The largest weighted deviation as one peak at unit quality, the rest spread over the box
+    std::vector<Point> makeStarts(const FitTarget& target, int numStarts, std::uint32_t seed)
+    {
+        std::vector<Point> starts;
+        starts.reserve((size_t) numStarts);
+
+        size_t peak = 0;
+
+        for( size_t i = 0; i < target.decibels.size(); ++i )
+            if( target.weights[i] * std::abs(target.decibels[i]) > target.weights[peak] * std::abs(target.decibels[peak]) )
+                peak = i;
+
+        if( ! target.isEmpty() )
+            starts.push_back({ toPosition(0, target.frequencies[peak]), toPosition(1, target.decibels[peak]),
+                               toPosition(2, 1.0), toPosition(3, 0.0), toPosition(4, 0.0) });
+
+        // Stratified in frequency, so the starts cover the spectrum however few there are
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        for( int i = (int) starts.size(); i < numStarts; ++i )
+        {
+            Point p;
+
+            for( auto& x : p )
+                x = uniform(random);
+
+            p[0] = (double(i) + uniform(random)) / double(numStarts);
+            starts.push_back(p);
+        }
+
+        return starts;
+    }
+}
+
+//==============================================================================
+FitResult fitPeaks(const FitTarget& target, double sampleRate, const ChainSettings& base, const FitOptions& options)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    auto starts = makeStarts(target, std::max(1, options.numStarts), options.seed);
+    std::vector<Candidate> results(starts.size());
+    std::atomic<int> nextStart { 0 };
+    std::atomic<int> numEvaluations { 0 };
+
+    // Each start's result only depends on the start, so the threads need not agree on an order
+    auto work = [&]
+    {
+        Evaluator evaluator(target, sampleRate, base, options.matchLevel);
+
+        for( int i; (i = nextStart.fetch_add(1)) < (int) starts.size(); )
+            results[(size_t) i] = minimise(evaluator, starts[(size_t) i], 0.1, options.maxEvaluationsPerStart);
+
+        numEvaluations += evaluator.numEvaluations;
+    };
+
+    std::vector<std::thread> threads;
+
+    for( int i = 1; i < std::min(options.numThreads, (int) starts.size()); ++i )
+        threads.emplace_back(work);
+
+    work();
+
+    for( auto& thread : threads )
+        thread.join();
+
+    auto best = *std::min_element(results.begin(), results.end(), [](auto& a, auto& b) { return a.error < b.error; });
+
+    // A restart from the best point with a fresh, small simplex refines it
+    Evaluator evaluator(target, sampleRate, base, options.matchLevel);
+    auto refined = minimise(evaluator, best.point, 0.01, options.maxEvaluationsPerStart);
+
+    if( refined.error < best.error )
+        best = refined;
+
+    FitResult result;
+    result.settings = toSettings(best.point, base, true);
+    result.rmsError = std::sqrt(evaluator.evaluate(result.settings, &result.levelOffset));
+    result.numEvaluations = numEvaluations + evaluator.numEvaluations;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    return result;
+}
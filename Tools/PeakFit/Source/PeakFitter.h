@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    PeakFitter.h
+
+    Fits FREQ, GAIN, QUAL, SPAN and BAL so that the magnitude response of the
+    peak chain matches a target curve in decibels, e.g. the spectral difference
+    between a reference and a target recording.
+
+    Nelder-Mead runs from many starts in the normalised parameter box, with
+    the starts spread over all cores. Each evaluation is one
+    computeChainResponse call over the target's points, whose section loops
+    vectorise. Only the standard library is used here.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../../../Source/FilterResponse.h"
+
+// Target magnitudes in decibels at log-spaced frequencies, with a weight per point
+struct FitTarget
+{
+    std::vector<double> frequencies, decibels, weights;
+
+    bool isEmpty() const noexcept { return frequencies.empty(); }
+};
+
+struct FitOptions
+{
+    int numStarts { 64 };
+    int numThreads { int(std::max(1u, std::thread::hardware_concurrency())) };
+    int maxEvaluationsPerStart { 800 };
+    bool matchLevel { true };       // Ignore a broadband level difference, see FitResult::levelOffset
+    std::uint32_t seed { 1 };
+};
+
+struct FitResult
+{
+    ChainSettings settings;         // Snapped to the parameters' intervals
+    double rmsError { 0 };          // Weighted RMS of the remaining difference, in dB
+    double levelOffset { 0 };       // dB the target sits above the fitted chain, 0 without matchLevel
+    int numEvaluations { 0 };
+    double seconds { 0 };
+};
+
+// Everything that isn't fitted (bands, design, output gain) comes from base.
+// The result is the same for any number of threads.
+FitResult fitPeaks(const FitTarget& target, double sampleRate, const ChainSettings& base, const FitOptions& options = {});
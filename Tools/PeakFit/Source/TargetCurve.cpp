@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    TargetCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "TargetCurve.h"
+
+namespace
+{
+    // Mean power per FFT bin over all windows and channels
+    std::vector<double> computeAveragePower(const juce::AudioBuffer<float>& buffer, int fftOrder)
+    {
+        auto fftSize = 1 << fftOrder;
+        auto hopSize = fftSize / 2;
+
+        juce::dsp::FFT fft(fftOrder);
+        juce::dsp::WindowingFunction<float> window((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+
+        std::vector<float> frame((size_t) fftSize * 2);
+        std::vector<double> power((size_t) fftSize / 2 + 1, 0.0);
+        int numFrames = 0;
+
+        for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+        {
+            for( int start = 0; start + fftSize <= buffer.getNumSamples(); start += hopSize )
+            {
+                std::fill(frame.begin(), frame.end(), 0.f);
+                std::copy_n(buffer.getReadPointer(ch, start), fftSize, frame.begin());
+
+                window.multiplyWithWindowingTable(frame.data(), (size_t) fftSize);
+                fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+                for( size_t bin = 0; bin < power.size(); ++bin )
+                    power[bin] += double(frame[bin]) * double(frame[bin]);
+
+                ++numFrames;
+            }
+        }
+
+        for( auto& p : power )
+            p /= juce::jmax(1, numFrames);
+
+        return power;
+    }
+
+    // Mean power of the bins within a sixth of an octave of the frequency
+    double getBandPower(const std::vector<double>& power, double frequency, double binWidth)
+    {
+        constexpr double halfBandwidth = 1.0 / 12.0;     // In octaves
+
+        auto lastBin = (int) power.size() - 1;
+        auto low = juce::jlimit(1, lastBin, (int) std::floor(frequency * std::exp2(-halfBandwidth) / binWidth));
+        auto high = juce::jlimit(low, lastBin, (int) std::ceil(frequency * std::exp2(halfBandwidth) / binWidth));
+
+        double sum = 0;
+
+        for( int bin = low; bin <= high; ++bin )
+            sum += power[(size_t) bin];
+
+        return sum / double(high - low + 1);
+    }
+}
+
+//==============================================================================
+FitTarget TargetCurves::fromRecordings(const juce::AudioBuffer<float>& reference,
+                                       const juce::AudioBuffer<float>& target,
+                                       double sampleRate,
+                                       int numPoints,
+                                       int fftOrder)
+{
+    auto referencePower = computeAveragePower(reference, fftOrder);
+    auto targetPower = computeAveragePower(target, fftOrder);
+
+    auto binWidth = sampleRate / double(1 << fftOrder);
+    auto lowest = 20.0;
+    auto highest = juce::jmin(20000.0, 0.45 * sampleRate);
+
+    FitTarget curve;
+    std::vector<double> referenceBands;
+
+    for( int i = 0; i < numPoints; ++i )
+    {
+        auto frequency = lowest * std::pow(highest / lowest, double(i) / double(juce::jmax(1, numPoints - 1)));
+        auto referenceBand = getBandPower(referencePower, frequency, binWidth);
+        auto targetBand = getBandPower(targetPower, frequency, binWidth);
+
+        curve.frequencies.push_back(frequency);
+        curve.decibels.push_back(10.0 * std::log10(juce::jmax(targetBand, 1.0e-30) / juce::jmax(referenceBand, 1.0e-30)));
+        referenceBands.push_back(referenceBand);
+    }
+
+    auto loudest = referenceBands.empty() ? 0.0 : *std::max_element(referenceBands.begin(), referenceBands.end());
+
+    for( auto band : referenceBands )
+        curve.weights.push_back(band > 1.0e-6 * loudest && band > 0.0 ? 1.0 : 0.0);
+
+    return curve;
+}
+
+FitTarget TargetCurves::fromCurveFile(const juce::File& file, juce::String& error)
+{
+    FitTarget curve;
+
+    if( ! file.existsAsFile() )
+    {
+        error = "Cannot read " + file.getFullPathName();
+        return curve;
+    }
+
+    juce::StringArray lines;
+    file.readLines(lines);
+
+    for( int i = 0; i < lines.size(); ++i )
+    {
+        auto line = lines[i].upToFirstOccurrenceOf("#", false, false).trim();
+
+        if( line.isEmpty() )
+            continue;
+
+        auto tokens = juce::StringArray::fromTokens(line, " \t,", "");
+        tokens.removeEmptyStrings();
+
+        if( tokens.size() < 2 || tokens[0].getDoubleValue() <= 0.0 )
+        {
+            error = file.getFileName() + ":" + juce::String(i + 1) + ": expected a frequency and a level in dB";
+            return {};
+        }
+
+        curve.frequencies.push_back(tokens[0].getDoubleValue());
+        curve.decibels.push_back(tokens[1].getDoubleValue());
+        curve.weights.push_back(1.0);
+    }
+
+    if( curve.isEmpty() )
+        error = file.getFileName() + " has no points";
+
+    return curve;
+}
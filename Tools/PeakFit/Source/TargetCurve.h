@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    TargetCurve.h
+
+    Builds the curve PeakFitter matches, either from a reference and a target
+    recording or from a measured response in a text file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "PeakFitter.h"
+
+namespace TargetCurves
+{
+    // The target's level over the reference's in decibels, from Welch averaged
+    // power spectra (Hann windows, half overlap, channels summed) smoothed over
+    // a sixth of an octave around numPoints log-spaced frequencies from 20 Hz to
+    // 20 kHz or 0.45 times the sample rate. Points where the reference is more
+    // than 60 dB below its loudest band get no weight.
+    FitTarget fromRecordings(const juce::AudioBuffer<float>& reference,
+                             const juce::AudioBuffer<float>& target,
+                             double sampleRate,
+                             int numPoints = 96,
+                             int fftOrder = 13);
+
+    // One "frequency decibels" pair per line, separated by spaces, tabs or a
+    // comma; '#' starts a comment. Points are used as given, with equal weight.
+    FitTarget fromCurveFile(const juce::File& file, juce::String& error);
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs SimpleDualFilterAudioProcessor as a headless daemon that serves audio
+    streams from other processes over shared memory, or the local test client
+    that drives it.
+
+        SimpleDualFilterStreamDaemon daemon [--name N] [--workers N] [--offline]
+        SimpleDualFilterStreamDaemon client [--name N] [--streams N] [--seconds N]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include <csignal>
+
+#include "StreamDaemon.h"
+#include "TestClient.h"
+
+static std::atomic<bool> shouldQuit { false };
+
+static void handleSignal(int)
+{
+    shouldQuit = true;
+}
+
+static int runDaemon(const juce::ArgumentList& args)
+{
+    StreamDaemon::Options options;
+    options.name = args.getValueForOption("--name");
+
+    if( options.name.isEmpty() )
+        options.name = StreamProtocol::defaultName;
+
+    if( args.containsOption("--workers") )
+        options.numWorkers = args.getValueForOption("--workers").getIntValue();
+
+    options.nonRealtime = args.containsOption("--offline");
+
+    StreamDaemon daemon(options);
+
+    if( ! daemon.isRunning() )
+    {
+        std::printf("Could not create %s\n", options.name.toRawUTF8());
+        return 1;
+    }
+
+    std::printf("Serving %s, Ctrl-C to stop\n", options.name.toRawUTF8());
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    while( ! shouldQuit )
+    {
+        daemon.beat();
+        juce::Thread::sleep(100);
+    }
+
+    return 0;
+}
+
+static int runClient(const juce::ArgumentList& args)
+{
+    TestClientOptions options;
+    options.name = args.getValueForOption("--name");
+
+    if( options.name.isEmpty() )
+        options.name = StreamProtocol::defaultName;
+
+    if( args.containsOption("--streams") )
+        options.numStreams = args.getValueForOption("--streams").getIntValue();
+
+    if( args.containsOption("--seconds") )
+        options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    return runTestClient(options);
+}
+
+int main(int argc, char* argv[])
+{
+    // The parameter tree needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+
+    auto command = args.size() > 0 ? args[0].text : juce::String();
+
+    if( command == "daemon" )
+        return runDaemon(args);
+
+    if( command == "client" )
+        return runClient(args);
+
+    std::printf("usage: %s daemon [--name N] [--workers N] [--offline]\n"
+                "       %s client [--name N] [--streams N] [--seconds N]\n",
+                args.executableName.toRawUTF8(), args.executableName.toRawUTF8());
+    return 1;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    SharedMemory.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedMemory.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static void* mapRegion(const juce::String& name, size_t size, bool create)
+{
+    auto flags = create ? O_CREAT | O_RDWR : O_RDWR;
+    auto fd = shm_open(name.toRawUTF8(), flags, 0600);
+
+    if( fd < 0 )
+        return nullptr;
+
+    if( create && ftruncate(fd, (off_t) size) != 0 )
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    auto* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return data == MAP_FAILED ? nullptr : data;
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::create(const juce::String& name, size_t size)
+{
+    // A daemon that crashed leaves its region behind
+    shm_unlink(name.toRawUTF8());
+
+    if( auto* data = mapRegion(name, size, true) )
+        return std::unique_ptr<SharedMemory>(new SharedMemory(name, data, size, true));
+
+    return nullptr;
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::open(const juce::String& name, size_t size)
+{
+    if( auto* data = mapRegion(name, size, false) )
+        return std::unique_ptr<SharedMemory>(new SharedMemory(name, data, size, false));
+
+    return nullptr;
+}
+
+SharedMemory::SharedMemory(const juce::String& regionName, void* regionData, size_t regionSize, bool isOwner)
+    : name(regionName), data(regionData), size(regionSize), owner(isOwner)
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+    munmap(data, size);
+
+    if( owner )
+        shm_unlink(name.toRawUTF8());
+}
@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    SharedMemory.h
+
+    A named POSIX shared memory region, mapped for reading and writing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class SharedMemory
+{
+public:
+    // Creates the region, replacing a stale one of the same name. The creator
+    // removes the name again when the region is destroyed.
+    static std::unique_ptr<SharedMemory> create(const juce::String& name, size_t size);
+
+    // Maps a region created by another process, nullptr if there is none
+    static std::unique_ptr<SharedMemory> open(const juce::String& name, size_t size);
+
+    ~SharedMemory();
+
+    void* getData() const noexcept { return data; }
+    size_t getSize() const noexcept { return size; }
+
+private:
+    SharedMemory(const juce::String& name, void* data, size_t size, bool owner);
+
+    juce::String name;
+    void* data { nullptr };
+    size_t size { 0 };
+    bool owner { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemory)
+};
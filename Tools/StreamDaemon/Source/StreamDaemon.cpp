@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    StreamDaemon.cpp
+
+  ==============================================================================
+*/
+
+#include "StreamDaemon.h"
+
+using namespace StreamProtocol;
+
+class StreamDaemon::Worker : public juce::Thread
+{
+public:
+    Worker(SharedArea& sharedArea, int index, int numWorkers, bool renderNonRealtime)
+        : juce::Thread("Stream Worker " + juce::String(index)),
+          area(sharedArea), workerIndex(index), workerCount(numWorkers), nonRealtime(renderNonRealtime)
+    {
+    }
+
+    ~Worker() override
+    {
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        while( ! threadShouldExit() )
+        {
+            bool didWork = false;
+
+            for( int slot = workerIndex; slot < maxStreams; slot += workerCount )
+                didWork = serviceSlot(slot) || didWork;
+
+            // Nothing to do: back off briefly instead of spinning
+            if( ! didWork )
+                wait(1);
+        }
+
+        for( auto& stream : streams )
+            stream.processor.reset();
+    }
+
+private:
+    // Daemon side of one slot, only ever touched by the worker that owns the slot
+    struct Stream
+    {
+        std::unique_ptr<SimpleDualFilterAudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        int numChannels { 0 };
+        int blockSize { 0 };
+    };
+
+    SharedArea& area;
+    const int workerIndex, workerCount;
+    const bool nonRealtime;
+
+    std::array<Stream, maxStreams> streams;
+
+    bool serviceSlot(int index)
+    {
+        auto& slot = area.slots[index];
+        auto& stream = streams[(size_t) index];
+
+        auto state = slot.state.load(std::memory_order_acquire);
+
+        if( state == slotClosing )
+        {
+            stream.processor.reset();
+
+            slot.input.clear();
+            slot.output.clear();
+            slot.control.clear();
+            slot.state.store(slotFree, std::memory_order_release);
+            return true;
+        }
+
+        if( state != slotOpen )
+            return false;
+
+        if( stream.processor == nullptr )
+            openStream(slot, stream);
+
+        applyParameterChanges(slot, stream);
+
+        // A few blocks per visit, so one busy stream can't starve the others
+        int numBlocks = 0;
+
+        while( numBlocks < 4
+              && slot.input.getNumReady() >= (uint32_t) stream.blockSize
+              && slot.output.getNumFree() >= (uint32_t) stream.blockSize )
+        {
+            slot.input.read(stream.buffer.getArrayOfWritePointers(), stream.numChannels, stream.blockSize);
+            stream.processor->processBlock(stream.buffer, stream.midi);
+            slot.output.write(stream.buffer.getArrayOfReadPointers(), stream.numChannels, stream.blockSize);
+
+            ++numBlocks;
+        }
+
+        return numBlocks > 0;
+    }
+
+    void openStream(StreamSlot& slot, Stream& stream)
+    {
+        auto sampleRate = double(juce::jlimit(8000u, 384000u, slot.sampleRate));
+        stream.numChannels = (int) juce::jlimit(1u, (uint32_t) maxChannels, slot.numChannels);
+        stream.blockSize = (int) juce::jlimit(1u, (uint32_t) maxBlockSize, slot.blockSize);
+
+        stream.processor = std::make_unique<SimpleDualFilterAudioProcessor>();
+        stream.processor->setNonRealtime(nonRealtime);
+        stream.processor->setPlayConfigDetails(stream.numChannels, stream.numChannels, sampleRate, stream.blockSize);
+        stream.processor->prepareToPlay(sampleRate, stream.blockSize);
+
+        stream.buffer.setSize(stream.numChannels, stream.blockSize);
+    }
+
+    void applyParameterChanges(StreamSlot& slot, Stream& stream)
+    {
+        ParameterChange change;
+
+        while( slot.control.pop(change) )
+        {
+            if( auto* param = stream.processor->apvts.getParameter(change.parameterId) )
+                param->setValueNotifyingHost(param->convertTo0to1(change.value));
+            else
+                DBG("Unknown parameter " << change.parameterId);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+StreamDaemon::StreamDaemon(const Options& daemonOptions) : options(daemonOptions)
+{
+    memory = SharedMemory::create(options.name, sizeof(SharedArea));
+
+    if( memory == nullptr )
+        return;
+
+    area = new (memory->getData()) SharedArea();
+
+    auto numWorkers = juce::jlimit(1, maxStreams, options.numWorkers);
+    auto numCpus = juce::jmax(1, juce::SystemStats::getNumCpus());
+
+    for( int i = 0; i < numWorkers; ++i )
+    {
+        auto* worker = workers.add(new Worker(*area, i, numWorkers, options.nonRealtime));
+
+        // Leave core 0 to the system when there are enough cores
+        auto core = numCpus > numWorkers ? (i + 1) % numCpus : i % numCpus;
+        worker->setAffinityMask((juce::uint32) 1 << juce::jmin(core, 31));
+        worker->startThread();
+    }
+}
+
+StreamDaemon::~StreamDaemon()
+{
+    // The workers release their processors before the area goes away
+    workers.clear();
+
+    if( area != nullptr )
+        area->~SharedArea();
+}
+
+void StreamDaemon::beat() noexcept
+{
+    if( area != nullptr )
+        area->heartbeat.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    StreamDaemon.h
+
+    Serves the streams of a StreamProtocol::SharedArea. Every slot belongs to
+    one worker thread, slot i to worker i % numWorkers, so the workers never
+    share a processor and need no locks. Each worker is pinned to one core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/PluginProcessor.h"
+#include "SharedMemory.h"
+#include "StreamProtocol.h"
+
+class StreamDaemon
+{
+public:
+    struct Options
+    {
+        juce::String name { StreamProtocol::defaultName };
+        int numWorkers { juce::jmax(1, juce::SystemStats::getNumCpus() - 1) };
+        bool nonRealtime { false };     // Render with the high quality profile
+    };
+
+    explicit StreamDaemon(const Options& options);
+    ~StreamDaemon();
+
+    // False if the shared memory could not be created
+    bool isRunning() const noexcept { return area != nullptr; }
+
+    // Call regularly from the main thread
+    void beat() noexcept;
+
+private:
+    class Worker;
+
+    Options options;
+    std::unique_ptr<SharedMemory> memory;
+    StreamProtocol::SharedArea* area { nullptr };
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamDaemon)
+};
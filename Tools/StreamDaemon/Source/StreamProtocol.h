@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    StreamProtocol.h
+
+    Layout of the shared memory area between the stream daemon and its
+    clients. Each stream slot holds two single-producer single-consumer audio
+    rings (client to daemon and back) and a ring of parameter changes. All
+    positions are free-running frame counters in lock-free atomics, so both
+    processes exchange audio without locks or system calls.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace StreamProtocol
+{
+    constexpr uint32_t magicNumber = 0x53464453; // "SDFS"
+    constexpr uint32_t currentVersion = 1;
+
+    constexpr const char* defaultName = "/simpledualfilter";
+
+    constexpr int maxStreams = 64;
+    constexpr int maxChannels = 2;
+    constexpr int maxBlockSize = 4096;
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "The rings need address-free atomics");
+
+    //==============================================================================
+    // Interleaved frames with maxChannels samples each, unused channels are left alone
+    template <uint32_t CapacityInFrames>
+    struct AudioRing
+    {
+        static_assert((CapacityInFrames & (CapacityInFrames - 1)) == 0, "Capacity must be a power of two");
+
+        static constexpr uint32_t capacity = CapacityInFrames;
+
+        std::atomic<uint32_t> writePosition { 0 };    // Only the producer stores
+        std::atomic<uint32_t> readPosition { 0 };     // Only the consumer stores
+        float samples[CapacityInFrames * maxChannels];
+
+        uint32_t getNumReady() const noexcept
+        {
+            return writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_relaxed);
+        }
+
+        uint32_t getNumFree() const noexcept
+        {
+            return capacity - (writePosition.load(std::memory_order_relaxed) - readPosition.load(std::memory_order_acquire));
+        }
+
+        // Producer: writes up to numFrames and returns how many fitted
+        int write(const float* const* channels, int numChannels, int numFrames) noexcept
+        {
+            auto position = writePosition.load(std::memory_order_relaxed);
+            auto n = (int) std::min<uint32_t>((uint32_t) numFrames, getNumFree());
+
+            for( int i = 0; i < n; ++i )
+            {
+                auto* frame = samples + ((position + (uint32_t) i) & (capacity - 1)) * maxChannels;
+
+                for( int ch = 0; ch < numChannels; ++ch )
+                    frame[ch] = channels[ch][i];
+            }
+
+            writePosition.store(position + (uint32_t) n, std::memory_order_release);
+            return n;
+        }
+
+        // Consumer: reads up to numFrames and returns how many were ready
+        int read(float* const* channels, int numChannels, int numFrames) noexcept
+        {
+            auto position = readPosition.load(std::memory_order_relaxed);
+            auto n = (int) std::min<uint32_t>((uint32_t) numFrames, getNumReady());
+
+            for( int i = 0; i < n; ++i )
+            {
+                const auto* frame = samples + ((position + (uint32_t) i) & (capacity - 1)) * maxChannels;
+
+                for( int ch = 0; ch < numChannels; ++ch )
+                    channels[ch][i] = frame[ch];
+            }
+
+            readPosition.store(position + (uint32_t) n, std::memory_order_release);
+            return n;
+        }
+
+        // Only while neither side uses the ring
+        void clear() noexcept
+        {
+            writePosition.store(0, std::memory_order_relaxed);
+            readPosition.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    //==============================================================================
+    // A parameter of SimpleDualFilterAudioProcessor, by ID, in its real units
+    struct ParameterChange
+    {
+        char parameterId[32] {};
+        float value { 0.f };
+
+        void setParameterId(const char* id) noexcept
+        {
+            std::strncpy(parameterId, id, sizeof(parameterId) - 1);
+            parameterId[sizeof(parameterId) - 1] = 0;
+        }
+    };
+
+    struct ControlRing
+    {
+        static constexpr uint32_t capacity = 256;
+
+        std::atomic<uint32_t> writePosition { 0 };
+        std::atomic<uint32_t> readPosition { 0 };
+        ParameterChange changes[capacity];
+
+        // Client
+        bool push(const ParameterChange& change) noexcept
+        {
+            auto position = writePosition.load(std::memory_order_relaxed);
+
+            if( position - readPosition.load(std::memory_order_acquire) >= capacity )
+                return false;
+
+            changes[position & (capacity - 1)] = change;
+            writePosition.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Daemon
+        bool pop(ParameterChange& change) noexcept
+        {
+            auto position = readPosition.load(std::memory_order_relaxed);
+
+            if( position == writePosition.load(std::memory_order_acquire) )
+                return false;
+
+            change = changes[position & (capacity - 1)];
+            readPosition.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        void clear() noexcept
+        {
+            writePosition.store(0, std::memory_order_relaxed);
+            readPosition.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    //==============================================================================
+    enum SlotState : uint32_t
+    {
+        slotFree,       // Claimed by a client with a compare-and-swap to slotOpening
+        slotOpening,    // The client fills in the format, then publishes slotOpen
+        slotOpen,       // The daemon processes the stream
+        slotClosing     // Set by the client, the daemon releases the stream and frees the slot
+    };
+
+    struct StreamSlot
+    {
+        std::atomic<uint32_t> state { slotFree };
+
+        // Written by the client while opening
+        uint32_t sampleRate { 48000 };
+        uint32_t numChannels { 2 };
+        uint32_t blockSize { 256 };
+
+        AudioRing<8192> input;      // Client to daemon
+        AudioRing<8192> output;     // Daemon to client
+        ControlRing control;        // Client to daemon
+    };
+
+    struct SharedArea
+    {
+        uint32_t magic { magicNumber };
+        uint32_t version { currentVersion };
+
+        // Counts up while the daemon runs, so clients can tell a stale area
+        std::atomic<uint32_t> heartbeat { 0 };
+
+        StreamSlot slots[maxStreams];
+    };
+}
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    TestClient.cpp
+
+  ==============================================================================
+*/
+
+#include "TestClient.h"
+#include "SharedMemory.h"
+#include "StreamProtocol.h"
+
+using namespace StreamProtocol;
+
+static StreamSlot* claimSlot(SharedArea& area)
+{
+    for( auto& slot : area.slots )
+    {
+        uint32_t expected = slotFree;
+
+        if( slot.state.compare_exchange_strong(expected, slotOpening, std::memory_order_acq_rel) )
+            return &slot;
+    }
+
+    return nullptr;
+}
+
+static void pushParameter(StreamSlot& slot, const char* parameterId, float value)
+{
+    ParameterChange change;
+    change.setParameterId(parameterId);
+    change.value = value;
+
+    auto pushed = slot.control.push(change);
+    jassert(pushed);
+    juce::ignoreUnused(pushed);
+}
+
+int runTestClient(const TestClientOptions& options)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr double toneFrequency = 1000.0;
+    constexpr double settleSeconds = 0.5;
+
+    auto memory = SharedMemory::open(options.name, sizeof(SharedArea));
+
+    if( memory == nullptr )
+    {
+        std::printf("No daemon is serving %s\n", options.name.toRawUTF8());
+        return 1;
+    }
+
+    auto& area = *static_cast<SharedArea*>(memory->getData());
+
+    if( area.magic != magicNumber || area.version != currentVersion )
+    {
+        std::printf("%s was created by an incompatible daemon\n", options.name.toRawUTF8());
+        return 1;
+    }
+
+    auto blockSize = juce::jlimit(1, maxBlockSize, options.blockSize);
+    juce::Array<StreamSlot*> slots;
+
+    for( int i = 0; i < options.numStreams; ++i )
+    {
+        auto* slot = claimSlot(area);
+
+        if( slot == nullptr )
+            break;
+
+        slot->sampleRate = (uint32_t) sampleRate;
+        slot->numChannels = 2;
+        slot->blockSize = (uint32_t) blockSize;
+
+        // Queued before the stream opens, so the first block already uses them
+        pushParameter(*slot, "Peak1 Freq", (float) toneFrequency);
+        pushParameter(*slot, "Peak1 Gain", 12.f);
+        pushParameter(*slot, "Peak1 Quality", 1.f);
+
+        slot->state.store(slotOpen, std::memory_order_release);
+        slots.add(slot);
+    }
+
+    std::printf("Opened %d streams on %s\n", slots.size(), options.name.toRawUTF8());
+
+    auto totalFrames = (int64_t) (options.seconds * sampleRate);
+    auto settleFrames = (int64_t) (settleSeconds * sampleRate);
+
+    struct Progress
+    {
+        int64_t framesSent { 0 }, framesReceived { 0 };
+        double inputSquares { 0 }, outputSquares { 0 };
+    };
+
+    std::vector<Progress> progress((size_t) slots.size());
+    juce::AudioBuffer<float> buffer(2, blockSize);
+
+    auto lastHeartbeat = area.heartbeat.load();
+    auto lastHeartbeatTime = juce::Time::getMillisecondCounter();
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for( bool done = false; ! done; )
+    {
+        done = true;
+        bool didWork = false;
+
+        for( int s = 0; s < slots.size(); ++s )
+        {
+            auto& slot = *slots.getUnchecked(s);
+            auto& p = progress[(size_t) s];
+
+            if( p.framesSent < totalFrames && slot.input.getNumFree() >= (uint32_t) blockSize )
+            {
+                for( int i = 0; i < blockSize; ++i )
+                {
+                    auto phase = juce::MathConstants<double>::twoPi * toneFrequency * double(p.framesSent + i) / sampleRate;
+                    auto sample = float(0.1 * std::sin(phase));
+                    buffer.setSample(0, i, sample);
+                    buffer.setSample(1, i, sample);
+
+                    if( p.framesSent + i >= settleFrames )
+                        p.inputSquares += sample * sample;
+                }
+
+                p.framesSent += slot.input.write(buffer.getArrayOfReadPointers(), 2, blockSize);
+                didWork = true;
+            }
+
+            auto received = slot.output.read(buffer.getArrayOfWritePointers(), 2, blockSize);
+
+            for( int i = 0; i < received; ++i )
+                if( p.framesReceived + i >= settleFrames )
+                    p.outputSquares += buffer.getSample(0, i) * buffer.getSample(0, i);
+
+            p.framesReceived += received;
+            didWork = didWork || received > 0;
+
+            // The daemon only processes whole blocks, the tail shorter than one never returns
+            done = done && p.framesReceived + blockSize > totalFrames;
+        }
+
+        if( ! didWork )
+        {
+            auto heartbeat = area.heartbeat.load();
+            auto now = juce::Time::getMillisecondCounter();
+
+            if( heartbeat != lastHeartbeat )
+            {
+                lastHeartbeat = heartbeat;
+                lastHeartbeatTime = now;
+            }
+            else if( now - lastHeartbeatTime > 2000 )
+            {
+                std::printf("The daemon stopped responding\n");
+                break;
+            }
+
+            juce::Thread::yield();
+        }
+    }
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    int failures = 0;
+
+    for( int s = 0; s < slots.size(); ++s )
+    {
+        auto& p = progress[(size_t) s];
+        auto gainInDecibels = juce::Decibels::gainToDecibels(std::sqrt(p.outputSquares / juce::jmax(1.0e-12, p.inputSquares)));
+
+        // The tone sits on the peak, so it should come back 12 dB louder
+        auto ok = std::abs(gainInDecibels - 12.0) < 0.5;
+        failures += ok ? 0 : 1;
+
+        std::printf("stream %2d: %lld frames, gain %+.2f dB %s\n", s, (long long) p.framesReceived, gainInDecibels, ok ? "ok" : "FAILED");
+    }
+
+    auto framesPerSecond = double(totalFrames) * slots.size() / juce::jmax(1.0e-9, seconds);
+    std::printf("%.1f x real time over %d streams\n", framesPerSecond / sampleRate, slots.size());
+
+    for( auto* slot : slots )
+        slot->state.store(slotClosing, std::memory_order_release);
+
+    return failures == 0 && ! slots.isEmpty() ? 0 : 1;
+}
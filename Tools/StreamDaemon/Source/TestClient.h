@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+    TestClient.h
+
+    Local client for the stream daemon: opens a number of streams, sets a
+    +12 dB peak at 1 kHz on each, pushes a 1 kHz tone through them as fast as
+    the daemon returns it, and checks the gain and the throughput.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct TestClientOptions
+{
+    juce::String name;
+    int numStreams { 4 };
+    double seconds { 10.0 };
+    int blockSize { 256 };
+};
+
+// Returns the process exit code
+int runTestClient(const TestClientOptions& options);
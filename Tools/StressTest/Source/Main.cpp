@@ -0,0 +1,340 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Drives SimpleDualFilterAudioProcessor::processBlock like a hostile host for
+    as long as asked: random block sizes, sample rate, block mode, peak engine
+    and offline changes through prepareToPlay, every parameter automated at
+    every callback, and getStateInformation/setStateInformation from a second
+    thread. Reports the distribution of the time per callback and every
+    callback that took longer than the deadline.
+
+        SimpleDualFilterStressTest [--seconds N] [--deadline-us N | --deadline-ratio R]
+                                   [--session-seconds N] [--seed N]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include <csignal>
+
+#include "../../../Source/PluginProcessor.h"
+
+static std::atomic<bool> shouldQuit { false };
+
+static void handleSignal(int)
+{
+    shouldQuit = true;
+}
+
+struct StressOptions
+{
+    double seconds { 3600.0 };
+    double deadlineMicroseconds { 0.0 };    // 0: a proportion of the block's duration
+    double deadlineRatio { 1.0 };
+    double sessionSeconds { 10.0 };         // Audio time between two prepareToPlay calls
+    juce::int64 seed { 0 };
+};
+
+//==============================================================================
+// Callback durations in steps of 0.1 microseconds up to 100 ms, so percentiles
+// stay exact over hours without keeping every sample
+class DurationHistogram
+{
+public:
+    static constexpr double resolutionInMicroseconds = 0.1;
+    static constexpr int numBuckets = 1000000;
+
+    DurationHistogram() : counts((size_t) numBuckets + 1, 0) {}
+
+    void add(double microseconds) noexcept
+    {
+        auto bucket = juce::jlimit(0, numBuckets, int(microseconds / resolutionInMicroseconds));
+        ++counts[(size_t) bucket];
+        ++total;
+        maximum = juce::jmax(maximum, microseconds);
+    }
+
+    juce::uint64 getCount() const noexcept { return total; }
+    double getMaximum() const noexcept { return maximum; }
+
+    double getPercentile(double percentile) const noexcept
+    {
+        auto rank = juce::uint64(std::ceil(percentile / 100.0 * double(total)));
+        juce::uint64 seen = 0;
+
+        for( int bucket = 0; bucket <= numBuckets; ++bucket )
+        {
+            seen += counts[(size_t) bucket];
+
+            if( seen >= rank && seen > 0 )
+                return bucket == numBuckets ? maximum : (bucket + 1) * resolutionInMicroseconds;
+        }
+
+        return maximum;
+    }
+
+private:
+    std::vector<juce::uint64> counts;
+    juce::uint64 total { 0 };
+    double maximum { 0.0 };
+};
+
+//==============================================================================
+// Saves and restores the plugin state at random intervals while the audio runs
+class StateThread : public juce::Thread
+{
+public:
+    StateThread(SimpleDualFilterAudioProcessor& p, juce::int64 seed)
+        : juce::Thread("State"), processor(p), random(seed)
+    {
+    }
+
+    ~StateThread() override
+    {
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        juce::MemoryBlock saved;
+
+        while( ! threadShouldExit() )
+        {
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+
+            if( ! saved.isEmpty() && random.nextInt(4) == 0 )
+                processor.setStateInformation(saved.getData(), (int) saved.getSize());
+
+            if( random.nextInt(8) == 0 )
+                saved = state;
+
+            ++numCalls;
+            wait(random.nextInt(10));
+        }
+    }
+
+    std::atomic<juce::int64> numCalls { 0 };
+
+private:
+    SimpleDualFilterAudioProcessor& processor;
+    juce::Random random;
+};
+
+//==============================================================================
+class StressThread : public juce::Thread
+{
+public:
+    explicit StressThread(const StressOptions& stressOptions)
+        : juce::Thread("Audio"), options(stressOptions), random(stressOptions.seed)
+    {
+        for( auto* param : processor.getParameters() )
+            if( auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param) )
+                parameters.add(ranged);
+    }
+
+    ~StressThread() override
+    {
+        stopThread(10000);
+    }
+
+    void run() override
+    {
+        StateThread stateThread(processor, options.seed + 1);
+        stateThread.startThread();
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        auto lastReport = start;
+
+        while( ! threadShouldExit() && ! shouldQuit
+               && juce::Time::getMillisecondCounterHiRes() - start < options.seconds * 1000.0 )
+        {
+            startSession();
+
+            for( juce::int64 sessionSamples = 0; sessionSamples < juce::int64(options.sessionSeconds * sampleRate); )
+            {
+                sessionSamples += juce::jmax(1, processCallback());
+
+                auto now = juce::Time::getMillisecondCounterHiRes();
+
+                if( now - lastReport > 10000.0 )
+                {
+                    report(now - start, stateThread.numCalls.load());
+                    lastReport = now;
+                }
+
+                if( threadShouldExit() || shouldQuit )
+                    break;
+            }
+
+            processor.releaseResources();
+        }
+
+        stateThread.stopThread(2000);
+        report(juce::Time::getMillisecondCounterHiRes() - start, stateThread.numCalls.load());
+    }
+
+    int getNumLateCallbacks() const noexcept { return numLateCallbacks; }
+
+private:
+    StressOptions options;
+    juce::Random random;
+
+    SimpleDualFilterAudioProcessor processor;
+    juce::Array<juce::RangedAudioParameter*> parameters;
+
+    double sampleRate { 48000.0 };
+    int maxBlockSize { 512 };
+
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+
+    DurationHistogram histogram;
+    int numLateCallbacks { 0 };
+
+    void startSession()
+    {
+        constexpr double sampleRates[] { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+        constexpr InternalBlockMode blockModes[] { InternalBlockMode::off, InternalBlockMode::zeroLatency, InternalBlockMode::buffered };
+
+        sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        maxBlockSize = 1 << random.nextInt({ 5, 13 });
+
+        // Block mode, peak engine and offline changes all take effect at prepareToPlay, like in a host
+        processor.setInternalBlockMode(blockModes[random.nextInt(3)], 1 << random.nextInt({ 5, 12 }));
+        processor.setPeakEngine(random.nextBool() ? PeakEngine::parallel : PeakEngine::serial);
+        processor.setNonRealtime(random.nextInt(4) == 0);
+
+        processor.setPlayConfigDetails(2, 2, sampleRate, maxBlockSize);
+        processor.prepareToPlay(sampleRate, maxBlockSize);
+
+        buffer.setSize(2, maxBlockSize);
+    }
+
+    int getRandomBlockSize()
+    {
+        // Mostly the host's block size, sometimes a split block, rarely an empty one
+        switch( random.nextInt(16) )
+        {
+            case 0:  return 0;
+            case 1:
+            case 2:  return 1;
+            case 3:
+            case 4:
+            case 5:
+            case 6:  return random.nextInt({ 1, maxBlockSize + 1 });
+            default: return maxBlockSize;
+        }
+    }
+
+    void automateParameters()
+    {
+        // Every parameter moves at every callback, so with single-sample blocks the
+        // automation runs at audio rate. Choices switch less often than they move.
+        for( auto* param : parameters )
+        {
+            auto isChoice = dynamic_cast<juce::AudioParameterChoice*>(param) != nullptr;
+
+            if( ! isChoice || random.nextInt(64) == 0 )
+                param->setValueNotifyingHost(random.nextFloat());
+        }
+    }
+
+    int processCallback()
+    {
+        auto numSamples = getRandomBlockSize();
+
+        automateParameters();
+
+        buffer.setSize(2, numSamples, false, false, true);
+
+        for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+            for( int i = 0; i < numSamples; ++i )
+                buffer.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+        auto microseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+
+        histogram.add(microseconds);
+
+        auto deadline = options.deadlineMicroseconds > 0.0 ? options.deadlineMicroseconds
+                                                           : options.deadlineRatio * 1.0e6 * juce::jmax(1, numSamples) / sampleRate;
+
+        if( microseconds > deadline )
+        {
+            ++numLateCallbacks;
+
+            std::printf("LATE %10.1f us > %8.1f us: %g Hz, %d samples, %d bands, %s, %s\n",
+                        microseconds, deadline, sampleRate, numSamples,
+                        getChainSettings(processor.apvts).numPeaks, getRenderQualityName(),
+                        processor.getPeakEngine() == PeakEngine::parallel ? "parallel" : "serial");
+        }
+
+        for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+            for( int i = 0; i < numSamples; ++i )
+                jassert(std::isfinite(buffer.getSample(ch, i)));
+
+        return numSamples;
+    }
+
+    const char* getRenderQualityName() const
+    {
+        switch( processor.getRenderQuality() )
+        {
+            case RenderQuality::light: return "light";
+            case RenderQuality::high:  return "high";
+            case RenderQuality::standard:
+            default:                   return "standard";
+        }
+    }
+
+    void report(double elapsedMilliseconds, juce::int64 numStateCalls)
+    {
+        std::printf("%8.0f s: %llu callbacks, %lld state calls, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us, %d late\n",
+                    elapsedMilliseconds / 1000.0, (unsigned long long) histogram.getCount(), (long long) numStateCalls,
+                    histogram.getPercentile(50.0), histogram.getPercentile(99.0), histogram.getPercentile(99.9),
+                    histogram.getMaximum(), numLateCallbacks);
+        std::fflush(stdout);
+    }
+};
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // The parameter tree needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    StressOptions options;
+
+    auto readOption = [&args](const char* name, double defaultValue)
+    {
+        return args.containsOption(name) ? args.getValueForOption(name).getDoubleValue() : defaultValue;
+    };
+
+    options.seconds = readOption("--seconds", options.seconds);
+    options.deadlineMicroseconds = readOption("--deadline-us", options.deadlineMicroseconds);
+    options.deadlineRatio = readOption("--deadline-ratio", options.deadlineRatio);
+    options.sessionSeconds = juce::jmax(0.1, readOption("--session-seconds", options.sessionSeconds));
+    options.seed = (juce::int64) readOption("--seed", 0.0);
+
+    if( options.seed == 0 )
+        options.seed = juce::Time::currentTimeMillis();
+
+    std::printf("seed %lld\n", (long long) options.seed);
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    StressThread stressThread(options);
+    stressThread.startThread(juce::Thread::Priority::highest);
+
+    while( stressThread.isThreadRunning() )
+        juce::Thread::sleep(100);
+
+    return stressThread.getNumLateCallbacks() == 0 ? 0 : 1;
+}
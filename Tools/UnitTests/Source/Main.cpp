@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the unit tests of the filter's DSP, every instruction set variant the
+    CPU supports included, and exits with 1 if any of them failed, so a build
+    script or CI job can run it after building.
+
+        SimpleDualFilterUnitTests [--test NAME]
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    juce::Array<juce::UnitTest*> tests;
+
+    for( auto* test : juce::UnitTest::getTestsInCategory(testCategory) )
+        if( ! args.containsOption("--test") || test->getName() == args.getValueForOption("--test") )
+            tests.add(test);
+
+    if( tests.isEmpty() )
+    {
+        std::printf("no test named %s\n", args.getValueForOption("--test").toRawUTF8());
+        return 1;
+    }
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTests(tests);
+
+    int numPasses = 0, numFailures = 0;
+
+    for( int i = 0; i < runner.getNumResults(); ++i )
+    {
+        numPasses += runner.getResult(i)->passes;
+        numFailures += runner.getResult(i)->failures;
+    }
+
+    std::printf("%d passed, %d failed\n", numPasses, numFailures);
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    MatchedPeakDesignTests.cpp
+
+    Checks makeMatchedPeakCoefficients against the analog peak: stable, within
+    a decibel over the audio band for centre frequencies up to a quarter of the
+    sample rate, and exact at DC, at the centre frequency and at Nyquist.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+#include "../../../Source/FilterResponse.h"
+
+class MatchedPeakDesignTests : public juce::UnitTest
+{
+public:
+    MatchedPeakDesignTests() : juce::UnitTest("Matched peak design", testCategory) {}
+
+    void runTest() override
+    {
+        for( auto sampleRate : { 44100.0, 48000.0, 96000.0 } )
+        {
+            beginTest("Against the analog peak at " + juce::String(sampleRate) + " Hz");
+            expectMatchesAnalogPeak(sampleRate);
+        }
+    }
+
+private:
+    static constexpr double toleranceInDecibels = 1.0;
+    static constexpr double matchToleranceInDecibels = 0.01;
+
+    void expectMatchesAnalogPeak(double sampleRate)
+    {
+        constexpr int numPoints = 512;
+
+        auto toDecibels = [](double magnitude) { return 20.0 * std::log10(magnitude); };
+
+        // Log spaced from 20 Hz to just below Nyquist, then the three match points
+        std::array<double, numPoints + 3> frequencies, magnitudes;
+        auto nyquist = 0.5 * sampleRate;
+
+        for( int i = 0; i < numPoints; ++i )
+            frequencies[(size_t) i] = 20.0 * std::pow(0.999 * nyquist / 20.0, double(i) / double(numPoints - 1));
+
+        bool allStable = true;
+        double error = 0.0, matchError = 0.0;
+
+        for( auto centre : { 100.0, 1000.0, 5000.0, 0.25 * sampleRate } )
+            for( auto quality : { 0.1, 0.5, 1.0, 4.0, 10.0 } )
+                for( auto gainInDecibels : { -24.0, -12.0, -3.0, 3.0, 12.0, 24.0 } )
+                {
+                    auto gainFactor = std::pow(10.0, gainInDecibels / 20.0);
+                    auto c = makeMatchedPeakCoefficients<double>(sampleRate, centre, quality, gainFactor);
+
+                    allStable = allStable && std::abs(c.a2) < 1.0 && std::abs(c.a1) < 1.0 + c.a2;
+
+                    frequencies[numPoints] = 0.0;
+                    frequencies[numPoints + 1] = centre;
+                    frequencies[numPoints + 2] = nyquist;
+
+                    computeCascadeResponse(&c, 1, 1.0, sampleRate, frequencies.data(), (int) frequencies.size(),
+                                           magnitudes.data(), nullptr, nullptr);
+
+                    for( size_t i = 0; i < frequencies.size(); ++i )
+                    {
+                        auto analog = frequencies[i] > 0.0 ? getAnalogPeakMagnitude(frequencies[i], centre, quality, gainFactor) : 1.0;
+                        auto difference = std::abs(toDecibels(magnitudes[i]) - toDecibels(analog));
+
+                        auto& worst = i < (size_t) numPoints ? error : matchError;
+                        worst = getWorseError(worst, difference);
+                    }
+                }
+
+        expect(allStable, "Poles outside the unit circle");
+        expectLessOrEqual(error, toleranceInDecibels, "Audio band, dB");
+        expectLessOrEqual(matchError, matchToleranceInDecibels, "DC, centre and Nyquist, dB");
+    }
+};
+
+static MatchedPeakDesignTests matchedPeakDesignTests;
@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    MorphChainTests.cpp
+
+    Checks that the morph core reproduces the bilinear peak at MORPH 0 and its
+    own biquad equivalent at every other position, that hand-overs between the
+    peak and morph cores continue the signal, and runs every supported kernel
+    variant through moving morph positions against a double precision chain.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+#include "../../../Source/MorphChain.h"
+
+class MorphChainTests : public juce::UnitTest
+{
+public:
+    MorphChainTests() : juce::UnitTest("Morph chains", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("Design at MORPH 0 and the biquad equivalent");
+        expectDesignMatches();
+
+        beginTest("Hand-over between the peak and morph cores");
+        expectLessOrEqual(getHandOverError<2>(), 1.0e-6, "2 bands");
+        expectLessOrEqual(getHandOverError<4>(), 1.0e-6, "4 bands");
+        expectLessOrEqual(getHandOverError<8>(), 1.0e-6, "8 bands");
+
+        for( auto kernel : getSupportedPeakKernels() )
+        {
+            beginTest(getPeakKernelName(kernel) + " morph kernel against the double precision chain");
+
+            expectLessOrEqual(getErrorAgainstReference<2>(kernel), double(tolerance), "2 bands");
+            expectLessOrEqual(getErrorAgainstReference<4>(kernel), double(tolerance), "4 bands");
+            expectLessOrEqual(getErrorAgainstReference<8>(kernel), double(tolerance), "8 bands");
+        }
+    }
+
+private:
+    static constexpr float tolerance = 1.0e-4f;
+
+    void expectDesignMatches()
+    {
+        constexpr double sampleRate = 48000.0;
+
+        auto getDifference = [](const BiquadCoefficients<double>& a, const BiquadCoefficients<double>& b)
+        {
+            auto difference = std::abs(a.b0 - b.b0) + std::abs(a.b1 - b.b1) + std::abs(a.b2 - b.b2)
+                            + std::abs(a.a1 - b.a1) + std::abs(a.a2 - b.a2);
+            auto scale = std::abs(b.b0) + std::abs(b.b1) + std::abs(b.b2) + 1.0;
+
+            return difference / scale;
+        };
+
+        double peakError = 0.0, equivalentError = 0.0;
+
+        for( auto freq : { 20.0, 250.0, 2000.0, 12000.0, 23000.0 } )
+            for( auto quality : { 0.1, 1.0, 10.0 } )
+                for( auto gainInDecibels : { -24.0, -6.0, 0.0, 12.0, 24.0 } )
+                {
+                    auto gainFactor = std::pow(10.0, gainInDecibels / 20.0);
+
+                    // MORPH 0 is the bilinear peak, so moving off it starts from the same response
+                    peakError = getWorseError(peakError, getDifference(BiquadCoefficients<double>(makeMorphCoefficients<double>(sampleRate, freq, quality, gainFactor, 0.0)),
+                                                                  makePeakCoefficients<double>(sampleRate, freq, quality, gainFactor)));
+
+                    // The biquad equivalent, which the response curve draws, converts back to the same core
+                    for( int step = 1; step <= 8; ++step )
+                    {
+                        auto core = makeMorphCoefficients<double>(sampleRate, freq, quality, gainFactor, 0.5 * step);
+                        auto biquad = BiquadCoefficients<double>(core);
+
+                        equivalentError = getWorseError(equivalentError, getDifference(BiquadCoefficients<double>(SvfCoefficients<double>(biquad)), biquad));
+                    }
+                }
+
+        expectLessOrEqual(peakError, 1.0e-9, "MORPH 0 against the bilinear peak");
+        expectLessOrEqual(equivalentError, 1.0e-9, "Core through its biquad equivalent and back");
+    }
+
+    // A peak cascade that hands over to the morph core and back without changing its design
+    // must run on exactly like one that never switched
+    template <int NumPeaks>
+    static double getHandOverError()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 64;
+        constexpr int numBlocks = 48;
+
+        PeakChain<NumPeaks, double> reference, peak;
+        MorphChain<NumPeaks, double> morph;
+
+        ChainSettings settings;
+        settings.peak1Freq = 150.f;
+        settings.peak1GainInDecibels = 8.f;
+        settings.peak1Quality = 2.f;
+        settings.span = 4.f;
+        settings.balance = -3.f;
+        settings.numPeaks = NumPeaks;
+
+        reference.updateCoefficients(settings, sampleRate);
+        peak.updateCoefficients(settings, sampleRate);
+
+        juce::Random random(0x43f);
+        juce::AudioBuffer<double> buffer(2, blockSize), expected(2, blockSize);
+        bool morphing = false;
+        double error = 0.0;
+
+        for( int block = 0; block < numBlocks; ++block )
+        {
+            if( block % 8 == 2 )
+            {
+                settings.peak1Freq *= 1.7f;
+                reference.setTarget(reference.makeCoefficients(settings, sampleRate), 0.5, blockSize);
+                peak.setTarget(peak.makeCoefficients(settings, sampleRate), 0.5, blockSize);
+            }
+
+            // The processor switches cores on control ticks, between ramps
+            if( block % 8 == 5 || block % 8 == 7 )
+            {
+                if( morphing )
+                    transferChainState(peak, morph);
+                else
+                    transferChainState(morph, peak);
+
+                morphing = ! morphing;
+            }
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    buffer.setSample(ch, i, random.nextDouble() * 2.0 - 1.0);
+
+            expected.makeCopyOf(buffer);
+
+            if( morphing )
+                morph.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+            else
+                peak.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+
+            reference.process(expected.getArrayOfWritePointers(), expected.getNumChannels(), blockSize);
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    error = getWorseError(error, std::abs(buffer.getSample(ch, i) - expected.getSample(ch, i))
+                                                / juce::jmax(1.0, std::abs(expected.getSample(ch, i))));
+        }
+
+        return error;
+    }
+
+    // The largest difference from the reference, relative to the block's level
+    template <int NumPeaks>
+    static double getErrorAgainstReference(PeakKernel kernel)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 64;
+        constexpr int numBlocks = 96;
+
+        MorphChain<NumPeaks> chain;
+        MorphChain<NumPeaks, double> reference;
+
+        chain.setProcessFunction(getMorphKernelFunction<NumPeaks, float>(kernel));
+
+        ChainSettings settings;
+        settings.peak1Freq = 300.f;
+        settings.peak1GainInDecibels = 6.f;
+        settings.peak1Quality = 1.5f;
+        settings.span = 3.f;
+        settings.balance = 2.f;
+        settings.numPeaks = NumPeaks;
+
+        chain.updateCoefficients(settings, sampleRate);
+        reference.updateCoefficients(settings, sampleRate);
+
+        juce::Random random(0x5f7);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::AudioBuffer<double> expected(2, blockSize);
+        double error = 0.0;
+
+        for( int block = 0; block < numBlocks; ++block )
+        {
+            // Sweep through every mode, ramping between the positions
+            settings.morph = float(block % 48) / 12.f;
+            settings.peak1Freq = 300.f * (1.f + 0.5f * std::sin(0.3f * float(block)));
+
+            auto targetGain = 0.25f + 0.5f * random.nextFloat();
+            chain.setTarget(chain.makeCoefficients(settings, sampleRate), targetGain, blockSize / 2);
+            reference.setTarget(reference.makeCoefficients(settings, sampleRate), targetGain, blockSize / 2);
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    buffer.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+            expected.makeCopyOf(buffer);
+
+            chain.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+            reference.process(expected.getArrayOfWritePointers(), expected.getNumChannels(), blockSize);
+
+            // Relative to the block's level: the single precision ramps round their increments,
+            // which shifts stacked resonances a little while they move
+            auto level = juce::jmax(1.0, expected.getMagnitude(0, blockSize));
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    error = getWorseError(error, std::abs(buffer.getSample(ch, i) - expected.getSample(ch, i)) / level);
+        }
+
+        return error;
+    }
+};
+
+static MorphChainTests morphChainTests;
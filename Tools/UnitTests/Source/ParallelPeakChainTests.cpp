@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    ParallelPeakChainTests.cpp
+
+    Checks the parallel expansion's response against the cascade's over a grid
+    of settings. Then runs every supported kernel variant and a serial chain
+    next to a double precision one, through ramps, settled stretches, a
+    hand-over to double precision and back, and random designs reached by
+    ramps and jumps. The parallel chain must not stray further from the double
+    precision output than the serial one does, give or take a tolerance
+    relative to the signal level.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+#include "../../../Source/ParallelPeakChain.h"
+
+// A serial and a parallel single precision chain next to the double precision cascade,
+// fed the same noise. The parallel form has to be about as accurate as the serial one.
+template <int NumPeaks>
+struct ParallelChainComparison
+{
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 64;
+
+    ParallelChainComparison(PeakKernel kernel, const ChainSettings& settings)
+    {
+        serial.setProcessFunction(getPeakKernelFunction<NumPeaks, float>(kernel));
+        parallel.setProcessFunctions(getParallelPeakKernelFunction<NumPeaks, float>(kernel), getPeakKernelFunction<NumPeaks, float>(kernel));
+
+        serial.updateCoefficients(settings, sampleRate);
+        parallel.updateCoefficients(settings, sampleRate);
+        reference.updateCoefficients(settings, sampleRate);
+
+        serial.setGainLinear(0.5f);
+        parallel.setGainLinear(0.5f);
+        reference.setGainLinear(0.5);
+    }
+
+    void setTarget(const ChainSettings& settings, float targetGain, int rampLength)
+    {
+        auto target = serial.makeCoefficients(settings, sampleRate);
+
+        serial.setTarget(target, targetGain, rampLength);
+        parallel.setTarget(target, targetGain, rampLength);
+        reference.setTarget(reference.makeCoefficients(settings, sampleRate), targetGain, rampLength);
+    }
+
+    void process(juce::Random& random)
+    {
+        for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+            for( int i = 0; i < blockSize; ++i )
+                buffer.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+        serialBuffer.makeCopyOf(buffer);
+        referenceBuffer.makeCopyOf(buffer);
+
+        serial.process(serialBuffer.getArrayOfWritePointers(), serialBuffer.getNumChannels(), blockSize);
+        parallel.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+        reference.process(referenceBuffer.getArrayOfWritePointers(), referenceBuffer.getNumChannels(), blockSize);
+
+        ranParallel = ranParallel || parallel.isParallel();
+
+        for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+            for( int i = 0; i < blockSize; ++i )
+            {
+                auto expected = referenceBuffer.getSample(ch, i);
+                auto scale = juce::jmax(1.0, std::abs(expected));
+
+                serialError = getWorseError(serialError, std::abs(serialBuffer.getSample(ch, i) - expected) / scale);
+                parallelError = getWorseError(parallelError, std::abs(buffer.getSample(ch, i) - expected) / scale);
+            }
+    }
+
+    PeakChain<NumPeaks> serial;
+    ParallelPeakChain<NumPeaks> parallel;
+    PeakChain<NumPeaks, double> reference;
+
+    juce::AudioBuffer<float> buffer { 2, blockSize }, serialBuffer { 2, blockSize };
+    juce::AudioBuffer<double> referenceBuffer { 2, blockSize };
+
+    double serialError = 0.0, parallelError = 0.0;
+    bool ranParallel = false;
+};
+
+//==============================================================================
+class ParallelPeakChainTests : public juce::UnitTest
+{
+public:
+    ParallelPeakChainTests() : juce::UnitTest("Parallel peak chains", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("Parallel expansion against the cascade");
+
+        expectExpansionMatches<2>();
+        expectExpansionMatches<4>();
+        expectExpansionMatches<8>();
+
+        for( auto kernel : getSupportedPeakKernels() )
+        {
+            beginTest(getPeakKernelName(kernel) + " parallel kernel against the serial chain");
+
+            expectAsAccurateAsSerial<2>(kernel);
+            expectAsAccurateAsSerial<4>(kernel);
+            expectAsAccurateAsSerial<8>(kernel);
+        }
+    }
+
+private:
+    static constexpr float tolerance = 1.0e-4f;
+
+    template <int NumPeaks>
+    void expectExpansionMatches()
+    {
+        constexpr double sampleRate = 48000.0;
+
+        int numExpanded = 0;
+        double error = 0.0;
+
+        for( auto freq : { 40.f, 300.f, 2000.f, 9000.f } )
+            for( auto gain : { -18.f, 0.f, 6.f, 15.f } )
+                for( auto quality : { 0.5f, 2.f, 8.f } )
+                    for( auto span : { 0.f, 0.5f, 3.f } )
+                        for( auto design : { PeakDesign::bilinear, PeakDesign::matched } )
+                        {
+                            ChainSettings settings;
+                            settings.peak1Freq = freq;
+                            settings.peak1GainInDecibels = gain;
+                            settings.peak1Quality = quality;
+                            settings.span = span;
+                            settings.balance = 3.f;
+                            settings.numPeaks = NumPeaks;
+                            settings.design = design;
+
+                            auto sections = PeakChain<NumPeaks, double>::makeCoefficients(settings, sampleRate);
+                            ParallelCoefficients<double, NumPeaks> expansion;
+
+                            if( ! ParallelForm::decompose<NumPeaks>(sections, expansion) )
+                                continue;
+
+                            ++numExpanded;
+
+                            // Denser than decompose's own check, which only looks at a few points
+                            for( int i = 0; i <= 256; ++i )
+                            {
+                                auto w = juce::MathConstants<double>::pi * std::pow(2.0, -12.0 * (1.0 - i / 256.0));
+                                auto z1 = std::polar(1.0, -w), z2 = z1 * z1;
+
+                                std::complex<double> cascade(1.0), parallel(expansion.direct);
+
+                                for( int k = 0; k < NumPeaks; ++k )
+                                {
+                                    auto& c = sections[(size_t) k];
+                                    auto a = 1.0 + c.a1 * z1 + c.a2 * z2;
+                                    cascade *= (c.b0 + c.b1 * z1 + c.b2 * z2) / a;
+                                    parallel += (expansion.b0[(size_t) k] + expansion.b1[(size_t) k] * z1)
+                                              / (1.0 + expansion.a1[(size_t) k] * z1 + expansion.a2[(size_t) k] * z2);
+                                }
+
+                                error = getWorseError(error, std::abs(parallel - cascade) / juce::jmax(1.0, std::abs(cascade)));
+                            }
+                        }
+
+        // Most of the grid has distinct poles, an engine that never expands anything is broken too
+        expectGreaterThan(numExpanded, 0, juce::String(NumPeaks) + " bands, designs expanded");
+        expectLessOrEqual(error, 1.0e-6, juce::String(NumPeaks) + " bands, relative error");
+    }
+
+    template <int NumPeaks>
+    void expectAsAccurateAsSerial(PeakKernel kernel)
+    {
+        constexpr int numBlocks = 96;
+        constexpr int blockSize = ParallelChainComparison<NumPeaks>::blockSize;
+
+        ChainSettings settings;
+        settings.peak1Freq = 200.f;
+        settings.peak1GainInDecibels = 9.f;
+        settings.peak1Quality = 3.f;
+        settings.span = 2.f;
+        settings.balance = -4.f;
+        settings.numPeaks = NumPeaks;
+
+        ParallelChainComparison<NumPeaks> sweep(kernel, settings);
+        PeakChain<NumPeaks, double> handOver;
+
+        juce::Random random(0x9a7);
+
+        for( int block = 0; block < numBlocks; ++block )
+        {
+            // Alternate ramps and settled stretches, so the chain switches forms in both
+            // directions. SPAN 0 has no expansion and keeps it serial for a while.
+            if( block % 16 < 6 )
+            {
+                settings.peak1Freq *= 1.1f;
+                settings.span = block % 32 < 16 ? 2.f : 0.f;
+
+                sweep.setTarget(settings, 0.25f + 0.5f * random.nextFloat(), blockSize / 2);
+            }
+
+            // Through double precision and back, like a switch to the high quality profile
+            if( block == numBlocks / 2 + 10 )
+            {
+                transferChainState(handOver, sweep.parallel);
+                transferChainState(sweep.parallel, handOver);
+            }
+
+            sweep.process(random);
+        }
+
+        // Random designs over the parameters' whole ranges with the bands below 18 kHz,
+        // reached by ramps and by jumps and held long enough to switch forms. Many of
+        // them can't hand their state back accurately and stay serial.
+        constexpr int numDesigns = 64;
+        constexpr int blocksPerDesign = 3;
+
+        ParallelChainComparison<NumPeaks> designs(kernel, settings);
+
+        for( int design = 0; design < numDesigns; ++design )
+        {
+            settings.peak1Freq = float(20.0 * std::pow(500.0, random.nextDouble()));
+            settings.peak1GainInDecibels = random.nextFloat() * 48.f - 24.f;
+            settings.peak1Quality = float(0.1 * std::pow(100.0, random.nextDouble()));
+            settings.span = juce::jmin(random.nextFloat() * 10.f, 2.f * (18000.f / settings.peak1Freq - 1.f));
+            settings.balance = random.nextFloat() * 24.f - 12.f;
+            settings.design = random.nextBool() ? PeakDesign::matched : PeakDesign::bilinear;
+
+            designs.setTarget(settings, 0.25f + 0.5f * random.nextFloat(), design % 2 == 0 ? blockSize / 2 : 0);
+
+            for( int block = 0; block < blocksPerDesign; ++block )
+                designs.process(random);
+        }
+
+        auto bands = juce::String(NumPeaks) + " bands";
+
+        expect(sweep.ranParallel || designs.ranParallel, bands + " never ran in parallel form");
+        expectLessOrEqual(sweep.parallelError, 1.5 * sweep.serialError + tolerance, bands + ", sweep");
+        expectLessOrEqual(designs.parallelError, 1.5 * designs.serialError + tolerance, bands + ", random designs");
+    }
+};
+
+static ParallelPeakChainTests parallelPeakChainTests;
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    PeakKernelTests.cpp
+
+    Runs every supported PeakChain variant over the same noise with moving
+    coefficients and compares the output against a cascade of
+    juce::dsp::IIR::Filter. FMA changes the rounding, so the match is within
+    a tolerance relative to the signal level rather than bit exact.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+
+class PeakKernelTests : public juce::UnitTest
+{
+public:
+    PeakKernelTests() : juce::UnitTest("Peak kernels", testCategory) {}
+
+    void runTest() override
+    {
+        for( auto kernel : getSupportedPeakKernels() )
+        {
+            beginTest(getPeakKernelName(kernel) + " kernel against juce::dsp::IIR::Filter");
+
+            expectLessOrEqual(getErrorAgainstReference<2>(kernel), tolerance, "2 bands");
+            expectLessOrEqual(getErrorAgainstReference<4>(kernel), tolerance, "4 bands");
+            expectLessOrEqual(getErrorAgainstReference<8>(kernel), tolerance, "8 bands");
+        }
+    }
+
+private:
+    static constexpr float tolerance = 1.0e-4f;
+
+    // The largest difference from the reference, relative to the signal level
+    template <int NumPeaks>
+    static float getErrorAgainstReference(PeakKernel kernel)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 64;
+        constexpr int numBlocks = 64;
+
+        using Filter = juce::dsp::IIR::Filter<float>;
+
+        PeakChain<NumPeaks> chain;
+        chain.setProcessFunction(getPeakKernelFunction<NumPeaks, float>(kernel));
+
+        // The reference: one juce::dsp::IIR::Filter per band and channel
+        std::array<std::array<Filter, PeakChain<NumPeaks>::maxChannels>, NumPeaks> reference;
+
+        for( auto& band : reference )
+            for( auto& filter : band )
+            {
+                filter.coefficients = new juce::dsp::IIR::Coefficients<float>(1.f, 0.f, 0.f, 1.f, 0.f, 0.f);
+                filter.reset();
+            }
+
+        ChainSettings settings;
+        settings.peak1Freq = 500.f;
+        settings.peak1GainInDecibels = 12.f;
+        settings.peak1Quality = 2.f;
+        settings.span = 3.f;
+        settings.balance = 4.f;
+
+        chain.updateCoefficients(settings, sampleRate);
+        chain.setGainLinear(0.5f);
+
+        juce::Random random(0x5df);
+        juce::AudioBuffer<float> buffer(2, blockSize), expected(2, blockSize);
+
+        float error = 0.f;
+
+        for( int block = 0; block < numBlocks; ++block )
+        {
+            // Sweep the settings so the ramp code runs as well, with the top band
+            // running into the clamp below Nyquist for the last blocks
+            settings.peak1Freq *= 1.05f;
+            settings.peak1GainInDecibels = -settings.peak1GainInDecibels;
+
+            auto start = chain.getCoefficients();
+            auto startGain = chain.getGainLinear();
+            auto target = chain.makeCoefficients(settings, sampleRate);
+            auto targetGain = 0.25f + 0.5f * random.nextFloat();
+            auto rampLength = blockSize / 2;
+
+            chain.setTarget(target, targetGain, rampLength);
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    buffer.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+            expected.makeCopyOf(buffer);
+
+            chain.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+
+            // The reference interpolates the coefficients itself, one sample at a time
+            for( int i = 0; i < blockSize; ++i )
+            {
+                auto t = i < rampLength ? float(i + 1) / float(rampLength) : 1.f;
+
+                for( int band = 0; band < NumPeaks; ++band )
+                {
+                    auto c = start[band] + (target[band] - start[band]) * t;
+
+                    for( auto& filter : reference[band] )
+                    {
+                        auto* raw = filter.coefficients->getRawCoefficients();
+                        raw[0] = c.b0; raw[1] = c.b1; raw[2] = c.b2; raw[3] = c.a1; raw[4] = c.a2;
+                    }
+                }
+
+                auto g = startGain + (targetGain - startGain) * t;
+
+                for( int ch = 0; ch < expected.getNumChannels(); ++ch )
+                {
+                    auto x = expected.getSample(ch, i);
+
+                    for( int band = 0; band < NumPeaks; ++band )
+                        x = reference[band][ch].processSample(x);
+
+                    expected.setSample(ch, i, g * x);
+                }
+            }
+
+            // Relative to the signal level, eight stacked boosts get loud
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                {
+                    auto expectedSample = expected.getSample(ch, i);
+                    error = getWorseError(error, std::abs(buffer.getSample(ch, i) - expectedSample) / juce::jmax(1.f, std::abs(expectedSample)));
+                }
+        }
+
+        return error;
+    }
+};
+
+static PeakKernelTests peakKernelTests;
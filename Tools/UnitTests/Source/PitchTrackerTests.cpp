@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    PitchTrackerTests.cpp
+
+    Checks that harmonic tones across the range are found within 1% at the
+    common sample rates, and that silence stays unvoiced.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+#include "../../../Source/PitchTracker.h"
+
+class PitchTrackerTests : public juce::UnitTest
+{
+public:
+    PitchTrackerTests() : juce::UnitTest("Pitch tracker", testCategory) {}
+
+    void runTest() override
+    {
+        for( auto sampleRate : { 44100.0, 48000.0, 96000.0 } )
+        {
+            beginTest("Harmonic tones at " + juce::String((int) sampleRate) + " Hz");
+
+            for( auto toneFrequency : { 55.0, 110.0, 220.0, 440.0, 880.0, 1200.0 } )
+                expectLessOrEqual(std::abs(findFrequency(toneFrequency, sampleRate) / toneFrequency - 1.0), 0.01,
+                                  juce::String((int) toneFrequency) + " Hz");
+
+            beginTest("Silence at " + juce::String((int) sampleRate) + " Hz");
+            expect(! findsPitchInSilence(sampleRate), "Silence gave a pitch");
+        }
+    }
+
+private:
+    static constexpr int blockSize = 256;
+    static constexpr double toneSeconds = 0.3;
+
+    static int getNumBlocks(double sampleRate)
+    {
+        return (int) std::ceil(toneSeconds * sampleRate / blockSize);
+    }
+
+    // Eight harmonics falling at 6 dB per octave, like a band-limited sawtooth
+    static double findFrequency(double toneFrequency, double sampleRate)
+    {
+        PitchTracker tracker;
+        tracker.prepare(sampleRate);
+
+        std::vector<float> block((size_t) blockSize);
+        float* channels[] { block.data() };
+
+        auto phaseIncrement = juce::MathConstants<double>::twoPi * toneFrequency / sampleRate;
+        double phase = 0.0;
+
+        for( int n = 0; n < getNumBlocks(sampleRate); ++n )
+        {
+            for( auto& sample : block )
+            {
+                double x = 0.0;
+
+                for( int harmonic = 1; harmonic <= 8; ++harmonic )
+                    x += std::sin(double(harmonic) * phase) / double(harmonic);
+
+                sample = float(0.25 * x);
+                phase = std::fmod(phase + phaseIncrement, juce::MathConstants<double>::twoPi);
+            }
+
+            tracker.push(channels, 1, blockSize);
+            tracker.analyse();
+        }
+
+        return double(tracker.getFrequency());
+    }
+
+    static bool findsPitchInSilence(double sampleRate)
+    {
+        PitchTracker tracker;
+        tracker.prepare(sampleRate);
+
+        std::vector<float> block((size_t) blockSize, 0.f);
+        float* channels[] { block.data() };
+
+        for( int n = 0; n < getNumBlocks(sampleRate); ++n )
+        {
+            tracker.push(channels, 1, blockSize);
+
+            if( tracker.analyse() )
+                return true;
+        }
+
+        return false;
+    }
+};
+
+static PitchTrackerTests pitchTrackerTests;
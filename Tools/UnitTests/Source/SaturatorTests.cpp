@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    SaturatorTests.cpp
+
+    Checks the closed form of the antiderivative quotient and runs every
+    supported saturator variant through ramped gains against a double
+    precision saturator.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+#include "../../../Source/Saturator.h"
+
+class SaturatorTests : public juce::UnitTest
+{
+public:
+    SaturatorTests() : juce::UnitTest("Saturators", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("Closed form against the antiderivative quotient");
+        expectLessOrEqual(getClosedFormError(), 1.0e-9);
+
+        for( auto kernel : getSupportedPeakKernels() )
+        {
+            beginTest(getPeakKernelName(kernel) + " saturator kernel against the double precision saturator");
+            expectLessOrEqual(getErrorAgainstReference(kernel), double(tolerance));
+        }
+    }
+
+private:
+    static constexpr float tolerance = 1.0e-5f;
+
+    // The closed form against (F(x) - F(x1)) / (x - x1) with F(x) = sqrt(1 + x^2),
+    // for pairs far enough apart that the quotient itself is well conditioned
+    static double getClosedFormError()
+    {
+        juce::Random random(0x5a7);
+        double error = 0.0;
+
+        for( int i = 0; i < 10000; ++i )
+        {
+            auto x1 = (random.nextDouble() * 2.0 - 1.0) * 20.0;
+            auto x = x1 + (random.nextBool() ? 1.0 : -1.0) * (0.01 + random.nextDouble() * 10.0);
+
+            auto r = std::sqrt(1.0 + x * x), r1 = std::sqrt(1.0 + x1 * x1);
+            auto quotient = (r - r1) / (x - x1);
+            auto closedForm = (x + x1) / (r + r1);
+
+            error = getWorseError(error, std::abs(closedForm - quotient));
+        }
+
+        return error;
+    }
+
+    // The curve's output is bounded by 1, so the error is absolute
+    static double getErrorAgainstReference(PeakKernel kernel)
+    {
+        constexpr int blockSize = 100;     // Not a multiple of Saturator::blockSize
+        constexpr int numBlocks = 64;
+
+        Saturator<float> saturator;
+        saturator.setProcessFunction(getSaturatorKernelFunction<float>(kernel));
+
+        Saturator<double> reference;
+
+        saturator.reset();
+        reference.reset();
+        saturator.setGainLinear(0.5f);
+        reference.setGainLinear(0.5);
+
+        juce::Random random(0x5a8);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::AudioBuffer<double> expected(2, blockSize);
+        double error = 0.0;
+
+        for( int block = 0; block < numBlocks; ++block )
+        {
+            auto targetGain = 0.25f + 0.5f * random.nextFloat();
+            auto rampLength = block % 3 == 0 ? 0 : blockSize / (block % 3);
+
+            saturator.setTarget(targetGain, rampLength);
+            reference.setTarget(double(targetGain), rampLength);
+
+            // Up to +24 dB into the curve, so it saturates hard
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                {
+                    auto x = (random.nextFloat() * 2.f - 1.f) * 16.f;
+                    buffer.setSample(ch, i, x);
+                    expected.setSample(ch, i, double(x));
+                }
+
+            saturator.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+            reference.process(expected.getArrayOfWritePointers(), expected.getNumChannels(), blockSize);
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    error = getWorseError(error, std::abs(double(buffer.getSample(ch, i)) - expected.getSample(ch, i)));
+        }
+
+        return error;
+    }
+};
+
+static SaturatorTests saturatorTests;
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    UnitTests.h
+
+    What the test classes share: their category, which Main.cpp runs, and
+    the instruction set variants to cover.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/PeakChain.h"
+
+// Every test registers in this category, Main.cpp runs it
+static constexpr const char* testCategory = "SimpleDualFilter";
+
+// The variants this CPU can run, the generic one always among them
+inline juce::Array<PeakKernel> getSupportedPeakKernels()
+{
+    juce::Array<PeakKernel> kernels;
+
+    for( auto kernel : { PeakKernel::generic, PeakKernel::avx2, PeakKernel::avx512 } )
+        if( isPeakKernelSupported(kernel) )
+            kernels.add(kernel);
+
+    return kernels;
+}
+
+// The larger of the two, with a NaN or infinite difference as infinitely wrong (jmax would drop a NaN)
+template <typename Type>
+Type getWorseError(Type error, Type difference)
+{
+    return std::isfinite(difference) ? juce::jmax(error, difference) : std::numeric_limits<Type>::infinity();
+}
+
+inline juce::String getPeakKernelName(PeakKernel kernel)
+{
+    switch( kernel )
+    {
+        case PeakKernel::avx2:    return "AVX2";
+        case PeakKernel::avx512:  return "AVX-512";
+        case PeakKernel::generic:
+        default:                  return "generic";
+    }
+}
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    VoiceBankTests.cpp
+
+    Checks that one Key Track voice at full level is exactly its dual peak,
+    and runs every supported voice bank variant with moving notes against a
+    double precision bank.
+
+  ==============================================================================
+*/
+
+#include "UnitTests.h"
+#include "../../../Source/VoiceBank.h"
+
+class VoiceBankTests : public juce::UnitTest
+{
+public:
+    VoiceBankTests() : juce::UnitTest("Voice banks", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("One voice against its dual peak");
+        expectVoiceIsDualPeak();
+
+        for( auto kernel : getSupportedPeakKernels() )
+        {
+            beginTest(getPeakKernelName(kernel) + " voice bank kernel against the double precision bank");
+            expectLessOrEqual(getErrorAgainstReference(kernel), double(tolerance));
+        }
+    }
+
+private:
+    static constexpr float tolerance = 1.0e-4f;
+
+    void expectVoiceIsDualPeak()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 256;
+        constexpr int note = 57;    // A3, 220 Hz
+
+        ChainSettings settings;
+        settings.peak1GainInDecibels = 9.f;
+        settings.peak1Quality = 2.f;
+        settings.span = 2.f;
+        settings.balance = 3.f;
+
+        // Held long enough for the attack to finish
+        VoicePool pool;
+        pool.noteOn(note, 1.f);
+
+        VoiceBankCoefficients<double> coefficients;
+
+        for( int i = 0; i < 8; ++i )
+            pool.design(settings, sampleRate, blockSize, coefficients);
+
+        using C = VoiceBankCoefficients<double>;
+        auto voice = std::find(coefficients[C::level].begin(), coefficients[C::level].end(), 1.0) - coefficients[C::level].begin();
+
+        expect(voice < maxKeyTrackVoices, "No voice at full level");
+
+        if( voice >= maxKeyTrackVoices )
+            return;
+
+        PeakChain<2, double>::CoefficientArray sections;
+        sections[0] = { coefficients[C::b0][(size_t) voice], coefficients[C::b1][(size_t) voice], coefficients[C::b2][(size_t) voice],
+                        coefficients[C::a1][(size_t) voice], coefficients[C::a2][(size_t) voice] };
+        sections[1] = { coefficients[C::secondB0][(size_t) voice], coefficients[C::secondB1][(size_t) voice], coefficients[C::secondB2][(size_t) voice],
+                        coefficients[C::secondA1][(size_t) voice], coefficients[C::secondA2][(size_t) voice] };
+
+        // The bilinear peaks hit GAIN -/+ BAL exactly at the note and at its third harmonic (SPAN 2)
+        auto toDecibels = [](double magnitude) { return 20.0 * std::log10(magnitude); };
+        auto frequency = VoicePool::getNoteFrequency(note);
+
+        expectWithinAbsoluteError(toDecibels(sections[0].getMagnitudeForFrequency(frequency, sampleRate)), 6.0, 1.0e-6, "First peak at the note, dB");
+        expectWithinAbsoluteError(toDecibels(sections[1].getMagnitudeForFrequency(3.0 * frequency, sampleRate)), 12.0, 1.0e-6, "Second peak at the third harmonic, dB");
+
+        // One voice at full level is its dual peak
+        VoiceBank<double> bank;
+        bank.setTarget(coefficients, 1.0, 0);
+
+        PeakChain<2, double> chain;
+        chain.setTarget(sections, 1.0, 0);
+
+        juce::Random random(0x5f8);
+        juce::AudioBuffer<double> buffer(2, blockSize), expected(2, blockSize);
+        double error = 0.0;
+
+        for( int block = 0; block < 8; ++block )
+        {
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    buffer.setSample(ch, i, random.nextDouble() * 2.0 - 1.0);
+
+            expected.makeCopyOf(buffer);
+
+            bank.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+            chain.process(expected.getArrayOfWritePointers(), expected.getNumChannels(), blockSize);
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    error = getWorseError(error, std::abs(buffer.getSample(ch, i) - expected.getSample(ch, i)));
+        }
+
+        expectLessOrEqual(error, 1.0e-9, "Bank against the dual peak");
+    }
+
+    // The largest difference from the reference, relative to the block's level like the morph chains
+    static double getErrorAgainstReference(PeakKernel kernel)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 64;
+        constexpr int numBlocks = 256;
+
+        VoiceBank<float> bank;
+        VoiceBank<double> reference;
+
+        bank.setProcessFunction(getVoiceBankKernelFunction<float>(kernel));
+
+        ChainSettings settings;
+        settings.peak1GainInDecibels = 12.f;
+        settings.peak1Quality = 4.f;
+        settings.span = 1.f;
+
+        VoicePool pool;
+        VoiceBankCoefficients<double> coefficients;
+
+        juce::Random random(0x5f9);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::AudioBuffer<double> expected(2, blockSize);
+        double error = 0.0;
+
+        for( int block = 0; block < numBlocks; ++block )
+        {
+            // More notes than voices, so some are stolen, and the settings move while they sound.
+            // From C3 up: below it the float rounding of these Q 4 poles alone reaches the tolerance.
+            if( random.nextInt(3) == 0 )
+                pool.noteOn(48 + random.nextInt(48), 0.25f + 0.75f * random.nextFloat());
+
+            if( random.nextInt(4) == 0 )
+                pool.noteOff(48 + random.nextInt(48));
+
+            if( block == numBlocks / 2 )
+                pool.allNotesOff();
+
+            settings.balance = 6.f * std::sin(0.05f * float(block));
+
+            pool.design(settings, sampleRate, blockSize, coefficients);
+
+            auto targetGain = 0.25f + 0.5f * random.nextFloat();
+            bank.setTarget(VoiceBankCoefficients<float>(coefficients), targetGain, blockSize / 2);
+            reference.setTarget(VoiceBankCoefficients<double>(VoiceBankCoefficients<float>(coefficients)), double(targetGain), blockSize / 2);
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    buffer.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+
+            expected.makeCopyOf(buffer);
+
+            bank.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), blockSize);
+            reference.process(expected.getArrayOfWritePointers(), expected.getNumChannels(), blockSize);
+
+            auto level = juce::jmax(1.0, expected.getMagnitude(0, blockSize));
+
+            for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    error = getWorseError(error, std::abs(buffer.getSample(ch, i) - expected.getSample(ch, i)) / level);
+        }
+
+        return error;
+    }
+};
+
+static VoiceBankTests voiceBankTests;